@@ -0,0 +1,299 @@
+"""Packs the actor sheets of a game into shared atlas pages.
+
+Every cell of every sheet is trimmed down to its visible pixels & packed on
+its own, so the runtime draws each portrait from a sub-rectangle of an atlas
+page instead of from its own sheet.
+The manifest layout must match `source/sigmoid/Atlas.hpp`.
+"""
+
+import json
+import struct
+import zlib
+from dataclasses import dataclass
+
+import scb
+from pngfile import PNGError, read_png, write_png
+
+MAGIC = b"ATL\x1a"
+VERSION = 2
+
+MANIFEST = "ATLAS.MAN"
+PAGE = "ATLAS{}.PNG"
+
+HEADER = struct.Struct("<4s9I")
+PAGE_RECORD = struct.Struct("<2I")
+SHEET = struct.Struct("<6I")
+CELL = struct.Struct("<8f")
+
+# Pixels around every cell, filled by extending its edges, so linear filtering
+# never samples a neighbouring cell.
+PADDING = 1
+# Transparent pixels kept around the visible ones of a trimmed cell, so its
+# edges blend out the same way they did before trimming.
+TRIM_MARGIN = 1
+
+class AtlasError(Exception):
+  pass
+
+# Packing -----------------------------------------------------------------
+
+class Skyline:
+  """Skyline bottom-left packer, the default heuristic of stb_rect_pack."""
+
+  def __init__(self, width: int, height: int):
+    self.width = width
+    self.height = height
+    self.nodes = [(0, 0)] # -> (x, y) of each skyline segment
+
+  def _fit(self, idx: int, width: int) -> int:
+    x = self.nodes[idx][0]
+    if x + width > self.width:
+      return -1
+    y = 0
+    end = x + width
+    while idx < len(self.nodes) and self.nodes[idx][0] < end:
+      y = max(y, self.nodes[idx][1])
+      idx += 1
+    return y
+
+  def _waste(self, idx: int, width: int, y: int) -> int:
+    x = self.nodes[idx][0]
+    end = x + width
+    waste = 0
+    while idx < len(self.nodes) and self.nodes[idx][0] < end:
+      left = self.nodes[idx][0]
+      right = self.nodes[idx + 1][0] if idx + 1 < len(self.nodes) else self.width
+      waste += (min(right, end) - left) * (y - self.nodes[idx][1])
+      idx += 1
+    return waste
+
+  def insert(self, width: int, height: int) -> tuple[int, int] | None:
+    best = None
+    for idx in range(len(self.nodes)):
+      y = self._fit(idx, width)
+      if y < 0 or y + height > self.height:
+        continue
+      score = (y, self._waste(idx, width, y))
+      if best is None or score < best[0]:
+        best = (score, idx)
+    if best is None:
+      return None
+
+    idx = best[1]
+    x = self.nodes[idx][0]
+    y = best[0][0]
+    end = x + width
+    # the segments under the new rect are replaced by its top edge, the one
+    # it ends in continues after it
+    after = idx
+    while after < len(self.nodes) and self.nodes[after][0] < end:
+      after += 1
+    tail = []
+    if end < self.width and (after == len(self.nodes) or self.nodes[after][0] != end):
+      tail = [(end, self.nodes[after - 1][1])]
+    self.nodes[idx:after] = [(x, y + height)] + tail
+    return x, y
+
+@dataclass
+class Cell:
+  """Visible part of a sheet cell. `left` & `top` are where it sits within the
+  untrimmed cell, which is `full_width` by `full_height` pixels."""
+  width: int
+  height: int
+  pixels: bytes
+  left: int
+  top: int
+  full_width: int
+  full_height: int
+
+  def empty(self) -> bool:
+    return self.width == 0 or self.height == 0
+
+class Page:
+  def __init__(self, size: int):
+    self.packer = Skyline(size, size)
+    self.cells: list[tuple[int, int, Cell]] = []
+    self.extent = (0, 0)
+
+  def place(self, cells: list[Cell]) -> list[tuple[int, int]] | None:
+    """Packs all of `cells` or none of them. Empty cells take no space."""
+    saved = list(self.packer.nodes)
+    order = sorted(range(len(cells)),
+                   key=lambda i: (-cells[i].height, -cells[i].width))
+    spots = [(0, 0)] * len(cells)
+    for i in order:
+      cell = cells[i]
+      if cell.empty():
+        continue
+      spot = self.packer.insert(cell.width + 2 * PADDING, cell.height + 2 * PADDING)
+      if spot is None:
+        self.packer.nodes = saved
+        return None
+      spots[i] = (spot[0] + PADDING, spot[1] + PADDING)
+    for cell, (x, y) in zip(cells, spots):
+      if cell.empty():
+        continue
+      self.cells.append((x, y, cell))
+      self.extent = (max(self.extent[0], x + cell.width + PADDING),
+                     max(self.extent[1], y + cell.height + PADDING))
+    return spots
+
+  def render(self) -> bytes:
+    width, height = self.extent
+    out = bytearray(width * height * 4)
+    for x, y, cell in self.cells:
+      src_stride = cell.width * 4
+      for row in range(-PADDING, cell.height + PADDING):
+        src_row = min(max(row, 0), cell.height - 1)
+        src = cell.pixels[src_row * src_stride:(src_row + 1) * src_stride]
+        line = src[:4] * PADDING + src + src[-4:] * PADDING
+        dst = ((y + row) * width + x - PADDING) * 4
+        out[dst:dst + len(line)] = line
+    return write_png(width, height, bytes(out))
+
+# Sheets ------------------------------------------------------------------
+
+def find_sheets(scenes: list[tuple[str, str]], warn) -> dict[str, tuple[int, int]]:
+  """Collects the sheet & grid of every actor in the given scene sources."""
+  sheets: dict[str, tuple[int, int]] = {}
+  for name, text in scenes:
+    try:
+      root = json.loads(text)
+    except json.JSONDecodeError:
+      continue # reported by the scene compiler
+    actors = root.get("actors") if isinstance(root, dict) else None
+    if not isinstance(actors, dict):
+      continue
+    for actor_id, actor in actors.items():
+      if not isinstance(actor, dict) or not actor.get("sheet"):
+        continue
+      size = actor.get("sheetSize")
+      if not isinstance(size, list) or len(size) != 2:
+        warn(f"Actor `{actor_id}` in `{name}` has no `sheetSize`.",
+             "Its sheet will not be atlased.")
+        continue
+      grid = (int(size[0]), int(size[1]))
+      sheet = str(actor["sheet"])
+      if sheets.setdefault(sheet, grid) != grid:
+        warn(f"Sheet `{sheet}` is used with different sizes.",
+             f"`{name}` will draw it from its own texture.")
+  return sheets
+
+def _trim(rgba: bytes, stride: int, left: int, top: int, width: int,
+          height: int) -> Cell:
+  """Cuts the cell at `left`, `top` out of the sheet, without the transparent
+  rows & columns around its visible pixels."""
+  min_x, min_y, max_x, max_y = width, height, -1, -1
+  for y in range(height):
+    start = (top + y) * stride + left * 4
+    alpha = rgba[start + 3:start + width * 4:4]
+    if not any(alpha):
+      continue
+    first = next(i for i, a in enumerate(alpha) if a)
+    last = width - 1 - next(i for i, a in enumerate(reversed(alpha)) if a)
+    min_x, max_x = min(min_x, first), max(max_x, last)
+    min_y, max_y = min(min_y, y), y
+  if max_y < 0:
+    return Cell(0, 0, b"", 0, 0, width, height)
+
+  min_x = max(min_x - TRIM_MARGIN, 0)
+  min_y = max(min_y - TRIM_MARGIN, 0)
+  max_x = min(max_x + TRIM_MARGIN, width - 1)
+  max_y = min(max_y + TRIM_MARGIN, height - 1)
+  pixels = bytearray()
+  for y in range(min_y, max_y + 1):
+    start = (top + y) * stride + (left + min_x) * 4
+    pixels += rgba[start:start + (max_x - min_x + 1) * 4]
+  return Cell(max_x - min_x + 1, max_y - min_y + 1, bytes(pixels),
+              min_x, min_y, width, height)
+
+def _cut(sheet: str, data: bytes, grid: tuple[int, int]) -> list[Cell]:
+  width, height, rgba = read_png(data)
+  columns, rows = grid
+  if columns <= 0 or rows <= 0 or width % columns != 0 or height % rows != 0:
+    raise AtlasError(f"{width}x{height} is not divisible into {columns}x{rows} cells.")
+  cell_w = width // columns
+  cell_h = height // rows
+  cells = []
+  for cell in range(columns * rows):
+    left = (cell % columns) * cell_w
+    top = (cell // columns) * cell_h
+    cells.append(_trim(rgba, width * 4, left, top, cell_w, cell_h))
+  if not cells:
+    raise AtlasError(f"Sheet `{sheet}` has no cells.")
+  return cells
+
+def build(sheets: dict[str, tuple[int, int]], read, page_size: int,
+          warn) -> dict[str, bytes]:
+  """Packs the sheets into pages. Returns the files to add to the bundle, the
+  manifest plus one PNG per page. Sheets which can't be packed are left out and
+  drawn from their own texture."""
+  cut = []
+  for sheet, grid in sheets.items():
+    try:
+      cells = _cut(sheet, read(sheet), grid)
+    except (OSError, AtlasError, PNGError, zlib.error) as e:
+      warn(f"Could not atlas sheet `{sheet}`: {e}",
+           "It will be drawn from its own texture.")
+      continue
+    cut.append((sheet, grid, cells))
+  # biggest sheets first, like the cells within a sheet
+  cut.sort(key=lambda entry: -sum(cell.width * cell.height for cell in entry[2]))
+
+  pages: list[Page] = []
+  placed = []
+  for sheet, grid, cells in cut:
+    for idx, page in enumerate(pages):
+      spots = page.place(cells)
+      if spots is not None:
+        break
+    else:
+      page = Page(page_size)
+      spots = page.place(cells)
+      if spots is None:
+        warn(f"Sheet `{sheet}` does not fit into a {page_size}x{page_size} atlas.",
+             "It will be drawn from its own texture.")
+        continue
+      pages.append(page)
+      idx = len(pages) - 1
+    placed.append((sheet, grid, idx, cells, spots))
+
+  if not placed:
+    return {}
+
+  pool = scb.StringPool()
+  page_blob = bytearray()
+  for idx in range(len(pages)):
+    page_blob += PAGE_RECORD.pack(*pool.add(PAGE.format(idx)))
+  sheet_blob = bytearray()
+  cell_blob = bytearray()
+  cell_count = 0
+  for sheet, grid, idx, cells, spots in placed:
+    sheet_blob += SHEET.pack(*pool.add(sheet), idx, cell_count, len(cells), grid[0])
+    width, height = pages[idx].extent
+    for cell, (x, y) in zip(cells, spots):
+      cell_blob += CELL.pack(
+        x / width, y / height, cell.width / width, cell.height / height,
+        cell.left / cell.full_width, cell.top / cell.full_height,
+        cell.width / cell.full_width, cell.height / cell.full_height)
+    cell_count += len(cells)
+
+  out = bytearray(HEADER.size)
+  page_offset = len(out)
+  out += page_blob
+  sheet_offset = len(out)
+  out += sheet_blob
+  cell_offset = len(out)
+  out += cell_blob
+  strings_offset = len(out)
+  out += pool.data
+  HEADER.pack_into(out, 0, MAGIC, VERSION,
+    len(pages), page_offset,
+    len(placed), sheet_offset,
+    cell_count, cell_offset,
+    strings_offset, len(pool.data))
+
+  files = {MANIFEST: bytes(out)}
+  for idx, page in enumerate(pages):
+    files[PAGE.format(idx)] = page.render()
+  return files
@@ -1,9 +1,26 @@
 """Plugin to automatically pack bundles"""
 
+import json
+import shutil
+import sys
+import zlib
+
 import bip
 
+sys.path.insert(0, str(bip.Path(__file__).resolve().parent))
+import atlas # pylint: disable=wrong-import-position
+import scb # pylint: disable=wrong-import-position
+import texture # pylint: disable=wrong-import-position
+from pngfile import PNGError # pylint: disable=wrong-import-position
+
 g_src: bip.Path
 g_out: bip.Path
+g_cook: bip.Path
+g_compile_scenes: bool
+g_atlas: bool
+g_atlas_size: int
+g_cook_images: bool
+g_image_mips: bool
 
 def configure(settings: dict) -> bool:
   if "src" not in settings:
@@ -19,9 +36,21 @@ def configure(settings: dict) -> bool:
   global g_src
   global g_out
   global g_exe
+  global g_cook
+  global g_compile_scenes
+  global g_atlas
+  global g_atlas_size
+  global g_cook_images
+  global g_image_mips
 
   g_src = bip.Path(settings["src"]).resolve()
   g_out = bip.Path(settings["out"]).resolve()
+  g_cook = g_out.with_suffix(".cook")
+  g_compile_scenes = settings.get("compile-scenes", True)
+  g_atlas = settings.get("atlas", True)
+  g_atlas_size = int(settings.get("atlas-size", 2048))
+  g_cook_images = settings.get("cook-images", False)
+  g_image_mips = settings.get("image-mips", False)
 
   if not g_out.parent.exists():
     g_out.parent.mkdir(parents=True)
@@ -36,6 +65,8 @@ def configure(settings: dict) -> bool:
 def clean() -> bool:
   if g_out.exists():
     g_out.unlink()
+  if g_cook.exists():
+    shutil.rmtree(g_cook)
   return True
 
 def want_run() -> bool:
@@ -49,8 +80,94 @@ def want_run() -> bool:
       return True
   return False
 
+def compile_scene(src: bip.Path, dst: bip.Path):
+  """Writes the compiled form of a scene under the scene's own name. Scenes
+  which fail to compile are bundled as-is, the engine reports the error when
+  loading them."""
+  try:
+    compiled = scb.compile_scene(src.read_text(encoding="utf-8"))
+  except scb.CompileError as e:
+    bip.err(f"Could not compile scene `{src.name}`: {e}",
+             "It will be bundled uncompiled.")
+    shutil.copy2(src, dst)
+    return
+  dst.write_bytes(compiled)
+
+def pack_atlas():
+  """Packs the actor sheets of every scene into atlas pages and points the
+  cooked GAME.INFO at their manifest. The sheets themselves stay in the bundle
+  for sheets the atlas could not take."""
+  scenes = [(f.name, f.read_text(encoding="utf-8"))
+            for f in sorted(g_src.iterdir()) if f.suffix.upper() == ".SCN"]
+  sheets = atlas.find_sheets(scenes, bip.err)
+  if not sheets:
+    return
+  files = atlas.build(sheets, lambda name: (g_src / name).read_bytes(),
+                      g_atlas_size, bip.err)
+  if not files:
+    return
+  for name, data in files.items():
+    if (g_src / name).exists():
+      bip.err(f"`{name}` is replaced by the generated atlas.",
+               "Rename it, or disable the atlas via the 'atlas' key.")
+    (g_cook / name).write_bytes(data)
+
+  info = g_cook / "GAME.INFO"
+  if not info.exists():
+    return
+  try:
+    root = json.loads(info.read_text(encoding="utf-8"))
+  except json.JSONDecodeError:
+    return # reported by the engine
+  root["atlas"] = atlas.MANIFEST
+  info.write_text(json.dumps(root, indent=2), encoding="utf-8")
+
+def cook_images():
+  """Replaces the cooked copies of backgrounds & menu graphics with textures
+  the engine uploads without decoding."""
+  info = g_src / "GAME.INFO"
+  scenes = [f.read_text(encoding="utf-8")
+            for f in g_src.iterdir() if f.suffix.upper() == ".SCN"]
+  images = texture.find_images(
+    info.read_text(encoding="utf-8") if info.exists() else "", scenes)
+  for name in sorted(images):
+    src = g_src / name
+    if not src.exists():
+      continue # reported by the engine
+    try:
+      cooked = texture.cook(src.read_bytes(), g_image_mips)
+    except (PNGError, zlib.error) as e:
+      bip.err(f"Could not cook image `{name}`: {e}",
+               "It will be bundled as-is.")
+      continue
+    (g_cook / name).write_bytes(cooked)
+
+def cook() -> bool:
+  """Copies the sources into the cook directory, compiling scenes, packing the
+  atlas & cooking images along the way as enabled."""
+  if g_cook.exists():
+    shutil.rmtree(g_cook)
+  g_cook.mkdir(parents=True)
+  for srcfile in g_src.iterdir():
+    dstfile = g_cook / srcfile.name
+    if g_compile_scenes and srcfile.suffix.upper() == ".SCN":
+      compile_scene(srcfile, dstfile)
+    else:
+      shutil.copy2(srcfile, dstfile)
+  if g_atlas:
+    pack_atlas()
+  if g_cook_images:
+    cook_images()
+  return True
+
 def run() -> bool:
-  if not bip.cmd("nwgebndl", ["create", f"{g_src}", f"{g_out}"]):
+  src = g_src
+  if g_compile_scenes or g_atlas or g_cook_images:
+    if not cook():
+      return False
+    src = g_cook
+
+  if not bip.cmd("nwgebndl", ["create", f"{src}", f"{g_out}"]):
     return False
 
   return True
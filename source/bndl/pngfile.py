@@ -0,0 +1,167 @@
+"""Minimal PNG reader & writer for cooking images."""
+
+import struct
+import zlib
+
+class PNGError(Exception):
+  pass
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+# x, y, dx, dy of each pass
+ADAM7 = ((0, 0, 8, 8), (4, 0, 8, 8), (0, 4, 4, 8), (2, 0, 4, 4),
+         (0, 2, 2, 4), (1, 0, 2, 2), (0, 1, 1, 2))
+
+def _unfilter(raw: bytes, width: int, height: int, bpp: int,
+              stride: int) -> list[bytearray]:
+  rows = []
+  prev = bytearray(stride)
+  for y in range(height):
+    start = y * (stride + 1)
+    kind = raw[start]
+    row = bytearray(raw[start + 1:start + 1 + stride])
+    if kind == 1:
+      for i in range(bpp, stride):
+        row[i] = (row[i] + row[i - bpp]) & 0xFF
+    elif kind == 2:
+      row = bytearray((a + b) & 0xFF for a, b in zip(row, prev))
+    elif kind == 3:
+      for i in range(stride):
+        left = row[i - bpp] if i >= bpp else 0
+        row[i] = (row[i] + ((left + prev[i]) >> 1)) & 0xFF
+    elif kind == 4:
+      for i in range(stride):
+        a = row[i - bpp] if i >= bpp else 0
+        b = prev[i]
+        c = prev[i - bpp] if i >= bpp else 0
+        p = a + b - c
+        pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+        pred = a if pa <= pb and pa <= pc else b if pb <= pc else c
+        row[i] = (row[i] + pred) & 0xFF
+    elif kind != 0:
+      raise PNGError(f"Invalid filter type {kind}.")
+    rows.append(row)
+    prev = row
+  return rows
+
+def _samples(row: bytearray, count: int, depth: int) -> list[int]:
+  if depth == 8:
+    return list(row[:count])
+  if depth == 16:
+    return [row[i * 2] for i in range(count)]
+  per_byte = 8 // depth
+  mask = (1 << depth) - 1
+  out = []
+  for i in range(count):
+    shift = 8 - depth - (i % per_byte) * depth
+    out.append((row[i // per_byte] >> shift) & mask)
+  return out
+
+def read_png(data: bytes) -> tuple[int, int, bytearray]:
+  """Decodes a PNG into RGBA8 rows from top to bottom."""
+  if not data.startswith(PNG_SIGNATURE):
+    raise PNGError("Not a PNG file.")
+  off = len(PNG_SIGNATURE)
+  idat = bytearray()
+  palette = b""
+  trns = None
+  header = None
+  while off + 8 <= len(data):
+    size, kind = struct.unpack_from(">I4s", data, off)
+    chunk = data[off + 8:off + 8 + size]
+    off += 12 + size
+    if kind == b"IHDR":
+      header = struct.unpack(">2I5B", chunk)
+    elif kind == b"PLTE":
+      palette = chunk
+    elif kind == b"tRNS":
+      trns = chunk
+    elif kind == b"IDAT":
+      idat += chunk
+    elif kind == b"IEND":
+      break
+  if header is None:
+    raise PNGError("Missing IHDR chunk.")
+  width, height, depth, color, _, _, interlace = header
+  if color not in CHANNELS:
+    raise PNGError(f"Invalid color type {color}.")
+  if interlace not in (0, 1):
+    raise PNGError(f"Invalid interlace method {interlace}.")
+
+  channels = CHANNELS[color]
+  bpp = max(1, channels * depth // 8)
+  raw = zlib.decompress(bytes(idat))
+  if interlace == 0:
+    stride = (width * channels * depth + 7) // 8
+    rows = _unfilter(raw, width, height, bpp, stride)
+    return width, height, _to_rgba(rows, width, depth, color, palette, trns)
+
+  # Adam7: each pass is filtered on its own & covers every few pixels
+  out = bytearray(width * height * 4)
+  off = 0
+  for x0, y0, dx, dy in ADAM7:
+    pass_width = (width - x0 + dx - 1) // dx if width > x0 else 0
+    pass_height = (height - y0 + dy - 1) // dy if height > y0 else 0
+    if pass_width == 0 or pass_height == 0:
+      continue
+    stride = (pass_width * channels * depth + 7) // 8
+    size = pass_height * (stride + 1)
+    rows = _unfilter(raw[off:off + size], pass_width, pass_height, bpp, stride)
+    off += size
+    pixels = _to_rgba(rows, pass_width, depth, color, palette, trns)
+    for y in range(pass_height):
+      for x in range(pass_width):
+        src = (y * pass_width + x) * 4
+        dst = ((y0 + y * dy) * width + x0 + x * dx) * 4
+        out[dst:dst + 4] = pixels[src:src + 4]
+  return width, height, out
+
+def _to_rgba(rows: list[bytearray], width: int, depth: int, color: int,
+             palette: bytes, trns: bytes | None) -> bytearray:
+  channels = CHANNELS[color]
+  scale = {1: 255, 2: 85, 4: 17, 8: 1, 16: 1}[depth]
+  key = None
+  if trns is not None and color in (0, 2):
+    wide = struct.unpack(f">{len(trns) // 2}H", trns)
+    key = tuple(v if depth == 16 else v & 0xFF for v in wide)
+  out = bytearray()
+  for row in rows:
+    if color == 3:
+      for i in _samples(row, width, depth):
+        alpha = trns[i] if trns is not None and i < len(trns) else 255
+        out += palette[i * 3:i * 3 + 3] + bytes((alpha,))
+      continue
+    if depth == 16:
+      wide = struct.unpack(f">{width * channels}H", row)
+      values = [v >> 8 for v in wide]
+    else:
+      wide = _samples(row, width * channels, depth)
+      values = [v * scale for v in wide]
+    for x in range(width):
+      px = values[x * channels:(x + 1) * channels]
+      raw = tuple(wide[x * channels:(x + 1) * channels])
+      if color == 0:
+        out += bytes((px[0], px[0], px[0], 0 if raw == key else 255))
+      elif color == 2:
+        out += bytes((*px, 0 if raw == key else 255))
+      elif color == 4:
+        out += bytes((px[0], px[0], px[0], px[1]))
+      else:
+        out += bytes(px)
+  return out
+
+def write_png(width: int, height: int, rgba: bytes) -> bytes:
+  """Encodes RGBA8 rows as a PNG."""
+  def chunk(kind: bytes, body: bytes) -> bytes:
+    crc = zlib.crc32(kind + body) & 0xFFFFFFFF
+    return struct.pack(">I", len(body)) + kind + body + struct.pack(">I", crc)
+
+  stride = width * 4
+  raw = bytearray()
+  for y in range(height):
+    raw.append(0)
+    raw += rgba[y * stride:(y + 1) * stride]
+  return (PNG_SIGNATURE
+    + chunk(b"IHDR", struct.pack(">2I5B", width, height, 8, 6, 0, 0, 0))
+    + chunk(b"IDAT", zlib.compress(bytes(raw), 9))
+    + chunk(b"IEND", b""))
@@ -0,0 +1,234 @@
+"""Compiles JSON scene files (.SCN) into the binary scene format (SCB).
+
+The layout must match `source/sigmoid/SceneBinary.hpp`.
+"""
+
+import json
+import math
+import struct
+
+MAGIC = b"SCB\x1a"
+VERSION = 2
+
+SCENE_TYPES = {"field": 0, "story": 1}
+
+CMD_SPRITE = 0
+CMD_SPEAK = 1
+CMD_WAIT = 2
+CMD_BACKGROUND = 3
+
+FLAG_HIDE = 1 << 0
+FLAG_HAS_BACKGROUND = 1 << 1
+FLAG_HAS_MUSIC = 1 << 2
+EASE_SHIFT = 8
+
+EASINGS = {"linear": 0, "in": 1, "out": 2, "in_out": 3}
+
+HEADER = struct.Struct("<4s9I8I")
+ACTOR = struct.Struct("<6I2i")
+COMMAND = struct.Struct("<2Iif4I4f")
+
+class CompileError(Exception):
+  pass
+
+class StringPool:
+  """Deduplicating pool of UTF-8 strings."""
+
+  def __init__(self):
+    self.data = bytearray()
+    self.known: dict[str, tuple[int, int]] = {}
+
+  def add(self, s: str) -> tuple[int, int]:
+    if s not in self.known:
+      raw = s.encode("utf-8")
+      self.known[s] = (len(self.data), len(raw))
+      self.data += raw
+    return self.known[s]
+
+def _pair(obj: dict, key: str, what: str) -> tuple[float, float]:
+  val = obj[key]
+  if not isinstance(val, list) or len(val) != 2 \
+      or not all(_is_number(elem) for elem in val):
+    raise CompileError(f"Expected [x, y] for `{key}` of {what}.")
+  return float(val[0]), float(val[1])
+
+def _is_number(val) -> bool:
+  return not isinstance(val, bool) and isinstance(val, (int, float)) \
+    and math.isfinite(val)
+
+def _number(obj: dict, key: str, what: str) -> float:
+  val = obj[key]
+  if not _is_number(val):
+    raise CompileError(f"Expected number for `{key}` of {what}.")
+  return float(val)
+
+def _time(obj: dict, what: str) -> float:
+  if "time" not in obj:
+    return 0.0
+  time = _number(obj, "time", what)
+  if time < 0:
+    raise CompileError(f"Time of {what} must not be negative.")
+  return time
+
+def _string(obj: dict, key: str, what: str) -> str:
+  val = obj.get(key, "")
+  if not isinstance(val, str):
+    raise CompileError(f"Expected string for `{key}` of {what}.")
+  return val
+
+def _portrait(obj: dict, actor: dict, what: str) -> int:
+  if "portrait" not in obj:
+    return -1
+  x, y = _pair(obj, "portrait", what)
+  width, height = actor["sheetSize"]
+  if not (0 <= x < width and 0 <= y < height):
+    raise CompileError(f"Portrait of {what} is outside the actor's sheet.")
+  return int(y) * width + int(x)
+
+def _actor(actors: dict, obj: dict, what: str) -> tuple[str, dict]:
+  actor_id = _string(obj, "actor", what)
+  if actor_id not in actors:
+    raise CompileError(f"Could not find actor `{actor_id}` for {what}.")
+  return actor_id, actors[actor_id]
+
+def _command(pool: StringPool, actors: dict, idx: int, cmd: dict) -> bytes:
+  if not isinstance(cmd, dict) or len(cmd) != 1:
+    raise CompileError(f"Invalid command {idx}.")
+  kind, data = next(iter(cmd.items()))
+  what = f"{kind} command {idx}"
+  if not isinstance(data, dict):
+    raise CompileError(f"Expected object for {what}.")
+
+  flags = 0
+  portrait = -1
+  time = 0.0
+  strings = [(0, 0), (0, 0)]
+  pos = (-1.0, -1.0)
+  size = (-1.0, -1.0)
+  if kind == "sprite":
+    code = CMD_SPRITE
+    if "id" not in data:
+      raise CompileError(f"Could not find id for {what}.")
+    if data.get("hide", False):
+      flags |= FLAG_HIDE
+    actor_id, actor = _actor(actors, data, what)
+    strings = [pool.add(_string(data, "id", what)), pool.add(actor_id)]
+    portrait = _portrait(data, actor, what)
+    if "pos" in data:
+      pos = _pair(data, "pos", what)
+    if "size" in data:
+      size = _pair(data, "size", what)
+    time = _time(data, what)
+    ease = _string(data, "ease", what) or "linear"
+    if ease not in EASINGS:
+      raise CompileError(f"Unknown easing `{ease}` for {what}.")
+    flags |= EASINGS[ease] << EASE_SHIFT
+  elif kind == "speak":
+    code = CMD_SPEAK
+    actor_id, actor = _actor(actors, data, what)
+    strings = [pool.add(actor_id), pool.add(_string(data, "text", what))]
+    portrait = _portrait(data, actor, what)
+    if "speed" in data:
+      time = _number(data, "speed", what)
+      if time < 0:
+        raise CompileError(f"Speed of {what} must not be negative.")
+  elif kind == "wait":
+    code = CMD_WAIT
+    if "time" not in data:
+      raise CompileError(f"Could not find time for {what}.")
+    time = _time(data, what)
+  elif kind == "background":
+    code = CMD_BACKGROUND
+    if "background" in data:
+      flags |= FLAG_HAS_BACKGROUND
+    if "music" in data:
+      flags |= FLAG_HAS_MUSIC
+    strings = [
+      pool.add(_string(data, "background", what)),
+      pool.add(_string(data, "music", what)),
+    ]
+    time = _time(data, what)
+  else:
+    raise CompileError(f"Invalid command {idx}.")
+
+  return COMMAND.pack(code, flags, portrait, time,
+                      *strings[0], *strings[1], *pos, *size)
+
+def _align(buf: bytearray, alignment: int):
+  buf += bytes(-len(buf) % alignment)
+
+def compile_scene(text: str) -> bytes:
+  """Compiles the text of a JSON scene file, raising CompileError on
+  invalid scenes."""
+  try:
+    root = json.loads(text)
+  except json.JSONDecodeError as e:
+    raise CompileError(str(e)) from e
+  try:
+    return _compile(root)
+  except (OverflowError, struct.error) as e:
+    raise CompileError(f"Value too large for its field: {e}") from e
+
+def _compile(root) -> bytes:
+  if not isinstance(root, dict):
+    raise CompileError("Expected object.")
+
+  scene_type = _string(root, "type", "scene").lower()
+  if scene_type not in SCENE_TYPES:
+    raise CompileError(f"Unknown scene type `{scene_type}`.")
+
+  pool = StringPool()
+  title = pool.add(_string(root, "title", "scene"))
+  background = pool.add(_string(root, "background", "scene"))
+  music = pool.add(_string(root, "music", "scene"))
+  next_scene = pool.add(_string(root, "next", "scene"))
+
+  actors_blob = bytearray()
+  commands_blob = bytearray()
+  actors = {}
+  commands = []
+  if scene_type == "story":
+    actors = root.get("actors")
+    if not isinstance(actors, dict):
+      raise CompileError("Could not find `actors`.")
+    for actor_id, actor in actors.items():
+      what = f"actor `{actor_id}`"
+      if not isinstance(actor, dict):
+        raise CompileError(f"Expected object for {what}.")
+      if not actor.get("sheet"):
+        raise CompileError(f"Expected non-empty `sheet` for {what}.")
+      if "sheetSize" not in actor:
+        raise CompileError(f"No `sheetSize` field for {what}.")
+      width, height = _pair(actor, "sheetSize", what)
+      if width < 1 or height < 1:
+        raise CompileError(f"Expected positive `sheetSize` for {what}.")
+      actor["sheetSize"] = [int(width), int(height)]
+      actors_blob += ACTOR.pack(
+        *pool.add(actor_id),
+        *pool.add(_string(actor, "name", what)),
+        *pool.add(_string(actor, "sheet", what)),
+        int(width), int(height))
+
+    commands = root.get("commands")
+    if not isinstance(commands, list):
+      raise CompileError("Could not find `commands`.")
+    for idx, cmd in enumerate(commands):
+      commands_blob += _command(pool, actors, idx, cmd)
+
+  out = bytearray(HEADER.size)
+  _align(out, 8)
+  actor_offset = len(out)
+  out += actors_blob
+  _align(out, 8)
+  command_offset = len(out)
+  out += commands_blob
+  strings_offset = len(out)
+  out += pool.data
+
+  HEADER.pack_into(out, 0,
+    MAGIC, VERSION, SCENE_TYPES[scene_type],
+    len(actors), actor_offset,
+    len(commands), command_offset,
+    strings_offset, len(pool.data), 0,
+    *title, *background, *music, *next_scene)
+  return bytes(out)
@@ -0,0 +1,109 @@
+"""Cooks PNG images into ready-to-upload textures (TEX).
+
+Cooked textures are stored under the image's usual name, the engine tells the
+two apart by the magic number. The layout must match
+`source/sigmoid/CookedTexture.hpp`.
+"""
+
+import json
+import struct
+
+from pngfile import read_png
+
+MAGIC = b"TEX\x1a"
+VERSION = 1
+
+FLAG_PREMULTIPLIED = 1 << 0
+
+HEADER = struct.Struct("<4s5I")
+LEVEL = struct.Struct("<4I")
+
+MAX_LEVELS = 16
+
+def premultiply(rgba: bytes) -> bytearray:
+  out = bytearray(rgba)
+  for i in range(3, len(out), 4):
+    alpha = out[i]
+    if alpha == 255:
+      continue
+    for c in range(i - 3, i):
+      out[c] = (out[c] * alpha + 127) // 255
+  return out
+
+def downsample(width: int, height: int, rgba: bytes) -> tuple[int, int, bytearray]:
+  """Halves an image with a 2x2 box filter. Odd edges repeat their last row or
+  column."""
+  half_w = max(width // 2, 1)
+  half_h = max(height // 2, 1)
+  out = bytearray(half_w * half_h * 4)
+  stride = width * 4
+  for y in range(half_h):
+    top = min(y * 2, height - 1) * stride
+    bottom = min(y * 2 + 1, height - 1) * stride
+    for x in range(half_w):
+      left = min(x * 2, width - 1) * 4
+      right = min(x * 2 + 1, width - 1) * 4
+      dst = (y * half_w + x) * 4
+      for c in range(4):
+        total = (rgba[top + left + c] + rgba[top + right + c]
+          + rgba[bottom + left + c] + rgba[bottom + right + c])
+        out[dst + c] = (total + 2) // 4
+  return half_w, half_h, out
+
+def cook(data: bytes, mips: bool) -> bytes:
+  """Decodes a PNG and returns it as a cooked texture with premultiplied alpha,
+  plus its whole mip chain if `mips` is set."""
+  width, height, rgba = read_png(data)
+  levels = [(width, height, premultiply(rgba))]
+  # filtering premultiplied pixels doesn't bleed the colour of transparent ones
+  while mips and len(levels) < MAX_LEVELS and (width > 1 or height > 1):
+    width, height, pixels = downsample(width, height, levels[-1][2])
+    levels.append((width, height, pixels))
+
+  out = bytearray(HEADER.size + LEVEL.size * len(levels))
+  records = bytearray()
+  for level_w, level_h, pixels in levels:
+    records += LEVEL.pack(level_w, level_h, len(out), len(pixels))
+    out += pixels
+  HEADER.pack_into(out, 0, MAGIC, VERSION,
+    levels[0][0], levels[0][1], len(levels), FLAG_PREMULTIPLIED)
+  out[HEADER.size:HEADER.size + len(records)] = records
+  return bytes(out)
+
+def find_images(info: str, scenes: list[str]) -> set[str]:
+  """Collects the images the engine decodes itself: menu graphics and scene
+  backgrounds. Actor sheets are loaded by the engine's texture loader, which
+  only understands PNGs, so they're left alone."""
+  images = set()
+  try:
+    root = json.loads(info)
+  except json.JSONDecodeError:
+    root = None
+  if isinstance(root, dict):
+    for key in ("logo", "menu_background"):
+      if isinstance(root.get(key), str):
+        images.add(root[key])
+
+  sheets = set()
+  for text in scenes:
+    try:
+      root = json.loads(text)
+    except json.JSONDecodeError:
+      continue
+    if not isinstance(root, dict):
+      continue
+    if isinstance(root.get("background"), str):
+      images.add(root["background"])
+    actors = root.get("actors")
+    if isinstance(actors, dict):
+      for actor in actors.values():
+        if isinstance(actor, dict) and isinstance(actor.get("sheet"), str):
+          sheets.add(actor["sheet"])
+    commands = root.get("commands")
+    if isinstance(commands, list):
+      for cmd in commands:
+        data = cmd.get("background") if isinstance(cmd, dict) else None
+        if isinstance(data, dict) and isinstance(data.get("background"), str):
+          images.add(data["background"])
+  images.discard("")
+  return images - sheets
@@ -0,0 +1,187 @@
+"""Checks the engine's PNG decoder against the bundle tools' reader.
+
+Every image is decoded by the `pngcheck` target & by pngfile.read_png, which
+inflates with zlib, and the pixels have to match. The images are made up on
+the spot to cover every color type, bit depth, row filter, interlace method &
+kind of deflate block, plus the test game's own. Corrupted copies of them only
+have to be rejected or decoded without crashing, which says the most when
+pngcheck is built with sanitizers.
+
+Usage: python3 source/pngcheck/check.py [path/to/pngcheck]
+"""
+
+import pathlib
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+ROOT = pathlib.Path(__file__).resolve().parents[2]
+sys.path.insert(0, str(ROOT / "source" / "bndl"))
+
+from pngfile import ADAM7, CHANNELS, PNG_SIGNATURE, PNGError, read_png # pylint: disable=wrong-import-position
+
+DEPTHS = {0: (1, 2, 4, 8, 16), 2: (8, 16), 3: (1, 2, 4, 8), 4: (8, 16), 6: (8, 16)}
+SIZES = ((1, 1), (3, 2), (9, 9), (17, 5), (37, 13), (130, 70))
+# level & strategy, for stored, fixed Huffman & dynamic Huffman blocks
+DEFLATE = ((0, zlib.Z_DEFAULT_STRATEGY), (6, zlib.Z_FIXED),
+           (1, zlib.Z_DEFAULT_STRATEGY), (9, zlib.Z_DEFAULT_STRATEGY))
+CORRUPTIONS = 64
+
+def _chunk(kind: bytes, body: bytes) -> bytes:
+  crc = zlib.crc32(kind + body) & 0xFFFFFFFF
+  return struct.pack(">I", len(body)) + kind + body + struct.pack(">I", crc)
+
+def _pack(samples: list[int], depth: int) -> bytes:
+  if depth == 16:
+    return b"".join(struct.pack(">H", v) for v in samples)
+  if depth == 8:
+    return bytes(samples)
+  out = bytearray((len(samples) * depth + 7) // 8)
+  for i, v in enumerate(samples):
+    bit = i * depth
+    out[bit // 8] |= v << (8 - depth - bit % 8)
+  return bytes(out)
+
+def _filter(rows: list[bytes], bpp: int, rng: random.Random) -> bytes:
+  out = bytearray()
+  prev = bytes(len(rows[0]))
+  for row in rows:
+    kind = rng.randrange(5)
+    out.append(kind)
+    for i, value in enumerate(row):
+      a = row[i - bpp] if i >= bpp else 0
+      b = prev[i]
+      c = prev[i - bpp] if i >= bpp else 0
+      if kind == 0:
+        pred = 0
+      elif kind == 1:
+        pred = a
+      elif kind == 2:
+        pred = b
+      elif kind == 3:
+        pred = (a + b) // 2
+      else:
+        p = a + b - c
+        pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+        pred = a if pa <= pb and pa <= pc else b if pb <= pc else c
+      out.append((value - pred) & 0xFF)
+    prev = row
+  return bytes(out)
+
+def synthetic(rng: random.Random, width: int, height: int, depth: int,
+              color: int, interlaced: bool, deflate: tuple[int, int],
+              keyed: bool) -> bytes:
+  """Makes up a PNG with random samples & row filters."""
+  channels = CHANNELS[color]
+  limit = 1 << min(depth, 7) if color == 3 else 1 << depth
+  samples = [[rng.randrange(limit) for _ in range(width * channels)]
+             for _ in range(height)]
+  bpp = max(1, channels * depth // 8)
+
+  raw = bytearray()
+  passes = ADAM7 if interlaced else ((0, 0, 1, 1),)
+  for x0, y0, dx, dy in passes:
+    rows = []
+    for y in range(y0, height, dy):
+      row = []
+      for x in range(x0, width, dx):
+        row += samples[y][x * channels:(x + 1) * channels]
+      if row:
+        rows.append(_pack(row, depth))
+    if rows:
+      raw += _filter(rows, bpp, rng)
+
+  level, strategy = deflate
+  compressor = zlib.compressobj(level, zlib.DEFLATED, 15, 9, strategy)
+  data = compressor.compress(bytes(raw)) + compressor.flush()
+  header = struct.pack(">2I5B", width, height, depth, color, 0, 0,
+                       1 if interlaced else 0)
+  out = PNG_SIGNATURE + _chunk(b"IHDR", header)
+  if color == 3:
+    out += _chunk(b"PLTE", bytes(rng.randrange(256) for _ in range(limit * 3)))
+    out += _chunk(b"tRNS", bytes(rng.randrange(256) for _ in range(limit // 2)))
+  elif keyed and color in (0, 2):
+    # the first pixel's color becomes transparent everywhere
+    key = samples[0][:channels]
+    out += _chunk(b"tRNS", b"".join(struct.pack(">H", v) for v in key))
+  # split the data in two to cross a chunk boundary
+  half = len(data) // 2
+  out += _chunk(b"IDAT", data[:half]) + _chunk(b"IDAT", data[half:])
+  return out + _chunk(b"IEND", b"")
+
+def cases(rng: random.Random) -> list[tuple[str, bytes]]:
+  out = []
+  for color, depths in DEPTHS.items():
+    for depth in depths:
+      for width, height in SIZES:
+        for variant, deflate in enumerate(DEFLATE):
+          for interlaced in (False, True):
+            name = (f"{width}x{height} color type {color} at {depth} bits, "
+                    f"deflate {deflate[0]}/{deflate[1]}"
+                    + (", interlaced" if interlaced else ""))
+            out.append((name, synthetic(rng, width, height, depth, color,
+                                        interlaced, deflate, variant == 3)))
+  for path in sorted((ROOT / "source" / "game").glob("**/*.PNG")):
+    out.append((str(path.relative_to(ROOT)), path.read_bytes()))
+  return out
+
+def decode(pngcheck: str, data: bytes,
+           tmp: pathlib.Path) -> tuple[int, bytes, str]:
+  """Runs pngcheck, returning its exit code, output & error message."""
+  src = tmp / "in.png"
+  dst = tmp / "out.rgba"
+  src.write_bytes(data)
+  dst.unlink(missing_ok=True)
+  res = subprocess.run([pngcheck, str(src), str(dst)], capture_output=True,
+                       text=True, check=False)
+  out = dst.read_bytes() if res.returncode == 0 else b""
+  return res.returncode, out, res.stderr.strip()
+
+def corrupt(rng: random.Random, data: bytes) -> bytes:
+  if rng.randrange(4) == 0:
+    return data[:rng.randrange(len(data))]
+  out = bytearray(data)
+  for _ in range(rng.randrange(1, 9)):
+    out[rng.randrange(len(out))] ^= rng.randrange(1, 256)
+  return bytes(out)
+
+def main() -> int:
+  pngcheck = sys.argv[1] if len(sys.argv) > 1 else str(ROOT / "target" / "pngcheck")
+  rng = random.Random(0x5167AA01)
+  wrong = 0
+  crashed = 0
+  rejected = 0
+  corrupted = 0
+  images = cases(rng)
+  with tempfile.TemporaryDirectory() as tmpdir:
+    tmp = pathlib.Path(tmpdir)
+    for name, data in images:
+      width, height, expected = read_png(data)
+      code, out, error = decode(pngcheck, data, tmp)
+      if code != 0 or out != struct.pack("<2I", width, height) + expected:
+        print(f"{name}: decoded wrong: {error or 'pixels differ'}")
+        wrong += 1
+
+    for name, data in images:
+      for _ in range(CORRUPTIONS // 8 if name.startswith("source") else 1):
+        code, _, error = decode(pngcheck, corrupt(rng, data), tmp)
+        corrupted += 1
+        if code == 1:
+          rejected += 1
+        elif code != 0:
+          print(f"{name}: corrupted copy crashed the decoder ({code}): {error}")
+          crashed += 1
+
+  print(f"{len(images)} images, {wrong} decoded wrong")
+  print(f"{corrupted} corrupted copies, {rejected} rejected, {crashed} crashed")
+  return 1 if wrong or crashed else 0
+
+if __name__ == "__main__":
+  try:
+    sys.exit(main())
+  except PNGError as e:
+    print(f"Reference decoder failed: {e}")
+    sys.exit(1)
@@ -0,0 +1,69 @@
+/*
+pngcheck
+--------
+Decodes a PNG with the engine's decoder, so check.py can hold it up against
+the bundle tools' reader. Not part of the engine.
+
+Usage: pngcheck <in.png> <out>
+Writes the width & height as little endian u32s, then the RGBA8 pixels.
+Exits with 1 if the file doesn't decode, & 2 if it can't be read or written.
+*/
+
+#include "../sigmoid/PNG.cpp"
+#include <cstdio>
+
+using namespace nwge;
+using namespace sigmoid;
+
+static bool readFile(CStr path, Array<u8> &out) {
+  FILE *file = std::fopen(path, "rb");
+  if(file == nullptr) {
+    return false;
+  }
+  bool ok = std::fseek(file, 0, SEEK_END) == 0;
+  long size = ok ? std::ftell(file) : -1;
+  ok = size >= 0 && std::fseek(file, 0, SEEK_SET) == 0;
+  if(ok) {
+    out = {usize(size)};
+    ok = std::fread(out.data(), 1, usize(size), file) == usize(size);
+  }
+  std::fclose(file);
+  return ok;
+}
+
+static bool writeFile(CStr path, const Pixels &pixels) {
+  FILE *file = std::fopen(path, "wb");
+  if(file == nullptr) {
+    return false;
+  }
+  std::array<u8, 8> header{};
+  for(usize i = 0; i < 4; ++i) {
+    header[i] = u8(u32(pixels.size.x) >> (i * 8));
+    header[i + 4] = u8(u32(pixels.size.y) >> (i * 8));
+  }
+  bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size()
+    && std::fwrite(pixels.data.data(), 1, pixels.data.size(), file) == pixels.data.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+s32 main(s32 argc, CStr *argv) {
+  if(argc != 3) {
+    std::fprintf(stderr, "Usage: %s <in.png> <out>\n", argv[0]);
+    return 2;
+  }
+  Array<u8> file;
+  if(!readFile(argv[1], file)) {
+    std::fprintf(stderr, "Could not read %s\n", argv[1]);
+    return 2;
+  }
+  Pixels pixels;
+  if(CStr error = decodePNG(file.view(), pixels)) {
+    std::fprintf(stderr, "%s\n", error);
+    return 1;
+  }
+  if(!writeFile(argv[2], pixels)) {
+    std::fprintf(stderr, "Could not write %s\n", argv[2]);
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include "Arena.hpp"
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+// block data starts right after the header, which keeps it maximally aligned
+static constexpr usize cHeaderSize = 32;
+
+static inline char *blockData(void *block) {
+  return static_cast<char*>(block) + cHeaderSize;
+}
+
+Arena::Arena(usize blockSize)
+  : mBlockSize(blockSize)
+{}
+
+Arena::Arena(Arena &&other) noexcept
+  : mHead(std::exchange(other.mHead, nullptr)),
+    mOffset(std::exchange(other.mOffset, 0)),
+    mBlockSize(other.mBlockSize),
+    mStats(std::exchange(other.mStats, {}))
+{}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+  if(this != &other) {
+    reset();
+    mHead = std::exchange(other.mHead, nullptr);
+    mOffset = std::exchange(other.mOffset, 0);
+    mBlockSize = other.mBlockSize;
+    mStats = std::exchange(other.mStats, {});
+  }
+  return *this;
+}
+
+Arena::~Arena() {
+  reset();
+}
+
+void *Arena::alloc(usize size, usize align) {
+  if(mHead != nullptr) {
+    auto base = reinterpret_cast<uintptr_t>(blockData(mHead));
+    uintptr_t start = (base + mOffset + align - 1) & ~(uintptr_t(align) - 1);
+    if(start + size <= base + mHead->size) {
+      mOffset = start - base + size;
+      ++mStats.allocations;
+      mStats.used += size;
+      return reinterpret_cast<void*>(start);
+    }
+  }
+
+  newBlock(size + align);
+  auto base = reinterpret_cast<uintptr_t>(blockData(mHead));
+  uintptr_t start = (base + align - 1) & ~(uintptr_t(align) - 1);
+  mOffset = start - base + size;
+  ++mStats.allocations;
+  mStats.used += size;
+  return reinterpret_cast<void*>(start);
+}
+
+StringView Arena::copy(const StringView &str) {
+  if(str.empty()) {
+    return {};
+  }
+  auto *data = alloc<char>(str.size());
+  std::memcpy(data, str.begin(), str.size());
+  return {data, str.size()};
+}
+
+void Arena::reset() {
+  while(mHead != nullptr) {
+    Block *prev = mHead->prev;
+    nwgeFree(mHead);
+    mHead = prev;
+  }
+  mOffset = 0;
+  mStats = {};
+}
+
+const Arena::Stats &Arena::stats() const {
+  return mStats;
+}
+
+void Arena::newBlock(usize minSize) {
+  static_assert(sizeof(Block) <= cHeaderSize);
+  usize size = minSize > mBlockSize ? minSize : mBlockSize;
+  auto *block = static_cast<Block*>(nwgeAlloc(cHeaderSize + size));
+  block->prev = mHead;
+  block->size = size;
+  mHead = block;
+  mOffset = 0;
+  ++mStats.blocks;
+  mStats.reserved += size;
+}
+
+} // namespace sigmoid
@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+Arena.hpp
+---------
+Bump allocator for data sharing a single lifetime
+*/
+
+#include <cstddef>
+#include <nwge/common/string.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Bump allocator.
+ *
+ * Memory is handed out from large blocks and is only ever given back all at
+ * once, by `reset()` or when the arena is destroyed. Moving an arena keeps all
+ * memory handed out so far in place.
+ */
+class Arena {
+public:
+  static constexpr usize cDefaultBlockSize = 64 * 1024;
+
+  struct Stats {
+    usize allocations = 0; // -> allocations served by the arena
+    usize blocks = 0;      // -> blocks allocated from the heap
+    usize used = 0;        // -> bytes handed out
+    usize reserved = 0;    // -> bytes allocated from the heap
+  };
+
+  Arena() = default;
+  explicit Arena(usize blockSize);
+  Arena(Arena &&other) noexcept;
+  Arena(const Arena&) = delete;
+  Arena &operator=(Arena &&other) noexcept;
+  Arena &operator=(const Arena&) = delete;
+  ~Arena();
+
+  void *alloc(usize size, usize align = alignof(std::max_align_t));
+
+  template<typename T>
+  T *alloc(usize count) {
+    return static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+  }
+
+  // Copies the string into the arena.
+  nwge::StringView copy(const nwge::StringView &str);
+
+  // Frees all blocks at once.
+  void reset();
+
+  [[nodiscard]]
+  const Stats &stats() const;
+
+private:
+  struct Block {
+    Block *prev;
+    usize size;
+  };
+
+  Block *mHead = nullptr;
+  usize mOffset = 0;
+  usize mBlockSize = cDefaultBlockSize;
+  Stats mStats;
+
+  void newBlock(usize minSize);
+};
+
+} // namespace sigmoid
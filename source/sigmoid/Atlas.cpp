@@ -0,0 +1,130 @@
+#include "Atlas.hpp"
+#include <nwge/dialog.hpp>
+#include <algorithm>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+bool Atlas::load(data::RW &file) {
+  s64 size = file.size();
+  if(size <= 0) {
+    dialog::error("Failure"_sv, "Could not load the sheet atlas."_sv);
+    return false;
+  }
+  mData = {usize(size)};
+  if(!file.read(mData.view())) {
+    dialog::error("Failure"_sv, "Could not load the sheet atlas."_sv);
+    return false;
+  }
+  if(!open()) {
+    dialog::error("Failure"_sv,
+      "Could not parse the sheet atlas:\n"
+      "Invalid or unsupported file."_sv);
+    return false;
+  }
+  mLoaded = true;
+  return true;
+}
+
+static inline bool inBounds(usize total, u32 offset, usize size) {
+  return offset <= total && size <= total - offset;
+}
+
+/*
+The manifest is validated up front & its cells are copied out, so drawing a
+portrait is a plain array lookup.
+*/
+bool Atlas::open() {
+  if(mData.size() < sizeof(AtlasBinaryHeader)) {
+    return false;
+  }
+  // the file is read into a freshly allocated buffer, so it is suitably
+  // aligned for the tables
+  const auto &header = *reinterpret_cast<const AtlasBinaryHeader*>(mData.data());
+  if(!std::equal(cAtlasBinaryMagic.begin(), cAtlasBinaryMagic.end(),
+    header.magic.begin())
+  || header.version != cAtlasBinaryVersion) {
+    return false;
+  }
+
+  usize pagesSize = usize(header.pageCount) * sizeof(SceneBinaryString);
+  usize sheetsSize = usize(header.sheetCount) * sizeof(AtlasBinarySheet);
+  usize cellsSize = usize(header.cellCount) * sizeof(AtlasBinaryCell);
+  if(!inBounds(mData.size(), header.pageOffset, pagesSize)
+  || !inBounds(mData.size(), header.sheetOffset, sheetsSize)
+  || !inBounds(mData.size(), header.cellOffset, cellsSize)
+  || !inBounds(mData.size(), header.stringsOffset, header.stringsSize)
+  || header.pageOffset % alignof(SceneBinaryString) != 0
+  || header.sheetOffset % alignof(AtlasBinarySheet) != 0
+  || header.cellOffset % alignof(AtlasBinaryCell) != 0) {
+    return false;
+  }
+  const char *base = mData.data();
+  const auto *pages = reinterpret_cast<const SceneBinaryString*>(base + header.pageOffset);
+  const auto *sheets = reinterpret_cast<const AtlasBinarySheet*>(base + header.sheetOffset);
+  const auto *cells = reinterpret_cast<const AtlasBinaryCell*>(base + header.cellOffset);
+  const char *strings = base + header.stringsOffset;
+  auto string = [&](SceneBinaryString ref, StringView &out) {
+    if(!inBounds(header.stringsSize, ref.offset, ref.size)) {
+      return false;
+    }
+    out = {strings + ref.offset, ref.size};
+    return true;
+  };
+
+  mCells = {header.cellCount};
+  for(usize i = 0; i < header.cellCount; ++i) {
+    const auto &src = cells[i];
+    mCells[i] = {
+      {{src.pos[0], src.pos[1]}, {src.size[0], src.size[1]}},
+      {src.offset[0], src.offset[1]},
+      {src.extent[0], src.extent[1]},
+    };
+  }
+
+  mSheets = {header.sheetCount};
+  for(usize i = 0; i < header.sheetCount; ++i) {
+    const auto &src = sheets[i];
+    auto &sheet = mSheets[i];
+    if(src.page >= header.pageCount
+    || !inBounds(header.cellCount, src.firstCell, src.cellCount)
+    || !string(src.name, sheet.name)
+    || !string(pages[src.page], sheet.page)) {
+      return false;
+    }
+    sheet.columns = src.columns;
+    sheet.cells = {mCells.data() + src.firstCell, src.cellCount};
+  }
+  return true;
+}
+
+bool Atlas::loaded() const {
+  return mLoaded;
+}
+
+const AtlasSheet *Atlas::find(const StringView &sheet) const {
+  // a game has a handful of sheets, a linear search does fine
+  for(const auto &entry: mSheets) {
+    if(entry.name.equals(sheet)) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+/*
+A sheet used with different grids in different scenes is only in the atlas
+with the first one, the others keep using the sheet itself.
+*/
+const AtlasSheet *Atlas::find(const StringView &sheet, glm::ivec2 grid) const {
+  const auto *entry = find(sheet);
+  if(entry == nullptr || grid.x <= 0 || grid.y <= 0
+  || entry->columns != u32(grid.x)
+  || entry->cells.size() != usize(grid.x) * usize(grid.y)) {
+    return nullptr;
+  }
+  return entry;
+}
+
+} // namespace sigmoid
@@ -0,0 +1,139 @@
+#pragma once
+
+/*
+Atlas.hpp
+---------
+Actor sheet atlas manifest
+*/
+
+#include "SceneBinary.hpp"
+#include <nwge/common/array.hpp>
+#include <nwge/common/string.hpp>
+#include <nwge/data/rw.hpp>
+#include <nwge/render/draw.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Header of an atlas manifest.
+ *
+ * Atlas manifests (`ATLAS.MAN`) are generated by the bundle plugin, which
+ * packs the cells of every actor sheet of a game into a few shared pages. All
+ * offsets are relative to the start of the file and all values are little
+ * endian. Strings use the same string pool references as compiled scenes.
+ */
+struct AtlasBinaryHeader {
+  std::array<char, 4> magic;
+  u32 version;
+  u32 pageCount;
+  u32 pageOffset;
+  u32 sheetCount;
+  u32 sheetOffset;
+  u32 cellCount;
+  u32 cellOffset;
+  u32 stringsOffset;
+  u32 stringsSize;
+};
+static_assert(sizeof(AtlasBinaryHeader) == 40);
+
+struct AtlasBinarySheet {
+  SceneBinaryString name; // -> entry of the original sheet
+  u32 page;
+  u32 firstCell;
+  u32 cellCount;
+  u32 columns;
+};
+static_assert(sizeof(AtlasBinarySheet) == 24);
+
+/**
+ * @brief Cell of a sheet, trimmed down to its visible pixels.
+ *
+ * `pos` & `size` are the texture coordinates of the trimmed cell within its
+ * page. `offset` & `extent` place it within the untrimmed cell, as fractions of
+ * the untrimmed cell's size. Cells without any visible pixels have an extent of
+ * zero.
+ */
+struct AtlasBinaryCell {
+  std::array<f32, 2> pos;
+  std::array<f32, 2> size;
+  std::array<f32, 2> offset;
+  std::array<f32, 2> extent;
+};
+static_assert(sizeof(AtlasBinaryCell) == 32);
+
+static constexpr std::array<char, 4> cAtlasBinaryMagic{'A', 'T', 'L', '\x1A'};
+static constexpr u32 cAtlasBinaryVersion = 2;
+
+/**
+ * @brief Sprite drawn from part of a texture.
+ *
+ * `offset` & `extent` give the part of the sprite's rect the texture rect is
+ * drawn to, as fractions of the rect's size. Untrimmed sprites fill their
+ * whole rect.
+ */
+struct AtlasCell {
+  nwge::render::TexCoord texCoord;
+  glm::vec2 offset{0, 0};
+  glm::vec2 extent{1, 1};
+
+  // Returns false if there's nothing to draw.
+  [[nodiscard]]
+  bool visible() const {
+    return extent.x > 0 && extent.y > 0;
+  }
+
+  // Position & size to draw the texture rect at, for a sprite drawn at `pos`
+  // with `size`.
+  [[nodiscard]]
+  glm::vec3 pos(glm::vec3 pos, glm::vec2 size) const {
+    return pos + glm::vec3{offset * size, 0};
+  }
+  [[nodiscard]]
+  glm::vec2 size(glm::vec2 size) const {
+    return extent * size;
+  }
+};
+
+/**
+ * @brief Where the cells of an actor sheet ended up in the atlas.
+ *
+ * Cells are in the same order as in the sheet, row by row.
+ */
+struct AtlasSheet {
+  nwge::StringView name;
+  nwge::StringView page; // -> bundle entry of the page texture
+  u32 columns = 0;
+  nwge::ArrayView<const AtlasCell> cells;
+};
+
+/**
+ * @brief Sheet lookup table loaded from an atlas manifest.
+ *
+ * Load it through `nwge::data::Bundle::nqCustom()`. Sheets which aren't in the
+ * manifest are drawn from their own texture, as are all sheets of games built
+ * without an atlas.
+ */
+class Atlas {
+public:
+  bool load(nwge::data::RW &file);
+
+  [[nodiscard]]
+  bool loaded() const;
+  // Returns null if the sheet isn't in the atlas.
+  [[nodiscard]]
+  const AtlasSheet *find(const nwge::StringView &sheet) const;
+  // Returns null unless the sheet is in the atlas with the given grid.
+  [[nodiscard]]
+  const AtlasSheet *find(const nwge::StringView &sheet, glm::ivec2 grid) const;
+
+private:
+  // Backing storage of the manifest, sheet & page names point into it.
+  nwge::Array<char> mData;
+  nwge::Array<AtlasSheet> mSheets;
+  nwge::Array<AtlasCell> mCells;
+  bool mLoaded = false;
+
+  bool open();
+};
+
+} // namespace sigmoid
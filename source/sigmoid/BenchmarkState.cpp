@@ -0,0 +1,409 @@
+#include "CommandRegistry.hpp"
+#include "CookedTexture.hpp"
+#include "DecodePool.hpp"
+#include "GL.hpp"
+#include "Image.hpp"
+#include "ResourceCache.hpp"
+#include "Scene.hpp"
+#include "states.hpp"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <nwge/console.hpp>
+#include <nwge/json.hpp>
+#include <nwge/json/Schema.hpp>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+static constexpr usize cBenchCommands = 100'000;
+static constexpr usize cBenchActors = 8;
+static constexpr usize cBenchDecodeRounds = 8;
+static constexpr std::array<CStr, 5> cBenchImages{
+  "BACK.PNG", "LAB.PNG", "OUTSIDE.PNG", "TESTER.PNG", "LOGO.PNG",
+};
+
+static void append(Slice<char> &out, const StringView &text) {
+  for(char chr: text) {
+    out.push(chr);
+  }
+}
+
+static void append(Slice<char> &out, usize number) {
+  std::array<char, 20> digits{};
+  usize count = 0;
+  do {
+    digits[count++] = char('0' + number % 10);
+    number /= 10;
+  } while(number != 0);
+  while(count != 0) {
+    out.push(digits[--count]);
+  }
+}
+
+/*
+Generates a story scene with `commandCount` commands, cycling through every
+command type, with a few actors, sprites & backgrounds to refer to.
+*/
+static Slice<char> syntheticScene(usize commandCount) {
+  Slice<char> out{commandCount * 64};
+  append(out, R"({"type":"story","actors":{)"_sv);
+  for(usize i = 0; i < cBenchActors; ++i) {
+    if(i != 0) {
+      out.push(',');
+    }
+    append(out, R"("a)"_sv);
+    append(out, i);
+    append(out, R"(":{"name":"Actor","sheet":"A.PNG","sheetSize":[2,2]})"_sv);
+  }
+  append(out, R"(},"commands":[)"_sv);
+  for(usize i = 0; i < commandCount; ++i) {
+    if(i != 0) {
+      out.push(',');
+    }
+    switch(i % CommandMax) {
+    case CommandSprite:
+      append(out, R"({"sprite":{"id":"s)"_sv);
+      append(out, i % 32);
+      append(out, R"(","actor":"a)"_sv);
+      append(out, i % cBenchActors);
+      append(out, R"(","portrait":[1,0],"pos":[0.5,0.5]}})"_sv);
+      break;
+    case CommandSpeak:
+      append(out, R"({"speak":{"actor":"a)"_sv);
+      append(out, i % cBenchActors);
+      append(out, R"(","portrait":[0,1],"text":"Line number )"_sv);
+      append(out, i);
+      append(out, R"( of the benchmark."}})"_sv);
+      break;
+    case CommandWait:
+      append(out, R"({"wait":{"time":0.5}})"_sv);
+      break;
+    default:
+      append(out, R"({"background":{"background":"BG)"_sv);
+      append(out, i % 16);
+      append(out, R"(.PNG"}})"_sv);
+      break;
+    }
+  }
+  append(out, "]}"_sv);
+  return out;
+}
+
+static f64 secondsSince(u64 start) {
+  return f64(SDL_GetPerformanceCounter() - start)
+    / f64(SDL_GetPerformanceFrequency());
+}
+
+// The lookup chain StoryScene::loadCommands used before the command registry.
+static usize dispatchChained(json::Schema commands) {
+  usize found = 0;
+  for(usize i = 0; i < commands.array().size(); ++i) {
+    auto maybeCommand = commands.expectObjectElement();
+    if(maybeCommand->expectObjectField("sprite"_sv).present()
+    || maybeCommand->expectObjectField("background"_sv).present()
+    || maybeCommand->expectObjectField("speak"_sv).present()
+    || maybeCommand->expectObjectField("wait"_sv).present()) {
+      ++found;
+    }
+  }
+  return found;
+}
+
+static usize dispatchRegistry(json::Schema commands) {
+  usize found = 0;
+  for(usize i = 0; i < commands.array().size(); ++i) {
+    auto maybeCommand = commands.expectObjectElement();
+    auto pairs = maybeCommand->pairs();
+    if(pairs.size() == 1 && findCommandType(pairs[0].key) != nullptr) {
+      ++found;
+    }
+  }
+  return found;
+}
+
+static void benchCommandDispatch() {
+  auto text = syntheticScene(cBenchCommands);
+
+  u64 start = SDL_GetPerformanceCounter();
+  auto res = json::parse(text.view());
+  f64 parseTime = secondsSince(start);
+  if(res.error != json::OK) {
+    console::error("Benchmark scene did not parse: {}",
+      json::errorMessage(res.error));
+    return;
+  }
+  auto maybeRoot = json::Schema::object(*res.value);
+  auto maybeCommands = maybeRoot->expectArrayField("commands"_sv);
+
+  start = SDL_GetPerformanceCounter();
+  usize chained = dispatchChained(*maybeCommands);
+  f64 chainedTime = secondsSince(start);
+
+  start = SDL_GetPerformanceCounter();
+  usize registry = dispatchRegistry(*maybeCommands);
+  f64 registryTime = secondsSince(start);
+
+  Scene scene{"BENCH"_sv};
+  JSONReader reader{text.view()};
+  start = SDL_GetPerformanceCounter();
+  bool loaded = scene.load(reader);
+  f64 loadTime = secondsSince(start);
+
+  console::print("Command dispatch, {} commands:", cBenchCommands);
+  console::print("  parse:             {}ms", parseTime * 1000);
+  console::print("  chained lookups:   {}ms ({} found)", chainedTime * 1000, chained);
+  console::print("  registry lookups:  {}ms ({} found)", registryTime * 1000, registry);
+  console::print("  streaming load:    {}ms ({})", loadTime * 1000,
+    loaded ? "ok"_sv : "failed"_sv);
+}
+
+/*
+Counts every heap allocation made through SDL's allocator while it's alive,
+which is where the engine's containers, the JSON DOM & arena blocks all get
+their memory from. Reallocations count as allocations.
+*/
+class AllocationCounter {
+public:
+  AllocationCounter() {
+    SDL_GetMemoryFunctions(&sMalloc, &sCalloc, &sRealloc, &sFree);
+    sCount = 0;
+    SDL_SetMemoryFunctions(countMalloc, countCalloc, countRealloc, sFree);
+  }
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter &operator=(const AllocationCounter&) = delete;
+
+  ~AllocationCounter() {
+    SDL_SetMemoryFunctions(sMalloc, sCalloc, sRealloc, sFree);
+  }
+
+  [[nodiscard]] usize count() const {
+    return sCount;
+  }
+
+private:
+  static inline SDL_malloc_func sMalloc = nullptr;
+  static inline SDL_calloc_func sCalloc = nullptr;
+  static inline SDL_realloc_func sRealloc = nullptr;
+  static inline SDL_free_func sFree = nullptr;
+  static inline std::atomic<usize> sCount = 0;
+
+  static void *SDLCALL countMalloc(size_t size) {
+    ++sCount;
+    return sMalloc(size);
+  }
+
+  static void *SDLCALL countCalloc(size_t count, size_t size) {
+    ++sCount;
+    return sCalloc(count, size);
+  }
+
+  static void *SDLCALL countRealloc(void *ptr, size_t size) {
+    ++sCount;
+    return sRealloc(ptr, size);
+  }
+};
+
+/*
+Before the arena, every arena allocation was a heap allocation of its own, so
+the heap allocations a load would have made are estimated from the arena's.
+*/
+static void benchSceneAllocations(usize commandCount) {
+  auto text = syntheticScene(commandCount);
+  Scene scene{"BENCH"_sv};
+  JSONReader reader{text.view()};
+  usize loadAllocations = 0;
+  u64 start = SDL_GetPerformanceCounter();
+  bool loaded = false;
+  {
+    AllocationCounter counter;
+    loaded = scene.load(reader);
+    loadAllocations = counter.count();
+  }
+  f64 loadTime = secondsSince(start);
+  if(!loaded) {
+    console::error("Benchmark scene did not load.");
+    return;
+  }
+  auto stats = scene.story->arena.stats();
+
+  start = SDL_GetPerformanceCounter();
+  scene.story->clear();
+  f64 clearTime = secondsSince(start);
+
+  console::print("Scene allocations, {} commands:", commandCount);
+  console::print("  {} heap allocations during load, {} without the arena",
+    loadAllocations, loadAllocations - stats.blocks + stats.allocations);
+  console::print("  {} arena allocations from {} blocks ({}/{} bytes)",
+    stats.allocations, stats.blocks, stats.used, stats.reserved);
+  console::print("  load: {}ms, teardown: {}ms",
+    loadTime * 1000, clearTime * 1000);
+}
+
+struct EncodedImage {
+  Array<u8> data;
+
+  bool load(data::RW &file) {
+    s64 size = file.size();
+    if(size <= 0) {
+      return false;
+    }
+    data = {usize(size)};
+    return file.read({reinterpret_cast<char*>(data.data()), usize(size)});
+  }
+};
+
+using BenchImages = std::array<EncodedImage, cBenchImages.size()>;
+
+// Decodes the test game's images on the main thread, then on a `DecodePool`.
+static void benchImageDecode(const BenchImages &images) {
+  usize pixelBytes = 0;
+  u64 start = SDL_GetPerformanceCounter();
+  for(usize round = 0; round < cBenchDecodeRounds; ++round) {
+    for(const auto &image: images) {
+      Pixels pixels;
+      if(CStr error = decodePNG(image.data.view(), pixels)) {
+        console::error("Benchmark image did not decode: {}", error);
+        return;
+      }
+      pixelBytes += pixels.data.size();
+    }
+  }
+  f64 serialTime = secondsSince(start);
+
+  // copying the files is not part of the measurement
+  Array<DecodeJob> jobs{cBenchDecodeRounds * images.size()};
+  for(usize i = 0; i < jobs.size(); ++i) {
+    const auto &data = images[i % images.size()].data;
+    jobs[i].encoded = {data.size()};
+    std::memcpy(jobs[i].encoded.data(), data.data(), data.size());
+  }
+  DecodePool pool;
+  start = SDL_GetPerformanceCounter();
+  for(auto &job: jobs) {
+    pool.submit(job);
+  }
+  usize failed = 0;
+  while(auto *job = pool.wait()) {
+    if(job->error != nullptr) {
+      ++failed;
+    }
+  }
+  f64 parallelTime = secondsSince(start);
+
+  console::print("Image decode, {} images x {} rounds ({} bytes of pixels):",
+    images.size(), cBenchDecodeRounds, pixelBytes);
+  console::print("  serial:            {}ms", serialTime * 1000);
+  console::print("  {} threads:         {}ms ({}x, {} failed)", pool.threads(),
+    parallelTime * 1000, serialTime / parallelTime, failed);
+}
+
+/*
+Loads the test game's images the way the resource cache does, once from the
+PNGs & once from the textures cooked by the `test_game_cooked` bundle: the
+file is copied out of the bundle's buffer, decoded or just checked, then
+uploaded in full. The upload is waited for, so the driver's copy counts too.
+*/
+static bool loadPNG(const EncodedImage &file) {
+  Array<u8> encoded{file.data.size()};
+  std::memcpy(encoded.data(), file.data.data(), file.data.size());
+  Pixels pixels;
+  if(CStr error = decodePNG(encoded.view(), pixels)) {
+    console::error("Benchmark image did not decode: {}", error);
+    return false;
+  }
+  Image image;
+  image.create(pixels.size, pixels.size, 1, pixels.premultiplied);
+  while(!image.upload(pixels)) {}
+  gl().finish();
+  return true;
+}
+
+static bool loadCooked(const EncodedImage &file, usize &levels) {
+  Array<u8> encoded{file.data.size()};
+  std::memcpy(encoded.data(), file.data.data(), file.data.size());
+  CookedTexture texture;
+  if(!texture.open(encoded.view())) {
+    return false;
+  }
+  levels = texture.levelCount();
+  Image image;
+  image.create(texture.levelSize(0), texture.size(), levels, texture.premultiplied());
+  while(!image.upload(texture, 0)) {}
+  gl().finish();
+  return true;
+}
+
+static void benchImageLoad(const BenchImages &images, const BenchImages &cooked) {
+  for(usize i = 0; i < images.size(); ++i) {
+    if(!CookedTexture::detect(cooked[i].data.view())) {
+      // actor sheets are loaded by the engine & never cooked
+      continue;
+    }
+    u64 start = SDL_GetPerformanceCounter();
+    for(usize round = 0; round < cBenchDecodeRounds; ++round) {
+      if(!loadPNG(images[i])) {
+        return;
+      }
+    }
+    f64 pngTime = secondsSince(start) / cBenchDecodeRounds;
+
+    start = SDL_GetPerformanceCounter();
+    usize levels = 0;
+    for(usize round = 0; round < cBenchDecodeRounds; ++round) {
+      if(!loadCooked(cooked[i], levels)) {
+        console::error("Benchmark texture is invalid: {}", cBenchImages[i]);
+        return;
+      }
+    }
+    f64 cookedTime = secondsSince(start) / cBenchDecodeRounds;
+
+    console::print("Image load & upload, {}:", cBenchImages[i]);
+    console::print("  PNG:    {} bytes, {}ms", images[i].data.size(), pngTime * 1000);
+    console::print("  cooked: {} bytes, {} levels, {}ms ({}x)",
+      cooked[i].data.size(), levels, cookedTime * 1000, pngTime / cookedTime);
+  }
+}
+
+/*
+Runs every benchmark once from init() and quits on the first tick. Results are
+written to the engine console.
+*/
+class BenchmarkState final: public State {
+public:
+  bool preload() override {
+    auto &bundle = resources().bundle("games"_sv, "test.bndl"_sv);
+    auto &cooked = resources().bundle("bench"_sv, "test.bndl"_sv);
+    for(usize i = 0; i < cBenchImages.size(); ++i) {
+      bundle.nqCustom(StringView{cBenchImages[i]}, mImages[i]);
+      cooked.nqCustom(StringView{cBenchImages[i]}, mCooked[i]);
+    }
+    return true;
+  }
+
+  bool init() override {
+    benchCommandDispatch();
+    benchSceneAllocations(1'000);
+    benchSceneAllocations(10'000);
+    benchSceneAllocations(cBenchCommands);
+    benchImageDecode(mImages);
+    benchImageLoad(mImages, mCooked);
+    return true;
+  }
+
+  bool tick([[maybe_unused]] f32 delta) override {
+    return false;
+  }
+
+private:
+  BenchImages mImages;
+  BenchImages mCooked;
+};
+
+State *benchmark() {
+  return new BenchmarkState();
+}
+
+} // namespace sigmoid
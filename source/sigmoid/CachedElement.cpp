@@ -0,0 +1,135 @@
+#include "CachedElement.hpp"
+#include "GL.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+// Elements are drawn into this one after another, as they change.
+static RenderTarget &scratch() {
+  static auto *target = new RenderTarget;
+  return *target;
+}
+
+/*
+The rect is rounded out to whole pixels of the frame being drawn, which is
+the viewport: the window's, or the scaled frame's.
+*/
+bool CachedElement::begin(u64 key, glm::vec3 pos, glm::vec2 size) {
+  GLint viewport[4]{};
+  gl().getIntegerv(GL_VIEWPORT, viewport);
+  glm::ivec2 frame{viewport[2], viewport[3]};
+  glm::ivec2 start{
+    std::clamp(s32(std::floor(pos.x * f32(frame.x))), 0, frame.x),
+    std::clamp(s32(std::floor(pos.y * f32(frame.y))), 0, frame.y)
+  };
+  glm::ivec2 end{
+    std::clamp(s32(std::ceil((pos.x + size.x) * f32(frame.x))), 0, frame.x),
+    std::clamp(s32(std::ceil((pos.y + size.y) * f32(frame.y))), 0, frame.y)
+  };
+  mZ = pos.z;
+  if(mTarget.valid() && key == mKey && frame == mFrame
+    && start == mStart && end == mEnd)
+  {
+    return false;
+  }
+  mKey = key;
+  mFrame = frame;
+  mStart = start;
+  mEnd = end;
+  if(!mTarget.resize(end - start) || !scratch().resize(frame)) {
+    mTarget.destroy();
+    return false;
+  }
+
+  gl().getIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &mPrevFramebuffer);
+  gl().getFloatv(GL_COLOR_CLEAR_VALUE, mPrevClearColor);
+  gl().getIntegerv(GL_BLEND_SRC_RGB, &mPrevBlend[0]);
+  gl().getIntegerv(GL_BLEND_DST_RGB, &mPrevBlend[1]);
+  gl().getIntegerv(GL_BLEND_SRC_ALPHA, &mPrevBlend[2]);
+  gl().getIntegerv(GL_BLEND_DST_ALPHA, &mPrevBlend[3]);
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, scratch().framebuffer());
+  gl().clearColor(0, 0, 0, 0);
+  gl().clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // blending onto nothing, so the element comes out premultiplied
+  gl().blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+    GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  return true;
+}
+
+/*
+GL counts rows from the bottom & textures are drawn with their first row on
+top, so the rect is flipped as it's copied.
+*/
+void CachedElement::end() {
+  gl().blendFuncSeparate(GLenum(mPrevBlend[0]), GLenum(mPrevBlend[1]),
+    GLenum(mPrevBlend[2]), GLenum(mPrevBlend[3]));
+  gl().clearColor(mPrevClearColor[0], mPrevClearColor[1],
+    mPrevClearColor[2], mPrevClearColor[3]);
+
+  GLint prevRead = 0;
+  gl().getIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevRead);
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, scratch().framebuffer());
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, mTarget.framebuffer());
+  glm::ivec2 size = mTarget.size();
+  gl().blitFramebuffer(
+    mStart.x, mFrame.y - mEnd.y, mEnd.x, mFrame.y - mStart.y,
+    0, size.y, size.x, 0,
+    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(prevRead));
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(mPrevFramebuffer));
+}
+
+void CachedElement::draw(DrawList &list) const {
+  draw(list, mTarget);
+}
+
+void CachedElement::draw(DrawList &list, const RenderTarget &target) const {
+  if(!mTarget.valid() || !target.valid()) {
+    return;
+  }
+  glm::vec2 frame{mFrame};
+  // the element has its colors already, they aren't tinted again
+  list.color();
+  list.image({
+    {f32(mStart.x) / frame.x, f32(mStart.y) / frame.y, mZ},
+    {f32(mEnd.x - mStart.x) / frame.x, f32(mEnd.y - mStart.y) / frame.y},
+    target.texture()
+  }, true);
+}
+
+void CachedElement::invalidate() {
+  mTarget.destroy();
+}
+
+const RenderTarget &CachedElement::target() const {
+  return mTarget;
+}
+
+// Rows are counted from the top, as end() flips them.
+glm::ivec2 CachedElement::pixel(glm::vec2 pos) const {
+  glm::ivec2 size = mTarget.size();
+  return {
+    std::clamp(s32(std::lround(pos.x * f32(mFrame.x))) - mStart.x, 0, size.x),
+    std::clamp(s32(std::lround(pos.y * f32(mFrame.y))) - mStart.y, 0, size.y)
+  };
+}
+
+// FNV-1a
+u64 CachedElement::key(const StringView &value, u64 seed) {
+  for(usize i = 0; i < value.size(); ++i) {
+    seed = (seed ^ u8(value[i])) * 0x100000001B3;
+  }
+  return seed;
+}
+
+u64 CachedElement::key(u64 value, u64 seed) {
+  for(usize i = 0; i < sizeof(value); ++i) {
+    seed = (seed ^ ((value >> (i * 8)) & 0xFF)) * 0x100000001B3;
+  }
+  return seed;
+}
+
+} // namespace sigmoid
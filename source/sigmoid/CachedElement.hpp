@@ -0,0 +1,77 @@
+#pragma once
+
+/*
+CachedElement.hpp
+-----------------
+UI elements drawn once & reused until they change
+*/
+
+#include "DrawList.hpp"
+#include "RenderTarget.hpp"
+#include <nwge/common/string.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief A part of the UI kept in a texture of its own.
+ *
+ * Elements are drawn as usual, in frame coordinates, but into a shared scratch
+ * target, and the pixels they cover are then copied into the element's own
+ * texture. Until the element's key, rect or the frame size change, drawing it
+ * is a single textured rect.
+ *
+ * ```cpp
+ * if(mElement.begin(key, pos, size)) {
+ *   // draw the element
+ *   mElement.end();
+ * }
+ * mElement.draw(drawList());
+ * ```
+ *
+ * Anything within the element's rect is cached, so what changes every frame
+ * must be drawn after it, in front of it.
+ */
+class CachedElement {
+public:
+  /**
+   * @brief Starts drawing the element again, if it has to be.
+   *
+   * `key` identifies what the element shows, `pos` & `size` are the rect it
+   * covers, as passed to `render::rect()`. Returns true if the element has to
+   * be drawn, in which case everything up to `end()` goes into the element.
+   */
+  bool begin(u64 key, glm::vec3 pos, glm::vec2 size);
+  void end();
+  // Draws the element at the depth of its rect, in white.
+  void draw(DrawList &list) const;
+  // Draws `target` in place of the element, which it must be the size of.
+  void draw(DrawList &list, const RenderTarget &target) const;
+  // Forgets the element's contents, so it's drawn again next time.
+  void invalidate();
+
+  [[nodiscard]]
+  const RenderTarget &target() const;
+  // The pixel of the element's texture at `pos`, in frame coordinates.
+  [[nodiscard]]
+  glm::ivec2 pixel(glm::vec2 pos) const;
+
+  // Key helpers, combining `value` into `seed`.
+  static u64 key(const nwge::StringView &value, u64 seed = cKeySeed);
+  static u64 key(u64 value, u64 seed = cKeySeed);
+
+private:
+  static constexpr u64 cKeySeed = 0xCBF29CE484222325;
+
+  RenderTarget mTarget;
+  u64 mKey = 0;
+  glm::ivec2 mFrame{0, 0};
+  glm::ivec2 mStart{0, 0}; // -> top left pixel of the rect within the frame
+  glm::ivec2 mEnd{0, 0};
+  f32 mZ = 0;
+
+  s32 mPrevFramebuffer = 0;
+  s32 mPrevBlend[4]{};
+  f32 mPrevClearColor[4]{};
+};
+
+} // namespace sigmoid
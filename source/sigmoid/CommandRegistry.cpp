@@ -0,0 +1,181 @@
+#include "CommandRegistry.hpp"
+#include <array>
+#include <bit>
+#include <string_view>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+// Command keys as used in scene files, indexed by CommandCode.
+static constexpr std::array<std::string_view, CommandMax> cCommandKeys{
+  "sprite",
+  "speak",
+  "wait",
+  "background",
+};
+
+static constexpr u32 hashName(const char *str, usize len, u32 seed) {
+  // FNV-1a with the seed mixed into the offset basis
+  u32 hash = 2166136261U ^ seed;
+  for(usize i = 0; i < len; ++i) {
+    hash ^= u8(str[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+static constexpr usize cTableSize = std::bit_ceil(2 * usize(CommandMax));
+static constexpr usize cTableMask = cTableSize - 1;
+static constexpr u32 cMaxSeed = 1 << 16;
+
+/*
+Finds the first seed for which every command key lands in its own slot. There
+are only a handful of keys, so this is cheap enough to do at compile time.
+*/
+static constexpr u32 findSeed() {
+  for(u32 seed = 1; seed < cMaxSeed; ++seed) {
+    std::array<bool, cTableSize> used{};
+    bool collision = false;
+    for(const auto &key: cCommandKeys) {
+      usize slot = hashName(key.data(), key.size(), seed) & cTableMask;
+      if(used[slot]) {
+        collision = true;
+        break;
+      }
+      used[slot] = true;
+    }
+    if(!collision) {
+      return seed;
+    }
+  }
+  return 0;
+}
+
+static constexpr u32 cSeed = findSeed();
+static_assert(cSeed != 0, "No perfect hash seed for the command keys");
+
+static constexpr std::array<s8, cTableSize> buildSlots() {
+  std::array<s8, cTableSize> slots{};
+  slots.fill(-1);
+  for(usize i = 0; i < cCommandKeys.size(); ++i) {
+    const auto &key = cCommandKeys[i];
+    slots[hashName(key.data(), key.size(), cSeed) & cTableMask] = s8(i);
+  }
+  return slots;
+}
+
+static constexpr std::array<s8, cTableSize> cSlots = buildSlots();
+
+static bool loadSprite(StoryScene &scene, Command &command, JSONReader &reader) {
+  SpriteCommand sprite;
+  if(!sprite.load(scene, reader)) {
+    return false;
+  }
+  command = scene.addCommand(sprite);
+  return true;
+}
+
+static void saveSprite(const StoryScene &scene, const Command &command, JSONWriter &writer) {
+  scene.sprite(command).save(scene, writer);
+}
+
+static bool loadSpeak(StoryScene &scene, Command &command, JSONReader &reader) {
+  SpeakCommand speak;
+  if(!speak.load(scene, reader)) {
+    return false;
+  }
+  command = scene.addCommand(speak);
+  return true;
+}
+
+static void saveSpeak(const StoryScene &scene, const Command &command, JSONWriter &writer) {
+  scene.speak(command).save(scene, writer);
+}
+
+static bool loadWait(StoryScene &scene, Command &command, JSONReader &reader) {
+  WaitCommand wait;
+  if(!wait.load(reader)) {
+    return false;
+  }
+  command = scene.addCommand(wait);
+  return true;
+}
+
+static void saveWait(const StoryScene &scene, const Command &command, JSONWriter &writer) {
+  scene.wait(command).save(writer);
+}
+
+static bool loadBackground(StoryScene &scene, Command &command, JSONReader &reader) {
+  BackgroundCommand background;
+  if(!background.load(scene, reader)) {
+    return false;
+  }
+  command = scene.addCommand(background);
+  return true;
+}
+
+static void saveBackground(const StoryScene &scene, const Command &command, JSONWriter &writer) {
+  scene.background(command).save(scene, writer);
+}
+
+struct CommandFunctions {
+  CommandCode code;
+  decltype(CommandType::load) load;
+  decltype(CommandType::save) save;
+};
+
+// Indexed by CommandCode, like cCommandKeys.
+static constexpr std::array<CommandFunctions, CommandMax> cCommandFunctions{{
+  {CommandSprite, loadSprite, saveSprite},
+  {CommandSpeak, loadSpeak, saveSpeak},
+  {CommandWait, loadWait, saveWait},
+  {CommandBackground, loadBackground, saveBackground},
+}};
+
+static constexpr bool commandTablesMatch() {
+  for(usize i = 0; i < CommandMax; ++i) {
+    const auto &functions = cCommandFunctions[i];
+    if(usize(functions.code) != i || functions.load == nullptr
+    || functions.save == nullptr || cCommandKeys[i].empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(commandTablesMatch(), "Every command code needs a key & functions, in order");
+
+static std::array<CommandType, CommandMax> buildCommandTypes() {
+  std::array<CommandType, CommandMax> types{};
+  for(usize i = 0; i < CommandMax; ++i) {
+    const auto &key = cCommandKeys[i];
+    types[i] = {
+      cCommandFunctions[i].code,
+      {key.data(), key.size()},
+      cCommandFunctions[i].load,
+      cCommandFunctions[i].save,
+    };
+  }
+  return types;
+}
+
+static const std::array<CommandType, CommandMax> cCommandTypes = buildCommandTypes();
+
+const CommandType *findCommandType(const StringView &name) {
+  auto slot = cSlots[hashName(name.begin(), name.size(), cSeed) & cTableMask];
+  if(slot < 0) {
+    return nullptr;
+  }
+  const auto &type = cCommandTypes[slot];
+  if(!type.name.equals(name)) {
+    return nullptr;
+  }
+  return &type;
+}
+
+const CommandType &commandType(CommandCode code) {
+  return cCommandTypes[code];
+}
+
+} // namespace sigmoid
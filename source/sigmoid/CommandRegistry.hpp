@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+CommandRegistry.hpp
+-------------------
+Story scene command types
+*/
+
+#include "StoryScene.hpp"
+
+namespace sigmoid {
+
+/**
+ * @brief Entry in the command registry.
+ *
+ * Each command code has exactly one entry, which knows the key used for the
+ * command in scene files and how to load & serialize the command.
+ */
+struct CommandType {
+  CommandCode code = CommandInvalid;
+  nwge::StringView name;
+  bool (*load)(StoryScene &scene, Command &command, JSONReader &reader);
+  void (*save)(const StoryScene &scene, const Command &command, JSONWriter &writer);
+};
+
+/**
+ * @brief Looks up a command type by its key in the scene file.
+ *
+ * The registry is indexed by a perfect hash of the command name which is
+ * computed at compile time, so this costs one hash and one string compare no
+ * matter how many command types there are.
+ *
+ * @return The command type, or `nullptr` if there is no such command.
+ */
+const CommandType *findCommandType(const nwge::StringView &name);
+
+const CommandType &commandType(CommandCode code);
+
+} // namespace sigmoid
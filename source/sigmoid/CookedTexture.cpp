@@ -0,0 +1,88 @@
+#include "CookedTexture.hpp"
+#include <algorithm>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+bool CookedTexture::detect(ArrayView<const u8> data) {
+  if(data.size() < cCookedTextureMagic.size()) {
+    return false;
+  }
+  return std::equal(
+    cCookedTextureMagic.begin(), cCookedTextureMagic.end(),
+    data.begin(),
+    [](char magic, u8 byte) { return u8(magic) == byte; });
+}
+
+static inline bool inBounds(usize total, u32 offset, usize size) {
+  return offset <= total && size <= total - offset;
+}
+
+/*
+Each level must be exactly the size its dimensions call for & half the size of
+the level before it, rounded down, so the uploads can trust them blindly.
+*/
+bool CookedTexture::open(ArrayView<const u8> data) {
+  mHeader = nullptr;
+  if(!detect(data) || data.size() < sizeof(CookedTextureHeader)) {
+    return false;
+  }
+  // the file is read into a freshly allocated buffer, so it is suitably
+  // aligned for the tables
+  const auto *header = reinterpret_cast<const CookedTextureHeader*>(data.begin());
+  if(header->version != cCookedTextureVersion
+  || header->width == 0 || header->height == 0
+  || header->levelCount == 0 || header->levelCount > cCookedTextureMaxLevels
+  || !inBounds(data.size(), sizeof(CookedTextureHeader),
+    header->levelCount * sizeof(CookedTextureLevel))) {
+    return false;
+  }
+  const auto *levels = reinterpret_cast<const CookedTextureLevel*>(
+    data.begin() + sizeof(CookedTextureHeader));
+
+  u32 width = header->width;
+  u32 height = header->height;
+  for(u32 i = 0; i < header->levelCount; ++i) {
+    const auto &level = levels[i];
+    if(level.width != width || level.height != height
+    || u64(level.size) != u64(width) * u64(height) * 4
+    || !inBounds(data.size(), level.offset, level.size)
+    || level.offset % 4 != 0) {
+      return false;
+    }
+    width = std::max(width / 2, 1U);
+    height = std::max(height / 2, 1U);
+  }
+
+  mData = data.begin();
+  mHeader = header;
+  mLevels = levels;
+  return true;
+}
+
+bool CookedTexture::valid() const {
+  return mHeader != nullptr;
+}
+
+glm::ivec2 CookedTexture::size() const {
+  return {s32(mHeader->width), s32(mHeader->height)};
+}
+
+usize CookedTexture::levelCount() const {
+  return mHeader->levelCount;
+}
+
+glm::ivec2 CookedTexture::levelSize(usize level) const {
+  return {s32(mLevels[level].width), s32(mLevels[level].height)};
+}
+
+const u8 *CookedTexture::levelPixels(usize level) const {
+  return mData + mLevels[level].offset;
+}
+
+bool CookedTexture::premultiplied() const {
+  return (mHeader->flags & cCookedTexturePremultiplied) != 0;
+}
+
+} // namespace sigmoid
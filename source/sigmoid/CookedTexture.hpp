@@ -0,0 +1,81 @@
+#pragma once
+
+/*
+CookedTexture.hpp
+-----------------
+Ready-to-upload texture format
+*/
+
+#include <array>
+#include <glm/glm.hpp>
+#include <nwge/common/array.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Header of a cooked texture.
+ *
+ * Cooked textures (TEX) are generated from PNG images by the bundle plugin &
+ * stored under the image's usual name, the loader tells the two apart by the
+ * magic number. The header is followed by one record per mip level, largest
+ * first. Pixels are RGBA8 rows from top to bottom. All offsets are relative to
+ * the start of the file and all values are little endian.
+ */
+struct CookedTextureHeader {
+  std::array<char, 4> magic;
+  u32 version;
+  u32 width;
+  u32 height;
+  u32 levelCount;
+  u32 flags;
+};
+static_assert(sizeof(CookedTextureHeader) == 24);
+
+struct CookedTextureLevel {
+  u32 width;
+  u32 height;
+  u32 offset;
+  u32 size;
+};
+static_assert(sizeof(CookedTextureLevel) == 16);
+
+static constexpr std::array<char, 4> cCookedTextureMagic{'T', 'E', 'X', '\x1A'};
+static constexpr u32 cCookedTextureVersion = 1;
+static constexpr u32 cCookedTextureMaxLevels = 16;
+// Header flags
+static constexpr u32 cCookedTexturePremultiplied = 1 << 0;
+
+/**
+ * @brief Read-only view over a cooked texture.
+ *
+ * Nothing is copied, the pixels of each level point directly into the viewed
+ * buffer, so it must outlive the view.
+ */
+class CookedTexture {
+public:
+  [[nodiscard]]
+  static bool detect(nwge::ArrayView<const u8> data);
+
+  // Validates the header & every level. Returns false if the file is invalid.
+  bool open(nwge::ArrayView<const u8> data);
+
+  [[nodiscard]]
+  bool valid() const;
+  [[nodiscard]]
+  glm::ivec2 size() const;
+  [[nodiscard]]
+  usize levelCount() const;
+  [[nodiscard]]
+  glm::ivec2 levelSize(usize level) const;
+  [[nodiscard]]
+  const u8 *levelPixels(usize level) const;
+  [[nodiscard]]
+  bool premultiplied() const;
+
+private:
+  const u8 *mData = nullptr;
+  const CookedTextureHeader *mHeader = nullptr;
+  const CookedTextureLevel *mLevels = nullptr;
+};
+
+} // namespace sigmoid
@@ -0,0 +1,13 @@
+#include "Debug.hpp"
+#include <nwge/cli/cli.h>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+bool statsEnabled() {
+  static bool enabled = cli::flag("stats"_sv);
+  return enabled;
+}
+
+} // namespace sigmoid
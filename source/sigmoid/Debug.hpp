@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+Debug.hpp
+---------
+Debug settings given on the command line
+*/
+
+namespace sigmoid {
+
+/**
+ * @brief Whether to print allocation, cache & draw statistics.
+ *
+ * Set by the `--stats` flag. The statistics are always collected, this only
+ * decides if they end up on the console.
+ */
+[[nodiscard]]
+bool statsEnabled();
+
+} // namespace sigmoid
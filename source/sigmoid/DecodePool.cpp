@@ -0,0 +1,168 @@
+#include "DecodePool.hpp"
+#include "Downscale.hpp"
+#include <algorithm>
+#include <utility>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+DecodePool::DecodePool(usize threads)
+  : mMutex(SDL_CreateMutex()),
+    mWork(SDL_CreateCond()),
+    mDone(SDL_CreateCond())
+{
+  if(threads == 0) {
+    threads = usize(SDL_max(SDL_GetCPUCount() - 1, 1));
+  }
+  for(usize i = 0; i < threads; ++i) {
+    mThreads.push(SDL_CreateThread(worker, "sigmoid decode", this));
+  }
+}
+
+DecodePool::~DecodePool() {
+  SDL_LockMutex(mMutex);
+  mStopping = true;
+  SDL_CondBroadcast(mWork);
+  SDL_UnlockMutex(mMutex);
+  for(auto *thread: mThreads) {
+    SDL_WaitThread(thread, nullptr);
+  }
+  SDL_DestroyCond(mDone);
+  SDL_DestroyCond(mWork);
+  SDL_DestroyMutex(mMutex);
+}
+
+void DecodePool::submit(DecodeJob &job) {
+  SDL_LockMutex(mMutex);
+  mQueue.push(&job);
+  ++mOutstanding;
+  SDL_CondSignal(mWork);
+  SDL_UnlockMutex(mMutex);
+}
+
+DecodeJob *DecodePool::poll() {
+  SDL_LockMutex(mMutex);
+  DecodeJob *job = takeFinished();
+  SDL_UnlockMutex(mMutex);
+  return job;
+}
+
+DecodeJob *DecodePool::wait() {
+  SDL_LockMutex(mMutex);
+  DecodeJob *job = takeFinished();
+  while(job == nullptr && mOutstanding != 0) {
+    SDL_CondWait(mDone, mMutex);
+    job = takeFinished();
+  }
+  SDL_UnlockMutex(mMutex);
+  return job;
+}
+
+usize DecodePool::threads() const {
+  return mThreads.size();
+}
+
+namespace {
+
+void shrink(Pixels &pixels, usize steps) {
+  for(usize i = 0; i < steps; ++i) {
+    Pixels half;
+    halve(pixels.data.data(), pixels.size, half);
+    half.premultiplied = pixels.premultiplied;
+    pixels = std::move(half);
+  }
+}
+
+/*
+A cooked texture without a small enough mip level is shrunk from its smallest
+one, so every image ends up the same size whichever way it was bundled.
+*/
+void decodeCooked(DecodeJob &job) {
+  auto &cooked = job.cooked;
+  if(!cooked.open(job.encoded.view())) {
+    job.error = "Invalid or unsupported cooked texture";
+    return;
+  }
+  job.sourceSize = cooked.size();
+  usize steps = downscaleSteps(cooked.size(), job.target);
+  job.baseLevel = std::min(steps, cooked.levelCount() - 1);
+  if(job.baseLevel == steps) {
+    return;
+  }
+  Pixels &pixels = job.pixels;
+  pixels.size = cooked.levelSize(job.baseLevel);
+  pixels.premultiplied = cooked.premultiplied();
+  halve(cooked.levelPixels(job.baseLevel), pixels.size, pixels);
+  shrink(pixels, steps - job.baseLevel - 1);
+  job.cooked = {};
+  job.baseLevel = 0;
+  job.encoded = {};
+}
+
+void decode(DecodeJob &job) {
+  // the file could not be read
+  if(job.error != nullptr) {
+    return;
+  }
+  if(CookedTexture::detect(job.encoded.view())) {
+    decodeCooked(job);
+    return;
+  }
+  job.error = decodePNG(job.encoded.view(), job.pixels);
+  job.encoded = {};
+  if(job.error == nullptr) {
+    job.sourceSize = job.pixels.size;
+    shrink(job.pixels, downscaleSteps(job.pixels.size, job.target));
+  }
+}
+
+} // namespace
+
+int DecodePool::worker(void *data) {
+  auto &pool = *static_cast<DecodePool*>(data);
+  SDL_LockMutex(pool.mMutex);
+  for(;;) {
+    DecodeJob *job = pop(pool.mQueue, pool.mQueueHead);
+    if(job == nullptr) {
+      if(pool.mStopping) {
+        break;
+      }
+      SDL_CondWait(pool.mWork, pool.mMutex);
+      continue;
+    }
+    SDL_UnlockMutex(pool.mMutex);
+
+    decode(*job);
+
+    SDL_LockMutex(pool.mMutex);
+    pool.mFinished.push(job);
+    SDL_CondBroadcast(pool.mDone);
+  }
+  SDL_UnlockMutex(pool.mMutex);
+  return 0;
+}
+
+// Slices have no cheap way to drop their front, so queues are only cleared
+// out once everything in them has been taken.
+DecodeJob *DecodePool::pop(Slice<DecodeJob*> &queue, usize &head) {
+  if(head == queue.size()) {
+    return nullptr;
+  }
+  DecodeJob *job = queue[head++];
+  if(head == queue.size()) {
+    queue.clear();
+    head = 0;
+  }
+  return job;
+}
+
+DecodeJob *DecodePool::takeFinished() {
+  DecodeJob *job = pop(mFinished, mFinishedHead);
+  if(job != nullptr) {
+    --mOutstanding;
+  }
+  return job;
+}
+
+} // namespace sigmoid
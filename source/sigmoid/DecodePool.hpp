@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+DecodePool.hpp
+--------------
+Worker threads decoding images off the main thread
+*/
+
+#include "CookedTexture.hpp"
+#include "PNG.hpp"
+#include <SDL2/SDL.h>
+#include <nwge/common/slice.hpp>
+
+namespace sigmoid {
+
+struct DecodeJob {
+  nwge::Array<u8> encoded; // -> file contents, freed once a PNG is decoded
+  glm::ivec2 target{0, 0}; // -> size the image is drawn at, at most
+  Pixels pixels;
+  CookedTexture cooked;    // -> set instead of `pixels` for cooked textures,
+                           //    which are uploaded straight from `encoded`
+  usize baseLevel = 0;     // -> first mip level of `cooked` to upload
+  glm::ivec2 sourceSize{0, 0}; // -> size before downscaling
+  CStr error = nullptr;    // -> set if reading or decoding failed
+};
+
+/**
+ * @brief Decodes PNG files on a pool of worker threads.
+ *
+ * Cooked textures need no decoding & are only validated. Images which are at
+ * least twice as big as their `target` are shrunk, by picking a smaller mip
+ * level of a cooked texture or by halving the pixels.
+ *
+ * Jobs are handed back in the order they finish. A job must stay alive until
+ * it comes back from `poll()` or `wait()`. Jobs submitted with `error` set
+ * are handed back as they are.
+ */
+class DecodePool {
+public:
+  // 0 picks one thread per CPU core except the main thread's.
+  explicit DecodePool(usize threads = 0);
+  DecodePool(const DecodePool&) = delete;
+  DecodePool(DecodePool&&) = delete;
+  DecodePool &operator=(const DecodePool&) = delete;
+  DecodePool &operator=(DecodePool&&) = delete;
+  ~DecodePool();
+
+  // Can be called from any thread.
+  void submit(DecodeJob &job);
+  // Returns a finished job, or null if none has finished.
+  DecodeJob *poll();
+  // Blocks until a job finishes. Returns null if no job is outstanding.
+  DecodeJob *wait();
+
+  [[nodiscard]]
+  usize threads() const;
+
+private:
+  nwge::Slice<SDL_Thread*> mThreads{4};
+  SDL_mutex *mMutex;
+  SDL_cond *mWork; // -> signalled on submit & shutdown
+  SDL_cond *mDone; // -> signalled when a job finishes
+  nwge::Slice<DecodeJob*> mQueue{8};
+  usize mQueueHead = 0;
+  nwge::Slice<DecodeJob*> mFinished{8};
+  usize mFinishedHead = 0;
+  usize mOutstanding = 0; // -> submitted but not yet handed back
+  bool mStopping = false;
+
+  static int worker(void *pool);
+  // Both expect the mutex to be locked.
+  static DecodeJob *pop(nwge::Slice<DecodeJob*> &queue, usize &head);
+  DecodeJob *takeFinished();
+};
+
+} // namespace sigmoid
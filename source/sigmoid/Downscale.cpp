@@ -0,0 +1,102 @@
+#include "Downscale.hpp"
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace nwge;
+
+namespace sigmoid {
+
+usize downscaleSteps(glm::ivec2 size, glm::ivec2 target) {
+  if(target.x <= 0 || target.y <= 0) {
+    return 0;
+  }
+  usize steps = 0;
+  while(size.x / 2 >= target.x && size.y / 2 >= target.y) {
+    size = {size.x / 2, size.y / 2};
+    ++steps;
+  }
+  return steps;
+}
+
+glm::ivec2 downscaledSize(glm::ivec2 size, usize steps) {
+  for(usize i = 0; i < steps; ++i) {
+    size = {std::max(size.x / 2, 1), std::max(size.y / 2, 1)};
+  }
+  return size;
+}
+
+namespace {
+
+// Averages the 2x2 block of pixels starting at `x` of the two rows.
+inline void averageBlock(const u8 *top, const u8 *bottom, s32 x, s32 right,
+  u8 *out)
+{
+  s32 left = x * 4;
+  s32 next = std::min(x + 1, right) * 4;
+  for(s32 c = 0; c < 4; ++c) {
+    u32 sum = u32(top[left + c]) + u32(top[next + c])
+      + u32(bottom[left + c]) + u32(bottom[next + c]);
+    out[c] = u8((sum + 2) / 4);
+  }
+}
+
+#ifdef __SSE2__
+/*
+Sums each horizontal pair of pixels of the two rows, four output pixels at a
+time. Pixels are widened to 16 bits so the sums can't overflow & the rounding
+matches the scalar path exactly.
+*/
+inline __m128i sumPairs(__m128i top, __m128i bottom) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_add_epi16(
+    _mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+  __m128i hi = _mm_add_epi16(
+    _mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+  // each half holds two pixels, adding the halves sums each pair
+  lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+  hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+  return _mm_unpacklo_epi64(lo, hi);
+}
+
+// Returns the first output column left for the scalar path.
+s32 halveRow(const u8 *top, const u8 *bottom, s32 width, u8 *out) {
+  __m128i round = _mm_set1_epi16(2);
+  s32 x = 0;
+  // every full 2x2 block is averaged here, an odd last column is not
+  for(; x + 4 <= width / 2; x += 4) {
+    const auto *t = reinterpret_cast<const __m128i*>(top + x * 8);
+    const auto *b = reinterpret_cast<const __m128i*>(bottom + x * 8);
+    __m128i first = sumPairs(_mm_loadu_si128(t), _mm_loadu_si128(b));
+    __m128i second = sumPairs(_mm_loadu_si128(t + 1), _mm_loadu_si128(b + 1));
+    first = _mm_srli_epi16(_mm_add_epi16(first, round), 2);
+    second = _mm_srli_epi16(_mm_add_epi16(second, round), 2);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4),
+      _mm_packus_epi16(first, second));
+  }
+  return x;
+}
+#else
+s32 halveRow(const u8*, const u8*, s32, u8*) {
+  return 0;
+}
+#endif
+
+} // namespace
+
+void halve(const u8 *pixels, glm::ivec2 size, Pixels &out) {
+  out.size = downscaledSize(size, 1);
+  out.data = {usize(out.size.x) * usize(out.size.y) * 4};
+  usize stride = usize(size.x) * 4;
+  for(s32 y = 0; y < out.size.y; ++y) {
+    const u8 *top = pixels + usize(std::min(y * 2, size.y - 1)) * stride;
+    const u8 *bottom = pixels + usize(std::min(y * 2 + 1, size.y - 1)) * stride;
+    u8 *row = out.data.data() + usize(y) * usize(out.size.x) * 4;
+    for(s32 x = halveRow(top, bottom, size.x, row); x < out.size.x; ++x) {
+      averageBlock(top, bottom, x * 2, size.x - 1, row + x * 4);
+    }
+  }
+}
+
+} // namespace sigmoid
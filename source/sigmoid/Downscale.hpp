@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+Downscale.hpp
+-------------
+Shrinking images to the size they're drawn at
+*/
+
+#include "PNG.hpp"
+
+namespace sigmoid {
+
+/**
+ * @brief Counts how many times an image can be halved and still cover
+ * `target`.
+ *
+ * Halving rounds down & stops at 1 pixel. A `target` with a zero dimension
+ * means there is no target and returns 0.
+ */
+[[nodiscard]]
+usize downscaleSteps(glm::ivec2 size, glm::ivec2 target);
+
+// Size of an image halved `steps` times.
+[[nodiscard]]
+glm::ivec2 downscaledSize(glm::ivec2 size, usize steps);
+
+/**
+ * @brief Halves RGBA8 pixels with a 2x2 box filter.
+ *
+ * An odd last row or column is averaged with itself. Safe to run on any
+ * thread.
+ */
+void halve(const u8 *pixels, glm::ivec2 size, Pixels &out);
+
+} // namespace sigmoid
@@ -0,0 +1,216 @@
+#include "DrawList.hpp"
+#include "Image.hpp"
+#include <nwge/console.hpp>
+#include <algorithm>
+#include <functional>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+u64 DrawList::Stats::stateChanges() const {
+  return colorChanges + textureChanges + blendChanges;
+}
+
+bool DrawList::Draw::sameState(const Draw &other) const {
+  return kind == other.kind
+    && texture == other.texture
+    && image == other.image
+    && premultiplied == other.premultiplied
+    && color == other.color;
+}
+
+void DrawList::color(glm::vec4 color) {
+  mColor = color;
+}
+
+void DrawList::color(glm::vec3 color) {
+  mColor = {color, 1};
+}
+
+void DrawList::color() {
+  mColor = {1, 1, 1, 1};
+}
+
+void DrawList::rect(glm::vec3 pos, glm::vec2 size) {
+  Draw draw;
+  draw.pos = pos;
+  draw.size = size;
+  push(std::move(draw));
+}
+
+void DrawList::rect(glm::vec3 pos, glm::vec2 size, const render::Texture &texture,
+  const render::TexCoord &texCoord)
+{
+  Draw draw;
+  draw.kind = KindTexture;
+  draw.pos = pos;
+  draw.size = size;
+  draw.texture = &texture;
+  draw.texCoord = texCoord;
+  push(std::move(draw));
+}
+
+void DrawList::image(const render::Rect &rect, bool premultiplied) {
+  Draw draw;
+  draw.kind = KindImage;
+  draw.premultiplied = premultiplied;
+  draw.pos = rect.pos;
+  draw.size = rect.size;
+  draw.image = rect.texture;
+  push(std::move(draw));
+}
+
+void DrawList::line(glm::vec3 from, glm::vec3 to, f32 width) {
+  Draw draw;
+  draw.kind = KindLine;
+  draw.pos = from;
+  draw.end = to;
+  draw.height = width;
+  push(std::move(draw));
+}
+
+void DrawList::text(const render::Font &font, const StringView &text,
+  glm::vec3 pos, f32 height)
+{
+  Draw draw;
+  draw.kind = KindText;
+  draw.pos = pos;
+  draw.texture = &font;
+  draw.text = text;
+  draw.height = height;
+  push(std::move(draw));
+}
+
+void DrawList::push(Draw &&draw) {
+  draw.color = mColor;
+  mDraws.push(std::move(draw));
+}
+
+static bool colorLess(glm::vec4 lhs, glm::vec4 rhs) {
+  if(lhs.x != rhs.x) {
+    return lhs.x < rhs.x;
+  }
+  if(lhs.y != rhs.y) {
+    return lhs.y < rhs.y;
+  }
+  if(lhs.z != rhs.z) {
+    return lhs.z < rhs.z;
+  }
+  return lhs.w < rhs.w;
+}
+
+/*
+Higher depths are further back. The sort is stable, so draws sharing depth &
+state keep the order they were recorded in. Premultiplied blending is switched
+on once per run of draws needing it.
+*/
+void DrawList::flush() {
+  std::stable_sort(mDraws.begin(), mDraws.end(), [](const Draw &lhs, const Draw &rhs){
+    if(lhs.pos.z != rhs.pos.z) {
+      return lhs.pos.z > rhs.pos.z;
+    }
+    if(lhs.kind != rhs.kind) {
+      return lhs.kind < rhs.kind;
+    }
+    if(lhs.texture != rhs.texture) {
+      return std::less<>{}(lhs.texture, rhs.texture);
+    }
+    if(lhs.image != rhs.image) {
+      return lhs.image < rhs.image;
+    }
+    if(lhs.premultiplied != rhs.premultiplied) {
+      return rhs.premultiplied;
+    }
+    return colorLess(lhs.color, rhs.color);
+  });
+
+  mFrame = {};
+  const Draw *previous = nullptr;
+  const Draw *previousTextured = nullptr;
+  usize count = mDraws.size();
+  usize idx = 0;
+  while(idx < count) {
+    bool premultiplied = mDraws[idx].premultiplied;
+    if(premultiplied || idx != 0) {
+      ++mFrame.blendChanges;
+    }
+    BlendImage blend{premultiplied};
+    for(; idx < count && mDraws[idx].premultiplied == premultiplied; ++idx) {
+      const auto &draw = mDraws[idx];
+      if(previous == nullptr || !draw.sameState(*previous)) {
+        ++mFrame.batches;
+      }
+      if(previous == nullptr || draw.color != previous->color) {
+        render::color(draw.color);
+        ++mFrame.colorChanges;
+      }
+      if(draw.kind != KindRect && draw.kind != KindLine) {
+        if(previousTextured == nullptr
+          || draw.texture != previousTextured->texture
+          || draw.image != previousTextured->image)
+        {
+          ++mFrame.textureChanges;
+        }
+        previousTextured = &draw;
+      }
+      submit(draw);
+      ++mFrame.draws;
+      previous = &draw;
+    }
+  }
+  mDraws.clear();
+  mColor = {1, 1, 1, 1};
+  render::color();
+
+  ++mFrames;
+  mTotal.draws += mFrame.draws;
+  mTotal.batches += mFrame.batches;
+  mTotal.colorChanges += mFrame.colorChanges;
+  mTotal.textureChanges += mFrame.textureChanges;
+  mTotal.blendChanges += mFrame.blendChanges;
+  mPeakDraws = std::max(mPeakDraws, mFrame.draws);
+  mPeakStateChanges = std::max(mPeakStateChanges, mFrame.stateChanges());
+}
+
+void DrawList::submit(const Draw &draw) const {
+  switch(draw.kind) {
+  case KindRect:
+    render::rect(draw.pos, draw.size);
+    break;
+  case KindTexture:
+    render::rect(draw.pos, draw.size,
+      *static_cast<const render::Texture*>(draw.texture), draw.texCoord);
+    break;
+  case KindImage:
+    render::Rect{draw.pos, draw.size, draw.image}.draw();
+    break;
+  case KindLine:
+    render::line(draw.pos, draw.end, draw.height);
+    break;
+  case KindText:
+    static_cast<const render::Font*>(draw.texture)->draw(draw.text, draw.pos, draw.height);
+    break;
+  }
+}
+
+const DrawList::Stats &DrawList::frameStats() const {
+  return mFrame;
+}
+
+void DrawList::printStats() const {
+  f64 frames = mFrames == 0 ? 1 : f64(mFrames);
+  console::print("Draws: {} frames, {} draws in {} batches per frame ({} at most),"
+    " {} state changes per frame ({} color, {} texture, {} blend; {} at most)",
+    mFrames, f64(mTotal.draws) / frames, f64(mTotal.batches) / frames,
+    mPeakDraws, f64(mTotal.stateChanges()) / frames,
+    f64(mTotal.colorChanges) / frames, f64(mTotal.textureChanges) / frames,
+    f64(mTotal.blendChanges) / frames, mPeakStateChanges);
+}
+
+DrawList &drawList() {
+  static auto *list = new DrawList;
+  return *list;
+}
+
+} // namespace sigmoid
@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+DrawList.hpp
+------------
+Collecting a frame's draws & submitting them in batches
+*/
+
+#include <nwge/common/slice.hpp>
+#include <nwge/common/string.hpp>
+#include <nwge/render/draw.hpp>
+#include <nwge/render/Font.hpp>
+#include <nwge/render/Texture.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief The draws of a frame, submitted together.
+ *
+ * Draws are recorded with the color set at the time, like the immediate
+ * `render::` functions, and submitted by `flush()`. They're submitted back to
+ * front, so transparent draws blend over whatever is behind them. Draws at the
+ * same depth are grouped by texture, blending & color, so each group is one
+ * run of draws without state changes in between, and colors are only set when
+ * they change.
+ *
+ * The depth test already makes the order of overlapping draws at the same
+ * depth matter, so those must not overlap. Text & textures are referred to,
+ * not copied, and have to outlive the flush.
+ */
+class DrawList {
+public:
+  struct Stats {
+    u64 draws = 0;          // -> draw calls submitted
+    u64 batches = 0;        // -> runs of draws sharing texture, blending & color
+    u64 colorChanges = 0;
+    u64 textureChanges = 0;
+    u64 blendChanges = 0;
+
+    [[nodiscard]]
+    u64 stateChanges() const;
+  };
+
+  // Sets the color of the following draws, white by default.
+  void color(glm::vec4 color);
+  void color(glm::vec3 color);
+  void color();
+
+  void rect(glm::vec3 pos, glm::vec2 size);
+  void rect(glm::vec3 pos, glm::vec2 size, const nwge::render::Texture &texture,
+    const nwge::render::TexCoord &texCoord);
+  // `rect.texture` is drawn with premultiplied alpha if `premultiplied`.
+  void image(const nwge::render::Rect &rect, bool premultiplied);
+  void line(glm::vec3 from, glm::vec3 to, f32 width);
+  void text(const nwge::render::Font &font, const nwge::StringView &text,
+    glm::vec3 pos, f32 height);
+
+  // Submits & clears the draws recorded, resetting the color.
+  void flush();
+
+  // Counts of the last frame flushed.
+  [[nodiscard]]
+  const Stats &frameStats() const;
+  void printStats() const;
+
+private:
+  enum Kind: u8 {
+    KindRect,
+    KindTexture,
+    KindImage,
+    KindLine,
+    KindText,
+  };
+
+  struct Draw {
+    Kind kind = KindRect;
+    bool premultiplied = false;
+    glm::vec3 pos{0, 0, 0};
+    glm::vec3 end{0, 0, 0};        // -> end of a line
+    glm::vec2 size{0, 0};
+    glm::vec4 color{1, 1, 1, 1};
+    const void *texture = nullptr; // -> texture, or font of text
+    u32 image = 0;
+    nwge::render::TexCoord texCoord{};
+    nwge::StringView text;
+    f32 height = 0;                // -> of text, width of lines
+
+    [[nodiscard]]
+    bool sameState(const Draw &other) const;
+  };
+
+  nwge::Slice<Draw> mDraws{64};
+  glm::vec4 mColor{1, 1, 1, 1};
+
+  Stats mFrame;
+  Stats mTotal; // -> of every frame flushed
+  u64 mFrames = 0;
+  u64 mPeakDraws = 0;
+  u64 mPeakStateChanges = 0;
+
+  void submit(const Draw &draw) const;
+  void push(Draw &&draw);
+};
+
+// The process-wide draw list.
+DrawList &drawList();
+
+} // namespace sigmoid
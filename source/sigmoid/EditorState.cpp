@@ -1,4 +1,5 @@
 #include "AssetManager.hpp"
+#include "Redraw.hpp"
 #include "SceneManager.hpp"
 #include "imgui/imgui.hpp"
 #include "states.hpp"
@@ -40,6 +41,14 @@ class EditorState final: public State {
   bool tick([[maybe_unused]] f32 delta) override {
     mInfo.scenes.window(mInfo);
     mInfo.assets.window();
+    /*
+    Sub states tick after this one. Input wakes the loop up by itself, only the
+    blinking cursor of a focused text field needs a deadline.
+    */
+    if(ImGui::GetIO().WantTextInput) {
+      redraw().deadline(cCursorBlink);
+    }
+    redraw().idle();
     return true;
   }
 
@@ -49,6 +58,9 @@ class EditorState final: public State {
 
 private:
   EditorInfo mInfo;
+
+  // Shortest phase of ImGui's blinking text cursor, in seconds.
+  static constexpr f32 cCursorBlink = 0.4f;
 };
 
 State *editorState(const nwge::StringView &gameName) {
@@ -0,0 +1,52 @@
+#include "GL.hpp"
+
+namespace sigmoid {
+
+template<typename T>
+static void load(T &function, const char *name) {
+  function = reinterpret_cast<T>(SDL_GL_GetProcAddress(name));
+}
+
+const GL &gl() {
+  static const GL functions = []{
+    GL out{};
+    load(out.genTextures, "glGenTextures");
+    load(out.deleteTextures, "glDeleteTextures");
+    load(out.bindTexture, "glBindTexture");
+    load(out.getIntegerv, "glGetIntegerv");
+    load(out.getFloatv, "glGetFloatv");
+    load(out.clearColor, "glClearColor");
+    load(out.clear, "glClear");
+    load(out.finish, "glFinish");
+    load(out.pixelStorei, "glPixelStorei");
+    load(out.texParameteri, "glTexParameteri");
+    load(out.texImage2D, "glTexImage2D");
+    load(out.texSubImage2D, "glTexSubImage2D");
+    load(out.blendFuncSeparate, "glBlendFuncSeparate");
+    load(out.viewport, "glViewport");
+    load(out.genFramebuffers, "glGenFramebuffers");
+    load(out.deleteFramebuffers, "glDeleteFramebuffers");
+    load(out.bindFramebuffer, "glBindFramebuffer");
+    load(out.framebufferTexture2D, "glFramebufferTexture2D");
+    load(out.framebufferRenderbuffer, "glFramebufferRenderbuffer");
+    load(out.checkFramebufferStatus, "glCheckFramebufferStatus");
+    load(out.blitFramebuffer, "glBlitFramebuffer");
+    load(out.genRenderbuffers, "glGenRenderbuffers");
+    load(out.deleteRenderbuffers, "glDeleteRenderbuffers");
+    load(out.bindRenderbuffer, "glBindRenderbuffer");
+    load(out.renderbufferStorage, "glRenderbufferStorage");
+    return out;
+  }();
+  return functions;
+}
+
+BindTexture::BindTexture(u32 id) {
+  gl().getIntegerv(GL_TEXTURE_BINDING_2D, &mPrevious);
+  gl().bindTexture(GL_TEXTURE_2D, id);
+}
+
+BindTexture::~BindTexture() {
+  gl().bindTexture(GL_TEXTURE_2D, GLuint(mPrevious));
+}
+
+} // namespace sigmoid
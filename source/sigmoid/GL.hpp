@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+GL.hpp
+------
+OpenGL functions the engine doesn't expose
+*/
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#include <nwge/common/string.hpp>
+
+namespace sigmoid {
+
+/*
+The engine doesn't expose its GL loader, so the few functions needed outside of
+it are looked up through SDL on first use.
+*/
+struct GL {
+  void (APIENTRY *genTextures)(GLsizei, GLuint*);
+  void (APIENTRY *deleteTextures)(GLsizei, const GLuint*);
+  void (APIENTRY *bindTexture)(GLenum, GLuint);
+  void (APIENTRY *getIntegerv)(GLenum, GLint*);
+  void (APIENTRY *getFloatv)(GLenum, GLfloat*);
+  void (APIENTRY *clearColor)(GLfloat, GLfloat, GLfloat, GLfloat);
+  void (APIENTRY *clear)(GLbitfield);
+  void (APIENTRY *finish)();
+  void (APIENTRY *pixelStorei)(GLenum, GLint);
+  void (APIENTRY *texParameteri)(GLenum, GLenum, GLint);
+  void (APIENTRY *texImage2D)(GLenum, GLint, GLint, GLsizei, GLsizei, GLint,
+    GLenum, GLenum, const void*);
+  void (APIENTRY *texSubImage2D)(GLenum, GLint, GLint, GLint, GLsizei, GLsizei,
+    GLenum, GLenum, const void*);
+  void (APIENTRY *blendFuncSeparate)(GLenum, GLenum, GLenum, GLenum);
+  void (APIENTRY *viewport)(GLint, GLint, GLsizei, GLsizei);
+  void (APIENTRY *genFramebuffers)(GLsizei, GLuint*);
+  void (APIENTRY *deleteFramebuffers)(GLsizei, const GLuint*);
+  void (APIENTRY *bindFramebuffer)(GLenum, GLuint);
+  void (APIENTRY *framebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint);
+  void (APIENTRY *framebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
+  GLenum (APIENTRY *checkFramebufferStatus)(GLenum);
+  void (APIENTRY *blitFramebuffer)(GLint, GLint, GLint, GLint, GLint, GLint,
+    GLint, GLint, GLbitfield, GLenum);
+  void (APIENTRY *genRenderbuffers)(GLsizei, GLuint*);
+  void (APIENTRY *deleteRenderbuffers)(GLsizei, const GLuint*);
+  void (APIENTRY *bindRenderbuffer)(GLenum, GLuint);
+  void (APIENTRY *renderbufferStorage)(GLenum, GLenum, GLsizei, GLsizei);
+};
+
+const GL &gl();
+
+// Binds a texture for the lifetime of the object, restoring the engine's own.
+class BindTexture {
+public:
+  BindTexture(u32 id);
+  BindTexture(const BindTexture&) = delete;
+  BindTexture(BindTexture&&) = delete;
+  BindTexture &operator=(const BindTexture&) = delete;
+  BindTexture &operator=(BindTexture&&) = delete;
+  ~BindTexture();
+
+private:
+  GLint mPrevious = 0;
+};
+
+} // namespace sigmoid
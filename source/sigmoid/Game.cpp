@@ -1,8 +1,8 @@
 #include "Game.hpp"
+#include "JSONReader.hpp"
+#include "JSONWriter.hpp"
+#include "ResourceCache.hpp"
 #include <nwge/dialog.hpp>
-#include <nwge/json.hpp>
-#include <nwge/json/builder.hpp>
-#include <nwge/json/Schema.hpp>
 
 using namespace nwge;
 
@@ -16,9 +16,8 @@ Game::~Game() = default;
 
 void Game::preload() {
   ScratchString filename = ScratchString::formatted("{}.bndl", name);
-  bundle
-    .load({"games"_sv, filename})
-    .nqCustom("GAME.INFO"_sv, *this);
+  bundle = &resources().bundle("games"_sv, filename);
+  bundle->nqCustom("GAME.INFO"_sv, *this);
 }
 
 bool Game::load(data::RW &file) {
@@ -30,104 +29,155 @@ bool Game::load(data::RW &file) {
     return false;
   }
 
-  ScratchArray<char> raw{usize(size)};
-  if(!file.read(raw.view())) {
-    dialog::error("Failure"_sv,
-      "Could not load GAME.INFO for {}.",
-      name);
-    return false;
+  bool hasTitle = false;
+  bool hasAuthor = false;
+  bool hasDescription = false;
+  bool hasVersion = false;
+  bool hasBackground = false;
+  bool hasStartScene = false;
+  JSONReader reader{file, usize(size)};
+  StringView key;
+  StringView value;
+  reader.beginObject();
+  while(reader.nextKey(key)) {
+    if(key.equals("prefetch_window"_sv)) {
+      f64 window = 0;
+      if(!reader.readNumber(window)) {
+        break;
+      }
+      prefetchWindow = window < 0 ? 0 : usize(window);
+      continue;
+    }
+    if(key.equals("texture_budget"_sv)) {
+      f64 budget = 0;
+      if(!reader.readNumber(budget)) {
+        break;
+      }
+      textureBudget = budget < 0 ? 0 : usize(budget);
+      continue;
+    }
+    if(key.equals("render_height"_sv)) {
+      f64 height = 0;
+      if(!reader.readNumber(height)) {
+        break;
+      }
+      renderHeight = height < 0 ? 0 : usize(height);
+      continue;
+    }
+    if(reader.peek() != JSONReader::ValueString) {
+      if(!reader.skip()) {
+        break;
+      }
+      continue;
+    }
+    reader.readString(value);
+    if(key.equals("title"_sv)) {
+      title = value;
+      hasTitle = true;
+    } else if(key.equals("author"_sv)) {
+      author = value;
+      hasAuthor = true;
+    } else if(key.equals("description"_sv)) {
+      description = value;
+      hasDescription = true;
+    } else if(key.equals("version"_sv)) {
+      version = value;
+      hasVersion = true;
+    } else if(key.equals("logo"_sv)) {
+      logo = value;
+    } else if(key.equals("menu_background"_sv)) {
+      menuBackground = value;
+      hasBackground = true;
+    } else if(key.equals("start_scene"_sv)) {
+      startScene = value;
+      hasStartScene = true;
+    } else if(key.equals("atlas"_sv)) {
+      atlasManifest = value;
+    }
   }
 
-  auto res = json::parse(raw.view());
-  if(res.error != json::OK) {
+  if(reader.failed() || !reader.finish()) {
     dialog::error("Failure"_sv,
       "Could not parse GAME.INFO for {}:\n"
       "{}",
       name,
-      json::errorMessage(res.error));
-    return false;
-  }
-
-
-  auto root = json::Schema::object(*res.value);
-  if(!root.present()) {
-    dialog::error("Failure"_sv,
-      "Could not parse GAME.INFO for {}:\n"
-      "Expected object.",
-      name);
+      reader.error());
     return false;
   }
 
-  auto maybeTitle = root->expectStringField("title"_sv);
-  if(!maybeTitle.present()) {
+  if(!hasTitle) {
     dialog::warning("Warning",
       "Could not find title in GAME.INFO, fallback will be used.");
     title = name;
-  } else {
-    title = *maybeTitle;
   }
 
-  auto maybeAuthor = root->expectStringField("author"_sv);
-  if(!maybeAuthor.present()) {
+  if(!hasAuthor) {
     dialog::warning("Warning",
       "Could not find author in GAME.INFO, fallback will be used.");
     author = "Unknown"_sv;
-  } else {
-    author = *maybeAuthor;
   }
 
-  auto maybeDescription = root->expectStringField("description"_sv);
-  if(!maybeDescription.present()) {
+  if(!hasDescription) {
     dialog::warning("Warning",
       "Could not find description in GAME.INFO, fallback will be used.");
     description = "No description available."_sv;
-  } else {
-    description = *maybeDescription;
   }
 
-  auto maybeVersion = root->expectStringField("version"_sv);
-  if(!maybeVersion.present()) {
+  if(!hasVersion) {
     dialog::warning("Warning",
       "Could not find version in GAME.INFO, fallback will be used.");
     version = "0.0.0"_sv;
-  } else {
-    version = *maybeVersion;
-  }
-  auto maybeLogo = root->expectStringField("logo"_sv);
-  if(maybeLogo.present()) {
-    logo = *maybeLogo;
   }
 
-  auto maybeBackground = root->expectStringField("menu_background"_sv);
-  if(!maybeBackground.present()) {
+  if(!hasBackground) {
     dialog::warning("Warning",
       "Could not find background in GAME.INFO, fallback will be used.");
-  } else {
-    menuBackground = *maybeBackground;
   }
 
-  auto maybeStartScene = root->expectStringField("start_scene"_sv);
-  if(!maybeStartScene.present()) {
+  if(!hasStartScene) {
     dialog::error("Failure",
     "Could not find start_scene in GAME.INFO.");
     return false;
   }
-  startScene = *maybeStartScene;
 
   return true;
 }
 
 bool Game::save(data::RW &file) {
-  json::ObjectBuilder builder;
-  builder.set("title"_sv, title.view());
-  builder.set("author"_sv, author.view());
-  builder.set("description"_sv, description.view());
-  builder.set("version"_sv, version.view());
-  builder.set("logo"_sv, logo.view());
-  builder.set("menu_background"_sv, menuBackground.view());
-  builder.set("start_scene"_sv, startScene.view());
-  auto str = json::encode(builder.finish());
-  return file.write(str.view());
+  JSONWriter writer{file};
+  writer.beginObject();
+  writer.key("title"_sv);
+  writer.string(title.view());
+  writer.key("author"_sv);
+  writer.string(author.view());
+  writer.key("description"_sv);
+  writer.string(description.view());
+  writer.key("version"_sv);
+  writer.string(version.view());
+  writer.key("logo"_sv);
+  writer.string(logo.view());
+  writer.key("menu_background"_sv);
+  writer.string(menuBackground.view());
+  writer.key("start_scene"_sv);
+  writer.string(startScene.view());
+  if(prefetchWindow != cDefaultPrefetchWindow) {
+    writer.key("prefetch_window"_sv);
+    writer.integer(s64(prefetchWindow));
+  }
+  if(!atlasManifest.empty()) {
+    writer.key("atlas"_sv);
+    writer.string(atlasManifest.view());
+  }
+  if(textureBudget != cDefaultTextureBudget) {
+    writer.key("texture_budget"_sv);
+    writer.integer(s64(textureBudget));
+  }
+  if(renderHeight != 0) {
+    writer.key("render_height"_sv);
+    writer.integer(s64(renderHeight));
+  }
+  writer.endObject();
+  return writer.finish();
 }
 
 } // namespace sigmoid
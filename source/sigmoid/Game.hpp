@@ -6,14 +6,18 @@ Game.hpp
 Defines game information
 */
 
+#include "Atlas.hpp"
 #include <nwge/common/string.hpp>
 #include <nwge/data/bundle.hpp>
 
 namespace sigmoid {
 
+static constexpr usize cDefaultPrefetchWindow = 8;
+static constexpr usize cDefaultTextureBudget = 256; // -> MiB
+
 class Game {
 public:
-  nwge::data::Bundle bundle;
+  nwge::data::Bundle *bundle = nullptr; // -> owned by the resource cache
   nwge::String<> name;        // -> name of bundle file
   nwge::String<> title;       // -> title of game shown in menu
   nwge::String<> author;
@@ -22,6 +26,11 @@ class Game {
   nwge::String<> logo;           // -> filename of logo graphic, can be empty
   nwge::String<> menuBackground; // -> menu background graphic, can be empty
   nwge::String<> startScene;
+  nwge::String<> atlasManifest;  // -> sheet atlas written by the bundle plugin, can be empty
+  Atlas atlas;                   // -> loaded along with the first scene
+  usize prefetchWindow = cDefaultPrefetchWindow; // -> commands to load assets ahead for
+  usize textureBudget = cDefaultTextureBudget;   // -> MiB of textures kept resident
+  usize renderHeight = 0;        // -> pixels tall frames are drawn at, 0 for the window's
 
   Game(const nwge::StringView &name);
   Game(Game&&) = default;
@@ -1,3 +1,5 @@
+#include "DrawList.hpp"
+#include "Redraw.hpp"
 #include "imgui/imgui.hpp"
 #include "states.hpp"
 #include <nwge/render/AspectRatio.hpp>
@@ -35,14 +37,16 @@ class GameInfoEditorSubState final: public SubState {
   }
 
   void render() const override {
+    redraw().frame();
     render::clear({0, 0, 0});
     if(mShowBackground) {
-      m4x3.rect({
+      drawList().image(m4x3.rect({
         {0, 0, 0.9},
         {1, 1},
         mBackground.id
-      }).draw();
+      }), false);
     }
+    drawList().flush();
   }
 
 private:
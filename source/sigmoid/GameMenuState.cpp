@@ -1,10 +1,15 @@
+#include "CachedElement.hpp"
+#include "Debug.hpp"
+#include "DrawList.hpp"
+#include "Redraw.hpp"
+#include "RenderTarget.hpp"
 #include "states.hpp"
 #include "imgui/imgui.hpp"
 #include <nwge/render/AspectRatio.hpp>
 #include <nwge/render/draw.hpp>
 #include <nwge/render/Font.hpp>
-#include <nwge/render/Texture.hpp>
 #include <nwge/render/window.hpp>
+#include <array>
 
 using namespace nwge;
 
@@ -29,30 +34,47 @@ class GameMenuState final: public State {
   {}
 
   bool preload() override {
-    mBundle
-      .load({"sigmoid.bndl"_sv})
-      .nqFont("INTER.CFN"_sv, mFont);
+    auto &cache = resources();
+    mFont = engineFont();
 
     mHasLogo = !mGame.logo.empty();
     if(mHasLogo) {
-      mGame.bundle.nqTexture(mGame.logo, mLogo);
+      mLogo = cache.image(*mGame.bundle, mGame.logo);
     }
 
     mHasBackground = !mGame.menuBackground.empty();
     if(mHasBackground) {
-      mGame.bundle.nqTexture(mGame.menuBackground, mBackground);
+      mBackground = cache.image(*mGame.bundle, mGame.menuBackground);
     }
     return true;
   }
 
   bool init() override {
-    if(mHasLogo) {
-      glm::ivec2 logoSize = mLogo.size();
+    // coming back from a scene, its textures can go now
+    auto &cache = resources();
+    cache.loaded();
+    cache.trim();
+    if(statsEnabled()) {
+      cache.printStats();
+      redraw().printStats();
+      drawList().printStats();
+    }
+    return true;
+  }
+
+  bool tick([[maybe_unused]] f32 delta) override {
+    resources().update();
+    // images are still being decoded on the first frames
+    if(mHasLogo && !mLogoSized && mLogo.resident()) {
+      glm::ivec2 logoSize = mLogo->size();
       mLogoExtents = {
         cLogoH*f32(logoSize.x)/f32(logoSize.y),
         cLogoH
       };
+      mLogoSized = true;
     }
+    // hovering & clicking come in as events, which wake the loop by themselves
+    redraw().idle();
     return true;
   }
 
@@ -84,30 +106,39 @@ class GameMenuState final: public State {
   }
 
   void render() const override {
+    redraw().frame();
+    ScaledFrame frame;
     render::clear({0, 0, 0});
-    if(mHasBackground) {
-      m4x3.rect({
-        cBackgroundPos, cBackgroundExtents, mBackground.id
-      }).draw();
+    auto &list = drawList();
+    // until the images are uploaded, their IDs are 0
+    u32 background = mHasBackground ? mBackground.use().id() : 0;
+    if(background != 0) {
+      list.image(m4x3.rect({
+        cBackgroundPos, cBackgroundExtents, background
+      }), mBackground->premultiplied());
     } else {
-      render::color(cBackgroundColor);
-      m4x3.rect({
-        cBackgroundPos, cBackgroundExtents
-      }).draw();
-      render::color();
+      auto rect = m4x3.rect({cBackgroundPos, cBackgroundExtents});
+      list.color(cBackgroundColor);
+      list.rect(rect.pos, rect.size);
+      list.color();
     }
 
     if(mHasLogo) {
-      drawRect(cLogoPos, mLogoExtents, mLogo);
+      const auto &logo = mLogo.use();
+      if(logo.id() != 0) {
+        list.image({m4x3.pos(cLogoPos), m1x1.size(mLogoExtents), logo.id()},
+          logo.premultiplied());
+      }
     } else {
-      drawText(mGame.title, cLogoPos, cBigText);
+      list.text(*mFont, mGame.title, m4x3.pos(cLogoPos), cBigText);
     }
 
-    drawButton(ButtonNew, "New Game"_sv);
-    drawButton(ButtonLoad, "Load Game"_sv);
-    drawButton(ButtonExit, "Exit"_sv);
+    drawButton(list, ButtonNew, "New Game"_sv);
+    drawButton(list, ButtonLoad, "Load Game"_sv);
+    drawButton(list, ButtonExit, "Exit"_sv);
+    list.flush();
 
-    auto cursor = mFont.cursor(m4x3.pos(cTitlePos), cSmallText);
+    auto cursor = mFont->cursor(m4x3.pos(cTitlePos), cSmallText);
     cursor
       << mGame.title << '\n'
       << "by "_sv << mGame.author << '\n'
@@ -116,8 +147,7 @@ class GameMenuState final: public State {
   }
 
 private:
-  data::Bundle mBundle;
-  render::Font mFont;
+  SharedFont mFont;
 
   Game mGame;
 
@@ -128,29 +158,25 @@ class GameMenuState final: public State {
   ) const {
     render::rect(m4x3.pos(pos), m1x1.size(extents));
   }
-  constexpr inline void drawRect(
-    glm::vec3 pos, glm::vec2 extents, const render::Texture &texture
-  ) const {
-    render::rect(m4x3.pos(pos), m1x1.size(extents), texture);
-  }
   constexpr inline void drawText(
     const StringView &text, glm::vec3 pos, f32 height
   ) const {
-    mFont.draw(text, m4x3.pos(pos), height);
+    mFont->draw(text, m4x3.pos(pos), height);
   }
 
   bool mHasBackground = false;
-  render::Texture mBackground;
+  SharedImage mBackground;
   static constexpr glm::vec3 cBackgroundPos{0, 0, 0.9f};
   static constexpr glm::vec2 cBackgroundExtents{1, 1};
   static constexpr glm::vec3 cBackgroundColor{0.1f, 0.1f, 0.1f};
 
   bool mHasLogo = false;
-  render::Texture mLogo;
+  SharedImage mLogo;
   static constexpr glm::vec3 cLogoPos{0.1f, 0.1f, 0.5f};
   static constexpr f32 cLogoH = 0.15f;
   static constexpr glm::vec2 cDefaultLogoExtents{3*cLogoH, cLogoH};
   glm::vec2 mLogoExtents = cDefaultLogoExtents;
+  bool mLogoSized = false;
 
   MenuButton mHover = ButtonInvalid;
   MenuButton mSelection = ButtonInvalid;
@@ -172,7 +198,23 @@ class GameMenuState final: public State {
   static constexpr glm::vec3 cButtonHoverColor{0.5f, 0.5f, 0.5f};
   static constexpr glm::vec3 cButtonSelectColor{0.7f, 0.7f, 0.7f};
 
-  constexpr inline void drawButton(MenuButton idx, const StringView &text) const {
+  // buttons only change when hovered or selected, so they're cached
+  mutable std::array<CachedElement, ButtonMax> mButtons;
+
+  void drawButton(DrawList &list, MenuButton idx, const StringView &text) const {
+    glm::vec3 bgOff{0, f32(idx) * cButtonExtents.y, 0};
+    u64 state = idx == mSelection ? 2 : idx == mHover ? 1 : 0;
+    auto &button = mButtons[idx];
+    if(button.begin(CachedElement::key(text, CachedElement::key(state)),
+      m4x3.pos(cButtonAnchor + bgOff), m1x1.size(cButtonExtents)))
+    {
+      drawButtonContents(idx, text);
+      button.end();
+    }
+    button.draw(list);
+  }
+
+  void drawButtonContents(MenuButton idx, const StringView &text) const {
     glm::vec3 bgOff{0, f32(idx) * cButtonExtents.y, 0};
     if(idx == mSelection) {
       render::color(cButtonSelectColor);
@@ -0,0 +1,153 @@
+#include "Image.hpp"
+#include "GL.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace sigmoid {
+
+Image::Image(Image &&other) noexcept
+  : mID(std::exchange(other.mID, 0)),
+    mSize(std::exchange(other.mSize, {0, 0})),
+    mSourceSize(std::exchange(other.mSourceSize, {0, 0})),
+    mBytes(std::exchange(other.mBytes, 0)),
+    mUploadedRows(std::exchange(other.mUploadedRows, 0)),
+    mPremultiplied(std::exchange(other.mPremultiplied, false))
+{}
+
+Image &Image::operator=(Image &&other) noexcept {
+  if(this != &other) {
+    destroy();
+    mID = std::exchange(other.mID, 0);
+    mSize = std::exchange(other.mSize, {0, 0});
+    mSourceSize = std::exchange(other.mSourceSize, {0, 0});
+    mBytes = std::exchange(other.mBytes, 0);
+    mUploadedRows = std::exchange(other.mUploadedRows, 0);
+    mPremultiplied = std::exchange(other.mPremultiplied, false);
+  }
+  return *this;
+}
+
+Image::~Image() {
+  destroy();
+}
+
+void Image::create(glm::ivec2 size, glm::ivec2 sourceSize, usize levels,
+  bool premultiplied)
+{
+  destroy();
+  GLuint id = 0;
+  gl().genTextures(1, &id);
+  mID = id;
+  mSize = size;
+  mSourceSize = sourceSize;
+  mBytes = 0;
+  mUploadedRows = 0;
+  mPremultiplied = premultiplied;
+
+  BindTexture bind{mID};
+  gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+    levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels - 1));
+  glm::ivec2 levelSize = size;
+  for(usize level = 0; level < levels; ++level) {
+    gl().texImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA8, levelSize.x, levelSize.y, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    mBytes += usize(levelSize.x) * usize(levelSize.y) * 4;
+    levelSize = {std::max(levelSize.x / 2, 1), std::max(levelSize.y / 2, 1)};
+  }
+}
+
+bool Image::upload(const Pixels &pixels) {
+  return uploadBand(pixels.data.data());
+}
+
+/*
+The smaller levels add up to a third of the first one at most, so they go in
+one go rather than being spread over more frames.
+*/
+bool Image::upload(const CookedTexture &texture, usize baseLevel) {
+  if(!uploadBand(texture.levelPixels(baseLevel))) {
+    return false;
+  }
+  BindTexture bind{mID};
+  for(usize level = baseLevel + 1; level < texture.levelCount(); ++level) {
+    glm::ivec2 size = texture.levelSize(level);
+    gl().texSubImage2D(GL_TEXTURE_2D, GLint(level - baseLevel), 0, 0,
+      size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, texture.levelPixels(level));
+  }
+  return true;
+}
+
+bool Image::uploadBand(const u8 *pixels) {
+  if(mUploadedRows >= mSize.y) {
+    return true;
+  }
+  s32 rows = SDL_min(cBandRows, mSize.y - mUploadedRows);
+  const u8 *band = pixels + usize(mUploadedRows) * usize(mSize.x) * 4;
+
+  BindTexture bind{mID};
+  // RGBA8 rows are always 4-byte aligned
+  gl().pixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  gl().texSubImage2D(GL_TEXTURE_2D, 0, 0, mUploadedRows, mSize.x, rows,
+    GL_RGBA, GL_UNSIGNED_BYTE, band);
+  mUploadedRows += rows;
+  return mUploadedRows >= mSize.y;
+}
+
+u32 Image::id() const {
+  return mID;
+}
+
+glm::ivec2 Image::size() const {
+  return mSize;
+}
+
+glm::ivec2 Image::sourceSize() const {
+  return mSourceSize;
+}
+
+usize Image::bytes() const {
+  return mBytes;
+}
+
+bool Image::premultiplied() const {
+  return mPremultiplied;
+}
+
+void Image::destroy() {
+  if(mID != 0) {
+    GLuint id = mID;
+    gl().deleteTextures(1, &id);
+    mID = 0;
+  }
+}
+
+BlendImage::BlendImage(const Image &image)
+  : BlendImage(image.premultiplied())
+{}
+
+BlendImage::BlendImage(bool premultiplied)
+  : mSwitched(premultiplied)
+{
+  if(!mSwitched) {
+    return;
+  }
+  gl().getIntegerv(GL_BLEND_SRC_RGB, &mPrevious[0]);
+  gl().getIntegerv(GL_BLEND_DST_RGB, &mPrevious[1]);
+  gl().getIntegerv(GL_BLEND_SRC_ALPHA, &mPrevious[2]);
+  gl().getIntegerv(GL_BLEND_DST_ALPHA, &mPrevious[3]);
+  gl().blendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+    GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+BlendImage::~BlendImage() {
+  if(mSwitched) {
+    gl().blendFuncSeparate(GLenum(mPrevious[0]), GLenum(mPrevious[1]),
+      GLenum(mPrevious[2]), GLenum(mPrevious[3]));
+  }
+}
+
+} // namespace sigmoid
@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+Image.hpp
+---------
+Textures uploaded from decoded pixels
+*/
+
+#include "CookedTexture.hpp"
+#include "PNG.hpp"
+#include <array>
+
+namespace sigmoid {
+
+/**
+ * @brief GPU texture filled from `Pixels` the game decoded itself.
+ *
+ * Unlike `nwge::render::Texture`, an image can be uploaded a band of rows at a
+ * time, so a large one can be spread over several frames. Draw it by passing
+ * `id()` to `nwge::render::Rect`, within a `BlendImage` for images with
+ * premultiplied alpha.
+ *
+ * Must only be used on the main thread.
+ */
+class Image {
+public:
+  // Rows uploaded by one `upload()` step.
+  static constexpr s32 cBandRows = 64;
+
+  Image() = default;
+  Image(const Image&) = delete;
+  Image(Image &&other) noexcept;
+  Image &operator=(const Image&) = delete;
+  Image &operator=(Image &&other) noexcept;
+  ~Image();
+
+  // Allocates storage for an image of `size` with `levels` mip levels, which
+  // was downscaled from `sourceSize`.
+  void create(glm::ivec2 size, glm::ivec2 sourceSize, usize levels = 1,
+    bool premultiplied = false);
+  // Uploads the next band of rows. Returns true once every row is uploaded.
+  bool upload(const Pixels &pixels);
+  // Uploads the next band of rows of `baseLevel`, and every smaller level
+  // along with the last band. Returns true once everything is uploaded.
+  bool upload(const CookedTexture &texture, usize baseLevel);
+
+  [[nodiscard]]
+  u32 id() const;
+  [[nodiscard]]
+  glm::ivec2 size() const;
+  [[nodiscard]]
+  glm::ivec2 sourceSize() const;
+  [[nodiscard]]
+  usize bytes() const;
+  [[nodiscard]]
+  bool premultiplied() const;
+
+private:
+  u32 mID = 0;
+  glm::ivec2 mSize{0, 0};
+  glm::ivec2 mSourceSize{0, 0};
+  usize mBytes = 0;
+  s32 mUploadedRows = 0;
+  bool mPremultiplied = false;
+
+  void destroy();
+  bool uploadBand(const u8 *pixels);
+};
+
+/**
+ * @brief Switches to premultiplied alpha blending for the lifetime of the
+ * object, if the image needs it.
+ */
+class BlendImage {
+public:
+  BlendImage(const Image &image);
+  // For textures which aren't images, such as render targets.
+  explicit BlendImage(bool premultiplied);
+  BlendImage(const BlendImage&) = delete;
+  BlendImage(BlendImage&&) = delete;
+  BlendImage &operator=(const BlendImage&) = delete;
+  BlendImage &operator=(BlendImage&&) = delete;
+  ~BlendImage();
+
+private:
+  bool mSwitched = false;
+  std::array<s32, 4> mPrevious{}; // -> source & destination factors, RGB then alpha
+};
+
+} // namespace sigmoid
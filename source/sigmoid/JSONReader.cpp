@@ -0,0 +1,435 @@
+#include "JSONReader.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+// deeper nesting than this is refused by `skip()` rather than overflowing
+static constexpr usize cMaxDepth = 256;
+static constexpr usize cMaxNumberLength = 64;
+
+JSONReader::JSONReader(data::RW &file, usize size, const StringView &prefix)
+  : mFile(&file),
+    mRemaining(size - prefix.size()),
+    mBuffer(cBufferSize)
+{
+  std::memcpy(mBuffer.data(), prefix.begin(), prefix.size());
+  mCur = mBuffer.data();
+  mEnd = mCur + prefix.size();
+}
+
+JSONReader::JSONReader(const StringView &text)
+  : mCur(text.begin()),
+    mEnd(text.end())
+{}
+
+bool JSONReader::beginObject() {
+  if(!expect('{')) {
+    return fail("Expected object");
+  }
+  mAfterValue = false;
+  return true;
+}
+
+bool JSONReader::nextKey(StringView &key) {
+  bool closed = false;
+  if(!separator('}', closed) || closed) {
+    return false;
+  }
+  if(!readStringInto(mKey)) {
+    return fail("Expected key");
+  }
+  if(!expect(':')) {
+    return fail("Expected `:`");
+  }
+  key = {mKey.begin(), mKey.size()};
+  mAfterValue = false;
+  return true;
+}
+
+bool JSONReader::beginArray() {
+  if(!expect('[')) {
+    return fail("Expected array");
+  }
+  mAfterValue = false;
+  return true;
+}
+
+bool JSONReader::nextElement() {
+  bool closed = false;
+  return separator(']', closed) && !closed;
+}
+
+JSONReader::ValueType JSONReader::peek() {
+  switch(skipWhitespace()) {
+  case '{':
+    return ValueObject;
+  case '[':
+    return ValueArray;
+  case '"':
+    return ValueString;
+  case 't':
+  case 'f':
+    return ValueBoolean;
+  case 'n':
+    return ValueNull;
+  case '-':
+  case '0': case '1': case '2': case '3': case '4':
+  case '5': case '6': case '7': case '8': case '9':
+    return ValueNumber;
+  default:
+    return ValueInvalid;
+  }
+}
+
+bool JSONReader::readString(StringView &out) {
+  if(!readStringInto(mString)) {
+    return fail("Expected string");
+  }
+  out = {mString.begin(), mString.size()};
+  mAfterValue = true;
+  return true;
+}
+
+bool JSONReader::readNumber(f64 &out) {
+  if(peek() != ValueNumber) {
+    return fail("Expected number");
+  }
+  std::array<char, cMaxNumberLength> digits{};
+  usize count = 0;
+  for(;;) {
+    int chr = peekChar();
+    bool numeric = (chr >= '0' && chr <= '9')
+      || chr == '-' || chr == '+' || chr == '.' || chr == 'e' || chr == 'E';
+    if(!numeric) {
+      break;
+    }
+    if(count == digits.size()) {
+      return fail("Invalid number");
+    }
+    digits[count++] = char(getChar());
+  }
+  const char *end = digits.data() + count;
+  auto res = std::from_chars(digits.data(), end, out);
+  if(res.ec != std::errc{} || res.ptr != end) {
+    return fail("Invalid number");
+  }
+  mAfterValue = true;
+  return true;
+}
+
+bool JSONReader::readBoolean(bool &out) {
+  if(peek() != ValueBoolean) {
+    return fail("Expected boolean");
+  }
+  out = peekChar() == 't';
+  if(!readLiteral(out ? "true"_sv : "false"_sv)) {
+    return false;
+  }
+  mAfterValue = true;
+  return true;
+}
+
+bool JSONReader::readVec2(glm::vec2 &out) {
+  f64 x = 0;
+  f64 y = 0;
+  if(!beginArray()
+  || !nextElement() || !readNumber(x)
+  || !nextElement() || !readNumber(y)) {
+    return fail("Expected [x, y] array");
+  }
+  if(nextElement()) {
+    return fail("Expected [x, y] array");
+  }
+  if(mFailed) {
+    return false;
+  }
+  out = {f32(x), f32(y)};
+  return true;
+}
+
+bool JSONReader::skip() {
+  return skip(0);
+}
+
+bool JSONReader::skip(usize depth) {
+  if(depth == cMaxDepth) {
+    return fail("Nested too deeply");
+  }
+  switch(peek()) {
+  case ValueObject: {
+    StringView key;
+    beginObject();
+    while(nextKey(key)) {
+      if(!skip(depth + 1)) {
+        return false;
+      }
+    }
+    return !mFailed;
+  }
+  case ValueArray:
+    beginArray();
+    while(nextElement()) {
+      if(!skip(depth + 1)) {
+        return false;
+      }
+    }
+    return !mFailed;
+  case ValueString: {
+    StringView str;
+    return readString(str);
+  }
+  case ValueNumber: {
+    f64 number = 0;
+    return readNumber(number);
+  }
+  case ValueBoolean: {
+    bool boolean = false;
+    return readBoolean(boolean);
+  }
+  case ValueNull:
+    if(!readLiteral("null"_sv)) {
+      return false;
+    }
+    mAfterValue = true;
+    return true;
+  case ValueInvalid:
+    break;
+  }
+  return fail("Expected value");
+}
+
+bool JSONReader::finish() {
+  if(skipWhitespace() != -1) {
+    return fail("Unexpected data after end");
+  }
+  return !mFailed;
+}
+
+bool JSONReader::failed() const {
+  return mFailed;
+}
+
+StringView JSONReader::error() const {
+  return {mError.data(), mErrorSize};
+}
+
+// Only the first error is kept, later ones are usually caused by it.
+bool JSONReader::fail(const char *message) {
+  if(mFailed) {
+    return false;
+  }
+  mFailed = true;
+  int size = std::snprintf(mError.data(), mError.size(),
+    "%s on line %zu.", message, mLine);
+  mErrorSize = size < 0 ? 0 : std::min(usize(size), mError.size() - 1);
+  return false;
+}
+
+bool JSONReader::refill() {
+  if(mFile == nullptr || mRemaining == 0 || mFailed) {
+    return false;
+  }
+  usize count = std::min(mRemaining, mBuffer.size());
+  if(!mFile->read(ArrayView<char>{mBuffer.data(), count})) {
+    fail("Could not read file");
+    return false;
+  }
+  mRemaining -= count;
+  mCur = mBuffer.data();
+  mEnd = mCur + count;
+  return true;
+}
+
+int JSONReader::peekChar() {
+  if(mCur == mEnd && !refill()) {
+    return -1;
+  }
+  return u8(*mCur);
+}
+
+int JSONReader::getChar() {
+  if(mCur == mEnd && !refill()) {
+    return -1;
+  }
+  char chr = *mCur++;
+  if(chr == '\n') {
+    ++mLine;
+  }
+  return u8(chr);
+}
+
+int JSONReader::skipWhitespace() {
+  for(;;) {
+    int chr = peekChar();
+    if(chr != ' ' && chr != '\t' && chr != '\n' && chr != '\r') {
+      return chr;
+    }
+    getChar();
+  }
+}
+
+bool JSONReader::expect(char chr) {
+  if(mFailed || skipWhitespace() != u8(chr)) {
+    return false;
+  }
+  getChar();
+  return true;
+}
+
+/*
+Reads what comes between the members of an object or array: either the closing
+bracket, or a comma if a member came before.
+*/
+bool JSONReader::separator(char close, bool &closed) {
+  if(mFailed) {
+    return false;
+  }
+  int chr = skipWhitespace();
+  if(chr == u8(close)) {
+    getChar();
+    closed = true;
+    mAfterValue = true;
+    return true;
+  }
+  if(chr == -1) {
+    return fail("Unexpected end of file");
+  }
+  if(mAfterValue) {
+    if(chr != ',') {
+      return fail("Expected `,`");
+    }
+    getChar();
+  }
+  closed = false;
+  return true;
+}
+
+bool JSONReader::readStringInto(Slice<char> &out) {
+  if(!expect('"')) {
+    return false;
+  }
+  out.clear();
+  for(;;) {
+    int chr = getChar();
+    switch(chr) {
+    case -1:
+      return fail("Unexpected end of file");
+    case '"':
+      return true;
+    case '\\':
+      if(!readEscape(out)) {
+        return false;
+      }
+      break;
+    default:
+      if(chr < 0x20) {
+        return fail("Control character in string");
+      }
+      out.push(char(chr));
+      break;
+    }
+  }
+}
+
+static int hexDigit(int chr) {
+  if(chr >= '0' && chr <= '9') {
+    return chr - '0';
+  }
+  if(chr >= 'a' && chr <= 'f') {
+    return chr - 'a' + 10;
+  }
+  if(chr >= 'A' && chr <= 'F') {
+    return chr - 'A' + 10;
+  }
+  return -1;
+}
+
+bool JSONReader::readEscape(Slice<char> &out) {
+  int chr = getChar();
+  switch(chr) {
+  case '"':
+  case '\\':
+  case '/':
+    out.push(char(chr));
+    return true;
+  case 'b':
+    out.push('\b');
+    return true;
+  case 'f':
+    out.push('\f');
+    return true;
+  case 'n':
+    out.push('\n');
+    return true;
+  case 'r':
+    out.push('\r');
+    return true;
+  case 't':
+    out.push('\t');
+    return true;
+  case 'u':
+    break;
+  default:
+    return fail("Invalid escape sequence");
+  }
+
+  auto readCodeUnit = [this](u32 &unit) {
+    unit = 0;
+    for(int i = 0; i < 4; ++i) {
+      int digit = hexDigit(getChar());
+      if(digit < 0) {
+        return false;
+      }
+      unit = (unit << 4) | u32(digit);
+    }
+    return true;
+  };
+
+  u32 code = 0;
+  if(!readCodeUnit(code)) {
+    return fail("Invalid escape sequence");
+  }
+  if(code >= 0xD800 && code <= 0xDBFF) {
+    // high surrogate, must be followed by the low one
+    u32 low = 0;
+    if(getChar() != '\\' || getChar() != 'u' || !readCodeUnit(low)
+    || low < 0xDC00 || low > 0xDFFF) {
+      return fail("Invalid escape sequence");
+    }
+    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+  } else if(code >= 0xDC00 && code <= 0xDFFF) {
+    return fail("Invalid escape sequence");
+  }
+
+  if(code < 0x80) {
+    out.push(char(code));
+  } else if(code < 0x800) {
+    out.push(char(0xC0 | (code >> 6)));
+    out.push(char(0x80 | (code & 0x3F)));
+  } else if(code < 0x10000) {
+    out.push(char(0xE0 | (code >> 12)));
+    out.push(char(0x80 | ((code >> 6) & 0x3F)));
+    out.push(char(0x80 | (code & 0x3F)));
+  } else {
+    out.push(char(0xF0 | (code >> 18)));
+    out.push(char(0x80 | ((code >> 12) & 0x3F)));
+    out.push(char(0x80 | ((code >> 6) & 0x3F)));
+    out.push(char(0x80 | (code & 0x3F)));
+  }
+  return true;
+}
+
+bool JSONReader::readLiteral(const StringView &literal) {
+  for(char chr: literal) {
+    if(getChar() != u8(chr)) {
+      return fail("Invalid literal");
+    }
+  }
+  return true;
+}
+
+} // namespace sigmoid
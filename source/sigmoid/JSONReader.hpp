@@ -0,0 +1,109 @@
+#pragma once
+
+/*
+JSONReader.hpp
+--------------
+Streaming JSON reader
+*/
+
+#include <array>
+#include <glm/glm.hpp>
+#include <nwge/common/array.hpp>
+#include <nwge/common/slice.hpp>
+#include <nwge/common/string.hpp>
+#include <nwge/data/rw.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Pull-style JSON reader.
+ *
+ * Values are read one at a time, in file order, straight from the input
+ * buffer. No document tree is ever built: loaders ask for the value they expect
+ * next and store it wherever it belongs. When reading from a file, only
+ * `cBufferSize` bytes of it are held in memory at a time.
+ *
+ * Every function returns false on failure. The reader stays failed from then
+ * on, and `error()` describes the first error along with its line.
+ *
+ * Strings returned by the reader are only valid until the next key or string
+ * of the same kind is read, so they must be copied to be kept.
+ */
+class JSONReader {
+public:
+  static constexpr usize cBufferSize = 16 * 1024;
+
+  enum ValueType {
+    ValueInvalid = -1,
+    ValueObject,
+    ValueArray,
+    ValueString,
+    ValueNumber,
+    ValueBoolean,
+    ValueNull,
+  };
+
+  // Reads `size` bytes of `file`. `prefix` holds bytes which were already read
+  // from the start of the file.
+  JSONReader(nwge::data::RW &file, usize size,
+    const nwge::StringView &prefix = {});
+  // Reads text which is already in memory.
+  JSONReader(const nwge::StringView &text);
+
+  bool beginObject();
+  // Reads the next key of the current object. Returns false at the end of the
+  // object, check `failed()` to tell that apart from an error.
+  bool nextKey(nwge::StringView &key);
+  bool beginArray();
+  // Moves to the next element of the current array. Returns false at the end
+  // of the array, check `failed()` to tell that apart from an error.
+  bool nextElement();
+
+  // Returns the type of the next value, without reading it.
+  ValueType peek();
+  bool readString(nwge::StringView &out);
+  bool readNumber(f64 &out);
+  bool readBoolean(bool &out);
+  // Reads an [x, y] array.
+  bool readVec2(glm::vec2 &out);
+  // Skips over the next value, whatever it is.
+  bool skip();
+  // Checks that nothing but whitespace is left.
+  bool finish();
+
+  [[nodiscard]]
+  bool failed() const;
+  [[nodiscard]]
+  nwge::StringView error() const;
+
+private:
+  nwge::data::RW *mFile = nullptr;
+  usize mRemaining = 0;
+  nwge::Array<char> mBuffer;
+  const char *mCur = nullptr;
+  const char *mEnd = nullptr;
+  usize mLine = 1;
+  // false right after `{`, `[` or `:`, true once a value is complete
+  bool mAfterValue = false;
+
+  nwge::Slice<char> mKey{64};
+  nwge::Slice<char> mString{256};
+
+  bool mFailed = false;
+  std::array<char, 96> mError{};
+  usize mErrorSize = 0;
+
+  bool fail(const char *message);
+  bool refill();
+  int peekChar();
+  int getChar();
+  int skipWhitespace();
+  bool expect(char chr);
+  bool separator(char close, bool &closed);
+  bool readStringInto(nwge::Slice<char> &out);
+  bool readEscape(nwge::Slice<char> &out);
+  bool readLiteral(const nwge::StringView &literal);
+  bool skip(usize depth);
+};
+
+} // namespace sigmoid
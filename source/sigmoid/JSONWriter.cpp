@@ -0,0 +1,196 @@
+#include "JSONWriter.hpp"
+#include <charconv>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+static constexpr usize cIndent = 2;
+// enough for any f64 or s64 printed by std::to_chars
+using NumberBuffer = std::array<char, 32>;
+
+template<typename T>
+static StringView formatNumber(NumberBuffer &out, T value) {
+  auto res = std::to_chars(out.data(), out.data() + out.size(), value);
+  return {out.data(), usize(res.ptr - out.data())};
+}
+
+JSONWriter::JSONWriter(data::RW &file)
+  : mFile(file)
+{}
+
+void JSONWriter::beginObject() {
+  member();
+  put('{');
+  ++mDepth;
+  mFirst = true;
+}
+
+void JSONWriter::endObject() {
+  end('}');
+}
+
+void JSONWriter::beginArray() {
+  member();
+  put('[');
+  ++mDepth;
+  mFirst = true;
+}
+
+void JSONWriter::endArray() {
+  end(']');
+}
+
+void JSONWriter::key(const StringView &key) {
+  string(key);
+  put(": "_sv);
+  mAfterKey = true;
+}
+
+void JSONWriter::string(const StringView &value) {
+  static constexpr std::array<char, 16> cHexDigits{
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+  };
+
+  member();
+  put('"');
+  for(char chr: value) {
+    switch(chr) {
+    case '"':
+      put("\\\""_sv);
+      break;
+    case '\\':
+      put("\\\\"_sv);
+      break;
+    case '\n':
+      put("\\n"_sv);
+      break;
+    case '\r':
+      put("\\r"_sv);
+      break;
+    case '\t':
+      put("\\t"_sv);
+      break;
+    default:
+      if(u8(chr) < 0x20) {
+        put("\\u00"_sv);
+        put(cHexDigits[u8(chr) >> 4]);
+        put(cHexDigits[u8(chr) & 0xF]);
+      } else {
+        put(chr);
+      }
+      break;
+    }
+  }
+  put('"');
+}
+
+void JSONWriter::number(f64 value) {
+  member();
+  NumberBuffer digits;
+  put(formatNumber(digits, value));
+}
+
+void JSONWriter::number(f32 value) {
+  // printed as a float, so 0.3f comes out as 0.3 rather than 0.30000001...
+  member();
+  NumberBuffer digits;
+  put(formatNumber(digits, value));
+}
+
+void JSONWriter::integer(s64 value) {
+  member();
+  NumberBuffer digits;
+  put(formatNumber(digits, value));
+}
+
+void JSONWriter::boolean(bool value) {
+  member();
+  put(value ? "true"_sv : "false"_sv);
+}
+
+void JSONWriter::vec2(glm::vec2 value) {
+  pair(value.x, value.y);
+}
+
+void JSONWriter::ivec2(glm::ivec2 value) {
+  pair(s64(value.x), s64(value.y));
+}
+
+// Pairs are kept on one line, like `[0.3, 0.6]` in hand-written scenes.
+template<typename T>
+void JSONWriter::pair(T x, T y) {
+  member();
+  NumberBuffer digits;
+  put('[');
+  put(formatNumber(digits, x));
+  put(", "_sv);
+  put(formatNumber(digits, y));
+  put(']');
+}
+
+bool JSONWriter::finish() {
+  put('\n');
+  flush();
+  return !mFailed;
+}
+
+/*
+Called before every value. Values directly after a key stay on the key's line,
+everything else starts a new, indented line.
+*/
+void JSONWriter::member() {
+  if(mAfterKey) {
+    mAfterKey = false;
+    return;
+  }
+  if(mDepth == 0) {
+    return;
+  }
+  if(!mFirst) {
+    put(',');
+  }
+  mFirst = false;
+  put('\n');
+  for(usize i = 0; i < mDepth * cIndent; ++i) {
+    put(' ');
+  }
+}
+
+void JSONWriter::end(char close) {
+  --mDepth;
+  if(!mFirst) {
+    put('\n');
+    for(usize i = 0; i < mDepth * cIndent; ++i) {
+      put(' ');
+    }
+  }
+  put(close);
+  mFirst = false;
+}
+
+void JSONWriter::put(char chr) {
+  if(mSize == mBuffer.size()) {
+    flush();
+  }
+  mBuffer[mSize++] = chr;
+}
+
+void JSONWriter::put(const StringView &str) {
+  for(char chr: str) {
+    put(chr);
+  }
+}
+
+void JSONWriter::flush() {
+  if(mSize == 0) {
+    return;
+  }
+  if(!mFailed && !mFile.write(StringView{mBuffer.data(), mSize})) {
+    mFailed = true;
+  }
+  mSize = 0;
+}
+
+} // namespace sigmoid
@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+JSONWriter.hpp
+--------------
+Streaming JSON writer
+*/
+
+#include <array>
+#include <glm/glm.hpp>
+#include <nwge/common/string.hpp>
+#include <nwge/data/rw.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Writes JSON straight to a file.
+ *
+ * Output goes through a fixed-size buffer which is flushed to the file whenever
+ * it fills up, so the writer never allocates. Objects & arrays are indented
+ * the same way as hand-written scene files.
+ *
+ * Write errors are remembered and reported by `finish()`, which must be called
+ * once the last value has been written.
+ */
+class JSONWriter {
+public:
+  static constexpr usize cBufferSize = 4 * 1024;
+
+  JSONWriter(nwge::data::RW &file);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+  void key(const nwge::StringView &key);
+
+  void string(const nwge::StringView &value);
+  void number(f64 value);
+  void number(f32 value);
+  void integer(s64 value);
+  void boolean(bool value);
+  // Writes an [x, y] array.
+  void vec2(glm::vec2 value);
+  void ivec2(glm::ivec2 value);
+
+  // Flushes the buffer. Returns false if anything could not be written.
+  bool finish();
+
+private:
+  nwge::data::RW &mFile;
+  std::array<char, cBufferSize> mBuffer;
+  usize mSize = 0;
+  usize mDepth = 0;
+  // true right after `{` or `[`, before the first member
+  bool mFirst = true;
+  // true right after a key, whose value must follow on the same line
+  bool mAfterKey = false;
+  bool mFailed = false;
+
+  void member();
+  template<typename T>
+  void pair(T x, T y);
+  void end(char close);
+  void put(char chr);
+  void put(const nwge::StringView &str);
+  void flush();
+};
+
+} // namespace sigmoid
@@ -1,5 +1,7 @@
 #include "states.hpp"
 #include "Game.hpp"
+#include "RenderTarget.hpp"
+#include "ResourceCache.hpp"
 #include <nwge/common/maybe.hpp>
 
 using namespace nwge;
@@ -22,6 +24,8 @@ class LaunchState final: public State {
   }
 
   bool init() override {
+    resources().setBudget(mGame.textureBudget * 1024 * 1024);
+    frameScaler().setHeight(u32(mGame.renderHeight));
     swapStatePtr(gameMenu(std::move(mGame)));
     return true;
   }
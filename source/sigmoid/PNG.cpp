@@ -0,0 +1,782 @@
+#include "PNG.hpp"
+#include <array>
+#include <cstring>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+namespace {
+
+/*
+Inflate
+-------
+Huffman codes up to cFastBits long are decoded with a single table lookup,
+longer ones by walking the canonical code ranges.
+*/
+
+constexpr u32 cFastBits = 9;
+constexpr u32 cFastMask = (1 << cFastBits) - 1;
+constexpr usize cMaxSymbols = 288;
+
+constexpr u32 reverseBits(u32 value, u32 bits) {
+  u32 out = 0;
+  for(u32 i = 0; i < bits; ++i) {
+    out = (out << 1) | (value & 1);
+    value >>= 1;
+  }
+  return out;
+}
+
+struct Huffman {
+  std::array<u16, 1 << cFastBits> fast{}; // -> (length << 9) | symbol, or 0
+  std::array<u16, 16> firstCode{};
+  std::array<u16, 16> firstSymbol{};
+  std::array<u32, 17> maxCode{}; // -> one past the last code, left-aligned
+  std::array<u16, cMaxSymbols> values{};
+
+  bool build(const u8 *lengths, usize count) {
+    std::array<u16, 16> counts{};
+    for(usize i = 0; i < count; ++i) {
+      ++counts[lengths[i]];
+    }
+    counts[0] = 0;
+
+    std::array<u16, 16> nextCode{};
+    u32 code = 0;
+    u16 symbol = 0;
+    for(u32 len = 1; len < 16; ++len) {
+      nextCode[len] = u16(code);
+      firstCode[len] = u16(code);
+      firstSymbol[len] = symbol;
+      code += counts[len];
+      if(counts[len] != 0 && code - 1 >= (1u << len)) {
+        return false;
+      }
+      maxCode[len] = code << (16 - len);
+      code <<= 1;
+      symbol += counts[len];
+    }
+    maxCode[16] = 0x10000;
+
+    for(usize i = 0; i < count; ++i) {
+      u32 len = lengths[i];
+      if(len == 0) {
+        continue;
+      }
+      u32 index = nextCode[len] - firstCode[len] + firstSymbol[len];
+      values[index] = u16(i);
+      if(len <= cFastBits) {
+        u16 entry = u16((len << cFastBits) | i);
+        for(u32 j = reverseBits(nextCode[len], len); j <= cFastMask; j += 1 << len) {
+          fast[j] = entry;
+        }
+      }
+      ++nextCode[len];
+    }
+    return true;
+  }
+};
+
+constexpr std::array<u16, 29> cLengthBase{
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+constexpr std::array<u8, 29> cLengthExtra{
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+constexpr std::array<u16, 30> cDistBase{
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385,
+  24577,
+};
+constexpr std::array<u8, 30> cDistExtra{
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+constexpr std::array<u8, 19> cCodeLengthOrder{
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+class Inflater {
+public:
+  Inflater(ArrayView<const u8> in, ArrayView<u8> out)
+    : mIn(in.begin()), mInEnd(in.end()),
+      mOut(out.begin()), mOutStart(out.begin()), mOutEnd(out.end())
+  {}
+
+  CStr run() {
+    bool final = false;
+    while(!final) {
+      final = bits(1) != 0;
+      u32 type = bits(2);
+      CStr error = nullptr;
+      switch(type) {
+      case 0:
+        error = stored();
+        break;
+      case 1:
+        error = compressed(fixedLiterals(), fixedDistances());
+        break;
+      case 2:
+        error = dynamic();
+        break;
+      default:
+        return "Invalid deflate block type.";
+      }
+      if(error != nullptr) {
+        return error;
+      }
+      if(overran()) {
+        return "Compressed data ends early.";
+      }
+    }
+    if(mOut != mOutEnd) {
+      return "Image data is too short.";
+    }
+    return nullptr;
+  }
+
+private:
+  const u8 *mIn;
+  const u8 *mInEnd;
+  u8 *mOut;
+  u8 *mOutStart;
+  u8 *mOutEnd;
+  u64 mBuffer = 0;
+  u32 mCount = 0;
+  u32 mPadding = 0; // -> zero bytes fed in past the end of the input
+
+  [[nodiscard]]
+  bool overran() const {
+    return mPadding * 8 > mCount;
+  }
+
+  void fill() {
+    while(mCount <= 56) {
+      u64 byte = 0;
+      if(mIn < mInEnd) {
+        byte = *mIn++;
+      } else {
+        ++mPadding;
+      }
+      mBuffer |= byte << mCount;
+      mCount += 8;
+    }
+  }
+
+  u32 bits(u32 count) {
+    if(mCount < count) {
+      fill();
+    }
+    u32 value = u32(mBuffer & ((u64(1) << count) - 1));
+    mBuffer >>= count;
+    mCount -= count;
+    return value;
+  }
+
+  s32 decode(const Huffman &huffman) {
+    if(mCount < 16) {
+      fill();
+    }
+    u16 entry = huffman.fast[mBuffer & cFastMask];
+    if(entry != 0) {
+      u32 len = entry >> cFastBits;
+      mBuffer >>= len;
+      mCount -= len;
+      return entry & cFastMask;
+    }
+    u32 code = reverseBits(u32(mBuffer & 0xFFFF), 16);
+    u32 len = cFastBits + 1;
+    while(len < 16 && code >= huffman.maxCode[len]) {
+      ++len;
+    }
+    if(len == 16) {
+      return -1;
+    }
+    u32 index = (code >> (16 - len)) - huffman.firstCode[len] + huffman.firstSymbol[len];
+    if(index >= cMaxSymbols) {
+      return -1;
+    }
+    mBuffer >>= len;
+    mCount -= len;
+    return huffman.values[index];
+  }
+
+  CStr stored() {
+    bits(mCount & 7);
+    u32 len = bits(16);
+    u32 nlen = bits(16);
+    if((len ^ 0xFFFF) != nlen) {
+      return "Corrupt stored deflate block.";
+    }
+    if(usize(mOutEnd - mOut) < len) {
+      return "Image data is too long.";
+    }
+    // drain whatever is left in the bit buffer first
+    while(len != 0 && mCount >= 8) {
+      *mOut++ = u8(bits(8));
+      --len;
+    }
+    if(overran() || usize(mInEnd - mIn) < len) {
+      return "Compressed data ends early.";
+    }
+    std::memcpy(mOut, mIn, len);
+    mOut += len;
+    mIn += len;
+    return nullptr;
+  }
+
+  CStr dynamic() {
+    u32 literalCount = bits(5) + 257;
+    u32 distanceCount = bits(5) + 1;
+    u32 codeLengthCount = bits(4) + 4;
+
+    std::array<u8, 19> codeLengthLengths{};
+    for(u32 i = 0; i < codeLengthCount; ++i) {
+      codeLengthLengths[cCodeLengthOrder[i]] = u8(bits(3));
+    }
+    Huffman codeLengths;
+    if(!codeLengths.build(codeLengthLengths.data(), codeLengthLengths.size())) {
+      return "Corrupt deflate code lengths.";
+    }
+
+    std::array<u8, cMaxSymbols + 32> lengths{};
+    u32 total = literalCount + distanceCount;
+    u32 count = 0;
+    while(count < total) {
+      s32 symbol = decode(codeLengths);
+      if(symbol < 0 || symbol > 18) {
+        return "Corrupt deflate code lengths.";
+      }
+      if(symbol < 16) {
+        lengths[count++] = u8(symbol);
+        continue;
+      }
+      u8 fill = 0;
+      u32 repeat = 0;
+      if(symbol == 16) {
+        if(count == 0) {
+          return "Corrupt deflate code lengths.";
+        }
+        fill = lengths[count - 1];
+        repeat = 3 + bits(2);
+      } else if(symbol == 17) {
+        repeat = 3 + bits(3);
+      } else {
+        repeat = 11 + bits(7);
+      }
+      if(total - count < repeat) {
+        return "Corrupt deflate code lengths.";
+      }
+      std::memset(lengths.data() + count, fill, repeat);
+      count += repeat;
+    }
+
+    Huffman literals;
+    Huffman distances;
+    if(!literals.build(lengths.data(), literalCount)
+    || !distances.build(lengths.data() + literalCount, distanceCount)) {
+      return "Corrupt deflate code lengths.";
+    }
+    return compressed(literals, distances);
+  }
+
+  CStr compressed(const Huffman &literals, const Huffman &distances) {
+    for(;;) {
+      s32 symbol = decode(literals);
+      if(symbol < 0) {
+        return "Corrupt deflate data.";
+      }
+      if(symbol < 256) {
+        if(mOut == mOutEnd) {
+          return "Image data is too long.";
+        }
+        *mOut++ = u8(symbol);
+        continue;
+      }
+      if(symbol == 256) {
+        return nullptr;
+      }
+      symbol -= 257;
+      if(symbol >= 29) {
+        return "Corrupt deflate data.";
+      }
+      usize len = cLengthBase[symbol] + bits(cLengthExtra[symbol]);
+      s32 distSymbol = decode(distances);
+      if(distSymbol < 0 || distSymbol >= 30) {
+        return "Corrupt deflate data.";
+      }
+      usize dist = cDistBase[distSymbol] + bits(cDistExtra[distSymbol]);
+      if(usize(mOut - mOutStart) < dist) {
+        return "Corrupt deflate distance.";
+      }
+      if(usize(mOutEnd - mOut) < len) {
+        return "Image data is too long.";
+      }
+      const u8 *from = mOut - dist;
+      // copies may overlap what they produce, so go byte by byte
+      for(usize i = 0; i < len; ++i) {
+        mOut[i] = from[i];
+      }
+      mOut += len;
+    }
+  }
+
+  static const Huffman &fixedLiterals() {
+    static const Huffman huffman = []{
+      std::array<u8, cMaxSymbols> lengths{};
+      for(usize i = 0; i < lengths.size(); ++i) {
+        lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+      }
+      Huffman out;
+      out.build(lengths.data(), lengths.size());
+      return out;
+    }();
+    return huffman;
+  }
+
+  static const Huffman &fixedDistances() {
+    static const Huffman huffman = []{
+      std::array<u8, 30> lengths{};
+      lengths.fill(5);
+      Huffman out;
+      out.build(lengths.data(), lengths.size());
+      return out;
+    }();
+    return huffman;
+  }
+};
+
+/*
+PNG
+---
+*/
+
+enum ColorType: u8 {
+  ColorGray = 0,
+  ColorRGB = 2,
+  ColorPalette = 3,
+  ColorGrayAlpha = 4,
+  ColorRGBA = 6,
+};
+
+constexpr std::array<u8, 8> cSignature{137, 80, 78, 71, 13, 10, 26, 10};
+constexpr s32 cMaxDimension = 1 << 14;
+
+constexpr u32 readU32(const u8 *ptr) {
+  return (u32(ptr[0]) << 24) | (u32(ptr[1]) << 16) | (u32(ptr[2]) << 8) | ptr[3];
+}
+
+constexpr u32 chunkType(const char (&name)[5]) {
+  return (u32(u8(name[0])) << 24) | (u32(u8(name[1])) << 16)
+    | (u32(u8(name[2])) << 8) | u8(name[3]);
+}
+
+struct Header {
+  u32 width = 0;
+  u32 height = 0;
+  u8 depth = 0;
+  ColorType color = ColorGray;
+  u32 channels = 0;
+  usize rowBytes = 0;
+  usize pixelBytes = 0; // -> distance between filtered bytes, at least 1
+  bool interlaced = false;
+
+  CStr parse(const u8 *data, u32 size) {
+    if(size != 13) {
+      return "Invalid IHDR chunk.";
+    }
+    width = readU32(data);
+    height = readU32(data + 4);
+    depth = data[8];
+    color = ColorType(data[9]);
+    if(width == 0 || height == 0 || width > cMaxDimension || height > cMaxDimension) {
+      return "Image size is out of range.";
+    }
+    if(data[10] != 0 || data[11] != 0) {
+      return "Unknown compression or filter method.";
+    }
+    if(data[12] > 1) {
+      return "Unknown interlace method.";
+    }
+    interlaced = data[12] == 1;
+    bool validDepth = false;
+    switch(color) {
+    case ColorGray:
+      channels = 1;
+      validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+      break;
+    case ColorPalette:
+      channels = 1;
+      validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8;
+      break;
+    case ColorRGB:
+      channels = 3;
+      validDepth = depth == 8 || depth == 16;
+      break;
+    case ColorGrayAlpha:
+      channels = 2;
+      validDepth = depth == 8 || depth == 16;
+      break;
+    case ColorRGBA:
+      channels = 4;
+      validDepth = depth == 8 || depth == 16;
+      break;
+    default:
+      return "Unknown color type.";
+    }
+    if(!validDepth) {
+      return "Invalid bit depth for color type.";
+    }
+    usize bitsPerPixel = usize(channels) * depth;
+    rowBytes = (usize(width) * bitsPerPixel + 7) / 8;
+    pixelBytes = bitsPerPixel < 8 ? 1 : bitsPerPixel / 8;
+    return nullptr;
+  }
+
+  // Header of a reduced image of an interlaced one.
+  [[nodiscard]]
+  Header reduced(u32 reducedWidth, u32 reducedHeight) const {
+    Header out = *this;
+    out.width = reducedWidth;
+    out.height = reducedHeight;
+    out.rowBytes = (usize(reducedWidth) * channels * depth + 7) / 8;
+    return out;
+  }
+
+  // Bytes of filtered data, each row being preceded by its filter type.
+  [[nodiscard]]
+  usize filteredSize() const {
+    return width == 0 || height == 0 ? 0 : (rowBytes + 1) * height;
+  }
+};
+
+// Adam7 passes: first column & row, then the distance between them.
+struct Pass {
+  u32 x, y, dx, dy;
+
+  [[nodiscard]]
+  constexpr u32 width(u32 imageWidth) const {
+    return imageWidth > x ? (imageWidth - x + dx - 1) / dx : 0;
+  }
+  [[nodiscard]]
+  constexpr u32 height(u32 imageHeight) const {
+    return imageHeight > y ? (imageHeight - y + dy - 1) / dy : 0;
+  }
+};
+
+constexpr std::array<Pass, 7> cAdam7{{
+  {0, 0, 8, 8},
+  {4, 0, 8, 8},
+  {0, 4, 4, 8},
+  {2, 0, 4, 4},
+  {0, 2, 2, 4},
+  {1, 0, 2, 2},
+  {0, 1, 1, 2},
+}};
+
+constexpr u8 paeth(u8 left, u8 up, u8 upLeft) {
+  s32 estimate = s32(left) + s32(up) - s32(upLeft);
+  s32 toLeft = estimate > left ? estimate - left : left - estimate;
+  s32 toUp = estimate > up ? estimate - up : up - estimate;
+  s32 toUpLeft = estimate > upLeft ? estimate - upLeft : upLeft - estimate;
+  if(toLeft <= toUp && toLeft <= toUpLeft) {
+    return left;
+  }
+  return toUp <= toUpLeft ? up : upLeft;
+}
+
+// Undoes row filters in place. Each row is preceded by its filter type.
+CStr unfilter(const Header &header, u8 *data) {
+  usize stride = header.rowBytes + 1;
+  usize bpp = header.pixelBytes;
+  const u8 *prev = nullptr;
+  for(u32 y = 0; y < header.height; ++y) {
+    u8 filter = data[y * stride];
+    u8 *row = data + y * stride + 1;
+    switch(filter) {
+    case 0:
+      break;
+    case 1:
+      for(usize i = bpp; i < header.rowBytes; ++i) {
+        row[i] = u8(row[i] + row[i - bpp]);
+      }
+      break;
+    case 2:
+      if(prev != nullptr) {
+        for(usize i = 0; i < header.rowBytes; ++i) {
+          row[i] = u8(row[i] + prev[i]);
+        }
+      }
+      break;
+    case 3:
+      for(usize i = 0; i < header.rowBytes; ++i) {
+        u32 left = i >= bpp ? row[i - bpp] : 0;
+        u32 up = prev != nullptr ? prev[i] : 0;
+        row[i] = u8(row[i] + ((left + up) >> 1));
+      }
+      break;
+    case 4:
+      for(usize i = 0; i < header.rowBytes; ++i) {
+        u8 left = i >= bpp ? row[i - bpp] : 0;
+        u8 up = prev != nullptr ? prev[i] : 0;
+        u8 upLeft = i >= bpp && prev != nullptr ? prev[i - bpp] : 0;
+        row[i] = u8(row[i] + paeth(left, up, upLeft));
+      }
+      break;
+    default:
+      return "Invalid row filter.";
+    }
+    prev = row;
+  }
+  return nullptr;
+}
+
+struct Palette {
+  std::array<u8, 256 * 4> colors{};
+  u32 count = 0;
+  // tRNS color key for gray & RGB images, in the image's bit depth
+  std::array<u16, 3> key{};
+  bool hasKey = false;
+};
+
+// Reads sample `index` of a row with samples `depth` bits wide.
+constexpr u32 sample(const u8 *row, usize index, u32 depth) {
+  switch(depth) {
+  case 16:
+    return (u32(row[index * 2]) << 8) | row[index * 2 + 1];
+  case 8:
+    return row[index];
+  default: {
+    usize bit = index * depth;
+    u32 shift = 8 - depth - u32(bit & 7);
+    return (row[bit >> 3] >> shift) & ((1u << depth) - 1);
+  }
+  }
+}
+
+// Scales a sample to 8 bits.
+constexpr u8 scale(u32 value, u32 depth) {
+  switch(depth) {
+  case 1:
+    return u8(value * 0xFF);
+  case 2:
+    return u8(value * 0x55);
+  case 4:
+    return u8(value * 0x11);
+  case 16:
+    return u8(value >> 8);
+  default:
+    return u8(value);
+  }
+}
+
+void convertRow(const Header &header, const Palette &palette, const u8 *row, u8 *out) {
+  u32 depth = header.depth;
+  if(depth == 8 && header.color == ColorRGBA) {
+    std::memcpy(out, row, usize(header.width) * 4);
+    return;
+  }
+  for(usize x = 0; x < header.width; ++x, out += 4) {
+    switch(header.color) {
+    case ColorGray: {
+      u32 gray = sample(row, x, depth);
+      out[0] = out[1] = out[2] = scale(gray, depth);
+      out[3] = palette.hasKey && gray == palette.key[0] ? 0 : 0xFF;
+      break;
+    }
+    case ColorPalette: {
+      u32 index = sample(row, x, depth);
+      std::memcpy(out, palette.colors.data() + usize(index) * 4, 4);
+      break;
+    }
+    case ColorRGB: {
+      u32 red = sample(row, x * 3, depth);
+      u32 green = sample(row, x * 3 + 1, depth);
+      u32 blue = sample(row, x * 3 + 2, depth);
+      out[0] = scale(red, depth);
+      out[1] = scale(green, depth);
+      out[2] = scale(blue, depth);
+      bool keyed = palette.hasKey && red == palette.key[0]
+        && green == palette.key[1] && blue == palette.key[2];
+      out[3] = keyed ? 0 : 0xFF;
+      break;
+    }
+    case ColorGrayAlpha:
+      out[0] = out[1] = out[2] = scale(sample(row, x * 2, depth), depth);
+      out[3] = scale(sample(row, x * 2 + 1, depth), depth);
+      break;
+    case ColorRGBA:
+      for(usize c = 0; c < 4; ++c) {
+        out[c] = scale(sample(row, x * 4 + c, depth), depth);
+      }
+      break;
+    }
+  }
+}
+
+} // namespace
+
+CStr decodePNG(ArrayView<const u8> file, Pixels &out) {
+  const u8 *data = file.begin();
+  usize size = file.size();
+  if(size < cSignature.size() || std::memcmp(data, cSignature.data(), cSignature.size()) != 0) {
+    return "Not a PNG file.";
+  }
+
+  /*
+  The first pass validates the chunk layout & reads everything but the image
+  data, so the compressed data can be gathered into one buffer of the right
+  size in the second.
+  */
+  Header header;
+  Palette palette;
+  bool hasHeader = false;
+  usize compressedSize = 0;
+  usize off = cSignature.size();
+  for(;;) {
+    if(size - off < 12) {
+      return "Truncated chunk.";
+    }
+    u32 chunkSize = readU32(data + off);
+    u32 type = readU32(data + off + 4);
+    if(size - off - 12 < chunkSize) {
+      return "Truncated chunk.";
+    }
+    const u8 *chunk = data + off + 8;
+    off += 12 + usize(chunkSize);
+
+    if(!hasHeader && type != chunkType("IHDR")) {
+      return "Missing IHDR chunk.";
+    }
+    if(type == chunkType("IHDR")) {
+      if(hasHeader) {
+        return "Duplicate IHDR chunk.";
+      }
+      if(CStr error = header.parse(chunk, chunkSize)) {
+        return error;
+      }
+      hasHeader = true;
+    } else if(type == chunkType("PLTE")) {
+      if(chunkSize % 3 != 0 || chunkSize / 3 > 256) {
+        return "Invalid PLTE chunk.";
+      }
+      palette.count = chunkSize / 3;
+      for(u32 i = 0; i < palette.count; ++i) {
+        palette.colors[i * 4] = chunk[i * 3];
+        palette.colors[i * 4 + 1] = chunk[i * 3 + 1];
+        palette.colors[i * 4 + 2] = chunk[i * 3 + 2];
+        palette.colors[i * 4 + 3] = 0xFF;
+      }
+    } else if(type == chunkType("tRNS")) {
+      if(header.color == ColorPalette) {
+        for(u32 i = 0; i < chunkSize && i < 256; ++i) {
+          palette.colors[i * 4 + 3] = chunk[i];
+        }
+      } else if(header.color == ColorGray && chunkSize == 2) {
+        palette.key[0] = u16((chunk[0] << 8) | chunk[1]);
+        palette.hasKey = true;
+      } else if(header.color == ColorRGB && chunkSize == 6) {
+        for(usize c = 0; c < 3; ++c) {
+          palette.key[c] = u16((chunk[c * 2] << 8) | chunk[c * 2 + 1]);
+        }
+        palette.hasKey = true;
+      }
+    } else if(type == chunkType("IDAT")) {
+      compressedSize += chunkSize;
+    } else if(type == chunkType("IEND")) {
+      break;
+    } else if((type & 0x20000000) == 0) {
+      // the case bit of the first letter marks chunks we may not skip
+      return "Unknown critical chunk.";
+    }
+  }
+  if(header.color == ColorPalette && palette.count == 0) {
+    return "Missing PLTE chunk.";
+  }
+  if(compressedSize < 2) {
+    return "Missing image data.";
+  }
+
+  Array<u8> compressed{compressedSize};
+  usize copied = 0;
+  off = cSignature.size();
+  for(;;) {
+    u32 chunkSize = readU32(data + off);
+    u32 type = readU32(data + off + 4);
+    if(type == chunkType("IDAT")) {
+      std::memcpy(compressed.data() + copied, data + off + 8, chunkSize);
+      copied += chunkSize;
+    } else if(type == chunkType("IEND")) {
+      break;
+    }
+    off += 12 + usize(chunkSize);
+  }
+
+  u8 cmf = compressed[0];
+  u8 flg = compressed[1];
+  if((cmf & 0x0F) != 8 || ((u32(cmf) << 8) | flg) % 31 != 0 || (flg & 0x20) != 0) {
+    return "Invalid zlib header.";
+  }
+
+  usize filteredSize = header.filteredSize();
+  if(header.interlaced) {
+    filteredSize = 0;
+    for(const auto &pass: cAdam7) {
+      filteredSize += header.reduced(
+        pass.width(header.width), pass.height(header.height)
+      ).filteredSize();
+    }
+  }
+  Array<u8> filtered{filteredSize};
+  Inflater inflater{
+    {compressed.data() + 2, compressedSize - 2},
+    filtered.view()
+  };
+  if(CStr error = inflater.run()) {
+    return error;
+  }
+
+  out.size = {s32(header.width), s32(header.height)};
+  out.data = {usize(header.width) * header.height * 4};
+  usize outStride = usize(header.width) * 4;
+  if(!header.interlaced) {
+    if(CStr error = unfilter(header, filtered.data())) {
+      return error;
+    }
+    usize stride = header.rowBytes + 1;
+    for(u32 y = 0; y < header.height; ++y) {
+      convertRow(header, palette, filtered.data() + y * stride + 1,
+        out.data.data() + y * outStride);
+    }
+    return nullptr;
+  }
+
+  // each pass is a reduced image of its own, spread over the full one
+  Array<u8> row{outStride};
+  u8 *passData = filtered.data();
+  for(const auto &pass: cAdam7) {
+    Header reduced = header.reduced(
+      pass.width(header.width), pass.height(header.height));
+    if(reduced.filteredSize() == 0) {
+      continue;
+    }
+    if(CStr error = unfilter(reduced, passData)) {
+      return error;
+    }
+    usize stride = reduced.rowBytes + 1;
+    for(u32 y = 0; y < reduced.height; ++y) {
+      convertRow(reduced, palette, passData + y * stride + 1, row.data());
+      u8 *dst = out.data.data() + usize(pass.y + y * pass.dy) * outStride;
+      for(u32 x = 0; x < reduced.width; ++x) {
+        std::memcpy(dst + usize(pass.x + x * pass.dx) * 4, row.data() + usize(x) * 4, 4);
+      }
+    }
+    passData += reduced.filteredSize();
+  }
+  return nullptr;
+}
+
+} // namespace sigmoid
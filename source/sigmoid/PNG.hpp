@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+PNG.hpp
+-------
+PNG decoder
+*/
+
+#include <glm/glm.hpp>
+#include <nwge/common/array.hpp>
+
+namespace sigmoid {
+
+// Decoded image, as RGBA8 rows from top to bottom.
+struct Pixels {
+  glm::ivec2 size{0, 0};
+  nwge::Array<u8> data;
+  bool premultiplied = false; // -> set for pixels taken from cooked textures
+};
+
+/**
+ * @brief Decodes a PNG file into RGBA8 pixels.
+ *
+ * Every bit depth, color type & interlace method is supported. The decoder
+ * only touches its arguments, so it's safe to run on any thread.
+ *
+ * @return nullptr on success, otherwise a description of what went wrong.
+ */
+[[nodiscard]]
+CStr decodePNG(nwge::ArrayView<const u8> file, Pixels &out);
+
+} // namespace sigmoid
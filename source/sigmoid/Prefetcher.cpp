@@ -0,0 +1,235 @@
+#include "Prefetcher.hpp"
+#include <algorithm>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+Prefetcher::Prefetcher(data::Bundle &bundle, const Atlas &atlas,
+  const StoryScene &story, SymbolID background, usize window)
+  : mBundle(&bundle),
+    mAtlas(&atlas),
+    mStory(&story),
+    mInitialBackground(background),
+    mWindow(window),
+    mBackgrounds(story.backgrounds.size()),
+    mSheets(story.actors.size()),
+    mMusic(story.musics.size())
+{
+  findRetirement();
+}
+
+/*
+A background stays on screen until the next background command, and a sheet
+until the next line is spoken. Sprites have no way to be removed yet, so their
+sheets are needed until the end.
+*/
+void Prefetcher::findRetirement() {
+  usize end = mStory->commands.size();
+  SymbolID background = mInitialBackground;
+  SymbolID speaker = cNoSymbol;
+  for(usize i = 0; i < end; ++i) {
+    Command command = mStory->commands[i];
+    switch(command.code) {
+    case CommandSprite: {
+      const auto &sprite = mStory->sprite(command);
+      if(sprite.actor != cNoSymbol) {
+        mSheets[sprite.actor].retire = end;
+      }
+      break;
+    }
+    case CommandSpeak:
+      if(speaker != cNoSymbol) {
+        mSheets[speaker].retire = std::max(mSheets[speaker].retire, i);
+      }
+      speaker = mStory->speak(command).actor;
+      break;
+    case CommandBackground: {
+      SymbolID next = mStory->background(command).background;
+      if(next == cNoSymbol) {
+        break;
+      }
+      if(background != cNoSymbol) {
+        mBackgrounds[background].retire = i;
+      }
+      background = next;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  if(background != cNoSymbol) {
+    mBackgrounds[background].retire = end;
+  }
+  if(speaker != cNoSymbol) {
+    mSheets[speaker].retire = end;
+  }
+}
+
+void Prefetcher::rebind(const StoryScene &story) {
+  mStory = &story;
+}
+
+void Prefetcher::advance(usize commandOff) {
+  if(mStory == nullptr) {
+    return;
+  }
+  if(mScanned == 0) {
+    prefetchBackground(mInitialBackground);
+  }
+  retire(commandOff);
+  usize end = std::min(commandOff + mWindow, mStory->commands.size());
+  for(usize i = std::max(mScanned, commandOff); i < end; ++i) {
+    prefetch(mStory->commands[i]);
+  }
+  mScanned = std::max(mScanned, end);
+}
+
+void Prefetcher::retire(usize commandOff) {
+  for(auto &slot: mBackgrounds) {
+    if(slot.retire < commandOff) {
+      slot.resource = {};
+    }
+  }
+  for(auto &slot: mSheets) {
+    if(slot.retire < commandOff) {
+      slot.resource = {};
+    }
+  }
+}
+
+void Prefetcher::prefetchBackground(SymbolID background) {
+  if(background != cNoSymbol) {
+    request(mBackgrounds[background], mStory->backgrounds.name(background));
+  }
+}
+
+void Prefetcher::loaded() {
+  for(auto &slot: mMusic) {
+    if(slot.state == SlotPending) {
+      slot.state = SlotResident;
+    }
+  }
+}
+
+SharedImage Prefetcher::background(SymbolID background) {
+  return use(mBackgrounds[background], mStory->backgrounds.name(background));
+}
+
+SharedTexture Prefetcher::sheet(SymbolID actor) {
+  return use(mSheets[actor], sheetEntry(actor));
+}
+
+/*
+Actors whose sheets share an atlas page share its texture too, the cache only
+loads the page once.
+*/
+StringView Prefetcher::sheetEntry(SymbolID actor) const {
+  const auto &info = mStory->actors[actor];
+  if(const auto *sheet = mAtlas->find(info.sheet, info.sheetSize)) {
+    return sheet->page;
+  }
+  return info.sheet;
+}
+
+void Prefetcher::music(SymbolID music) {
+  auto &slot = mMusic[music];
+  count(slot.state == SlotResident, slot.used);
+  request(slot, mStory->musics.name(music));
+}
+
+const Prefetcher::Stats &Prefetcher::stats() const {
+  return mStats;
+}
+
+void Prefetcher::prefetch(Command command) {
+  switch(command.code) {
+  case CommandSprite: {
+    const auto &sprite = mStory->sprite(command);
+    if(sprite.actor != cNoSymbol) {
+      request(mSheets[sprite.actor], sheetEntry(sprite.actor));
+    }
+    break;
+  }
+  case CommandSpeak: {
+    const auto &speak = mStory->speak(command);
+    if(speak.actor != cNoSymbol) {
+      request(mSheets[speak.actor], sheetEntry(speak.actor));
+    }
+    break;
+  }
+  case CommandBackground: {
+    const auto &background = mStory->background(command);
+    prefetchBackground(background.background);
+    if(background.music != cNoSymbol) {
+      request(mMusic[background.music],
+        mStory->musics.name(background.music));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+template<typename T>
+Shared<T> Prefetcher::use(ResourceSlot<T> &slot, const StringView &name) {
+  if(name.empty()) {
+    return {};
+  }
+  count(slot.resource.resident(), slot.used);
+  request(slot, name);
+  return slot.resource;
+}
+
+static void acquire(data::Bundle &bundle, const StringView &name, SharedImage &out) {
+  out = resources().image(bundle, name);
+}
+
+static void acquire(data::Bundle &bundle, const StringView &name, SharedTexture &out) {
+  out = resources().texture(bundle, name);
+}
+
+// Empty names stand for removing the background or stopping the music.
+template<typename T>
+void Prefetcher::request(ResourceSlot<T> &slot, const StringView &name) {
+  if(slot.resource.present() || name.empty()) {
+    return;
+  }
+  acquire(*mBundle, name, slot.resource);
+  ++mStats.requests;
+}
+
+void Prefetcher::request(MusicSlot &slot, const StringView &name) {
+  if(slot.state != SlotIdle || name.empty()) {
+    return;
+  }
+  mBundle->nqCustom(name, slot);
+  slot.state = SlotPending;
+  ++mStats.requests;
+}
+
+// Only the first use of an asset counts, later ones are always hits.
+void Prefetcher::count(bool resident, bool &used) {
+  if(used) {
+    return;
+  }
+  used = true;
+  if(resident) {
+    ++mStats.hits;
+  } else {
+    ++mStats.misses;
+  }
+}
+
+bool Prefetcher::MusicSlot::load(data::RW &file) {
+  s64 size = file.size();
+  if(size <= 0) {
+    return false;
+  }
+  data = {usize(size)};
+  return file.read(data.view());
+}
+
+} // namespace sigmoid
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+Prefetcher.hpp
+--------------
+Loads story scene assets ahead of the commands using them
+*/
+
+#include "Atlas.hpp"
+#include "ResourceCache.hpp"
+#include "StoryScene.hpp"
+#include <nwge/common/array.hpp>
+#include <nwge/data/bundle.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Lookahead loader for story scene assets.
+ *
+ * Keeps a window of upcoming commands and enqueues loads for the backgrounds,
+ * actor sheets & music they refer to, so that by the time a command runs its
+ * assets are usually resident already. Assets are tracked by the IDs the story
+ * scene assigned to them, so each one is only ever loaded once.
+ *
+ * Backgrounds are decoded off the main thread as images, sheets are loaded
+ * as textures, or as the atlas page holding them if the game has a sheet atlas.
+ * Both come from the `ResourceCache`, so ones another scene or
+ * State is using already are shared rather than loaded again. The prefetcher keeps its
+ * reference to a texture until the command which takes it off screen for the
+ * last time has run, so the cache prefers to evict textures no remaining
+ * command needs.
+ *
+ * An asset counts as resident once the engine has sent `Event::PostLoad` for
+ * the batch of loads it was enqueued in. Asking for an asset which is resident
+ * is a hit. Asking for one that is still loading, or was never prefetched, is a
+ * miss, and in the latter case the load is started right away.
+ */
+class Prefetcher {
+public:
+  struct Stats {
+    usize requests = 0; // -> assets requested
+    usize hits = 0;     // -> assets that were resident when first used
+    usize misses = 0;   // -> assets that were not
+  };
+
+  Prefetcher() = default;
+  // `background` is the one shown before the first command, if any.
+  Prefetcher(nwge::data::Bundle &bundle, const Atlas &atlas,
+    const StoryScene &story, SymbolID background, usize window);
+
+  // Points the prefetcher at its story scene again after the scene was moved.
+  void rebind(const StoryScene &story);
+  // Enqueues loads for the commands in [`commandOff`, `commandOff` + window)
+  // and lets go of textures commands before `commandOff` were the last to use.
+  void advance(usize commandOff);
+  // Marks music enqueued so far as resident. Call on `Event::PostLoad`, after
+  // `ResourceCache::loaded()`.
+  void loaded();
+
+  // Returns an empty reference if the background has no image or the actor
+  // has no sheet. Sheets in the atlas resolve to their page.
+  SharedImage background(SymbolID background);
+  SharedTexture sheet(SymbolID actor);
+  void music(SymbolID music);
+
+  [[nodiscard]]
+  const Stats &stats() const;
+
+private:
+  enum SlotState: u8 {
+    SlotIdle,
+    SlotPending,
+    SlotResident,
+  };
+
+  template<typename T>
+  struct ResourceSlot {
+    Shared<T> resource;
+    usize retire = 0; // -> command after which the resource isn't needed
+    bool used = false;
+  };
+
+  /*
+  There's no music playback yet, so music is prefetched as the raw file
+  contents which the player will eventually decode.
+  */
+  struct MusicSlot {
+    nwge::Array<char> data;
+    SlotState state = SlotIdle;
+    bool used = false;
+
+    bool load(nwge::data::RW &file);
+  };
+
+  nwge::data::Bundle *mBundle = nullptr;
+  const Atlas *mAtlas = nullptr;
+  const StoryScene *mStory = nullptr;
+  SymbolID mInitialBackground = cNoSymbol;
+  usize mWindow = 0;
+  usize mScanned = 0;
+  nwge::Array<ResourceSlot<Image>> mBackgrounds;
+  nwge::Array<ResourceSlot<nwge::render::Texture>> mSheets;
+  nwge::Array<MusicSlot> mMusic;
+  Stats mStats;
+
+  void findRetirement();
+  void retire(usize commandOff);
+  void prefetch(Command command);
+  void prefetchBackground(SymbolID background);
+  [[nodiscard]]
+  nwge::StringView sheetEntry(SymbolID actor) const;
+  template<typename T>
+  Shared<T> use(ResourceSlot<T> &slot, const nwge::StringView &name);
+  template<typename T>
+  void request(ResourceSlot<T> &slot, const nwge::StringView &name);
+  void request(MusicSlot &slot, const nwge::StringView &name);
+  void count(bool resident, bool &used);
+};
+
+} // namespace sigmoid
@@ -0,0 +1,76 @@
+#include "Redraw.hpp"
+#include "ResourceCache.hpp"
+#include <nwge/console.hpp>
+#include <utility>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+Redraw::Redraw() {
+  SDL_AddEventWatch(watch, this);
+}
+
+Redraw::~Redraw() {
+  SDL_DelEventWatch(watch, this);
+}
+
+/*
+Audio, sensor & render device events, as well as SDL's poll sentinel, aren't
+caused by anything on screen or by the player.
+*/
+int SDLCALL Redraw::watch(void *userdata, SDL_Event *event) {
+  u32 type = event->type;
+  if((type >= SDL_QUIT && type < SDL_AUDIODEVICEADDED) || type >= SDL_USEREVENT) {
+    static_cast<Redraw*>(userdata)->mInput.store(true, std::memory_order_relaxed);
+  }
+  return 0;
+}
+
+void Redraw::invalidate() {
+  mDirtyFrames = cSettleFrames;
+}
+
+void Redraw::deadline(f32 seconds) {
+  mDeadline = SDL_min(mDeadline, seconds);
+}
+
+void Redraw::idle() {
+  if(mInput.exchange(false, std::memory_order_relaxed)) {
+    invalidate();
+  }
+  f32 timeout = std::exchange(mDeadline, cMaxIdle);
+  if(mDirtyFrames != 0 || resources().busy()) {
+    return;
+  }
+  // SDL rounds the timeout down, a deadline mustn't turn into busy waiting
+  int ms = SDL_max(int(timeout * 1000.0f), 1);
+  u64 start = SDL_GetPerformanceCounter();
+  SDL_WaitEventTimeout(nullptr, ms);
+  ++mStats.idles;
+  mStats.idleTime += f64(SDL_GetPerformanceCounter() - start)
+    / f64(SDL_GetPerformanceFrequency());
+}
+
+void Redraw::frame() {
+  ++mStats.frames;
+  if(mDirtyFrames != 0) {
+    --mDirtyFrames;
+  }
+}
+
+const Redraw::Stats &Redraw::stats() const {
+  return mStats;
+}
+
+void Redraw::printStats() const {
+  console::print("Redraw: {} frames drawn, idle {} times for {}s",
+    mStats.frames, mStats.idles, mStats.idleTime);
+}
+
+Redraw &redraw() {
+  static auto *tracker = new Redraw;
+  return *tracker;
+}
+
+} // namespace sigmoid
@@ -0,0 +1,80 @@
+#pragma once
+
+/*
+Redraw.hpp
+----------
+Idling the main loop while the screen doesn't change
+*/
+
+#include <SDL2/SDL.h>
+#include <nwge/common/string.hpp>
+#include <atomic>
+
+namespace sigmoid {
+
+/**
+ * @brief Tracks whether the screen changed, so the main loop can idle.
+ *
+ * The engine ticks & renders as fast as it's allowed to, but most of the time
+ * nothing on a visual novel's screen moves. States mark whatever changes what
+ * they draw with `invalidate()`, and call `idle()` once per tick. If nothing
+ * was invalidated since the last frames were drawn, `idle()` blocks until the
+ * next event, the nearest `deadline()` or `cMaxIdle` at most, so an idle
+ * screen is only redrawn about once a second.
+ *
+ * Input & window events invalidate the screen by themselves, as they're seen
+ * as soon as the engine pumps them. That covers hovering, ImGui input & the
+ * window being exposed or resized. Nothing idles while the `ResourceCache` has
+ * loads or uploads in flight, as those don't wake the loop up.
+ */
+class Redraw {
+public:
+  struct Stats {
+    u64 frames = 0;    // -> frames drawn
+    u64 idles = 0;     // -> times the loop went idle
+    f64 idleTime = 0;  // -> seconds spent idle
+  };
+
+  // Longest time to idle for, in seconds.
+  static constexpr f32 cMaxIdle = 1.0f;
+  /*
+  Frames drawn after the screen is invalidated. The second one lets ImGui
+  settle, as it lays windows out a frame after their contents change.
+  */
+  static constexpr u32 cSettleFrames = 2;
+
+  Redraw();
+  Redraw(const Redraw&) = delete;
+  Redraw(Redraw&&) = delete;
+  Redraw &operator=(const Redraw&) = delete;
+  Redraw &operator=(Redraw&&) = delete;
+  ~Redraw();
+
+  // Marks the screen as changed, so the next frames are drawn.
+  void invalidate();
+  // Makes the next `idle()` wake up after `seconds` at the latest, for things
+  // which change on a timer.
+  void deadline(f32 seconds);
+  // Call once per tick, after updating.
+  void idle();
+  // Call once per frame drawn, from `render()`.
+  void frame();
+
+  [[nodiscard]]
+  const Stats &stats() const;
+  void printStats() const;
+
+private:
+  u32 mDirtyFrames = cSettleFrames;
+  f32 mDeadline = cMaxIdle;
+  // Set by the event watch, which may run on any thread pushing events.
+  std::atomic<bool> mInput = false;
+  Stats mStats;
+
+  static int SDLCALL watch(void *userdata, SDL_Event *event);
+};
+
+// The process-wide redraw tracker.
+Redraw &redraw();
+
+} // namespace sigmoid
@@ -0,0 +1,184 @@
+#include "RenderTarget.hpp"
+#include "GL.hpp"
+#include <nwge/console.hpp>
+#include <nwge/render/draw.hpp>
+#include <nwge/render/window.hpp>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+RenderTarget::~RenderTarget() {
+  destroy();
+}
+
+bool RenderTarget::resize(glm::ivec2 size) {
+  if(valid() && size == mSize) {
+    return true;
+  }
+  destroy();
+  if(size.x <= 0 || size.y <= 0) {
+    return false;
+  }
+
+  GLint prevDraw = 0;
+  GLint prevRead = 0;
+  GLint prevRenderbuffer = 0;
+  gl().getIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+  gl().getIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevRead);
+  gl().getIntegerv(GL_RENDERBUFFER_BINDING, &prevRenderbuffer);
+
+  gl().genTextures(1, &mTexture);
+  {
+    BindTexture bind{mTexture};
+    gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl().texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl().texImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  }
+  gl().genRenderbuffers(1, &mDepth);
+  gl().bindRenderbuffer(GL_RENDERBUFFER, mDepth);
+  gl().renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+
+  gl().genFramebuffers(1, &mFramebuffer);
+  gl().bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+  gl().framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+    GL_TEXTURE_2D, mTexture, 0);
+  gl().framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+    GL_RENDERBUFFER, mDepth);
+  GLenum status = gl().checkFramebufferStatus(GL_FRAMEBUFFER);
+
+  gl().bindRenderbuffer(GL_RENDERBUFFER, GLuint(prevRenderbuffer));
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(prevDraw));
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(prevRead));
+  if(status != GL_FRAMEBUFFER_COMPLETE) {
+    console::warn("Could not create a {}x{} render target (status {}).",
+      size.x, size.y, status);
+    destroy();
+    return false;
+  }
+  mSize = size;
+  return true;
+}
+
+void RenderTarget::destroy() {
+  if(mFramebuffer != 0) {
+    gl().deleteFramebuffers(1, &mFramebuffer);
+  }
+  if(mDepth != 0) {
+    gl().deleteRenderbuffers(1, &mDepth);
+  }
+  if(mTexture != 0) {
+    gl().deleteTextures(1, &mTexture);
+  }
+  mFramebuffer = 0;
+  mDepth = 0;
+  mTexture = 0;
+  mSize = {0, 0};
+}
+
+bool RenderTarget::valid() const {
+  return mFramebuffer != 0;
+}
+
+glm::ivec2 RenderTarget::size() const {
+  return mSize;
+}
+
+u32 RenderTarget::framebuffer() const {
+  return mFramebuffer;
+}
+
+u32 RenderTarget::texture() const {
+  return mTexture;
+}
+
+void FrameScaler::setHeight(u32 height) {
+  mHeight = height;
+  mFailedSize = {0, 0};
+  if(height == 0) {
+    mTarget.destroy();
+  }
+}
+
+/*
+The target is only as wide as the window's aspect ratio makes it, so nothing
+is stretched when it's scaled up. A target that can't be created is not asked
+for again until the window changes size.
+*/
+void FrameScaler::begin() {
+  mActive = false;
+  glm::ivec2 window = render::windowSize();
+  if(mHeight == 0 || window.x <= 0 || u32(window.y) <= mHeight) {
+    return;
+  }
+  glm::ivec2 size{
+    s32(s64(window.x) * mHeight / window.y),
+    s32(mHeight)
+  };
+  if(size == mFailedSize) {
+    return;
+  }
+  if(!mTarget.resize(size)) {
+    mFailedSize = size;
+    return;
+  }
+  gl().getIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &mPrevFramebuffer);
+  gl().getIntegerv(GL_VIEWPORT, mPrevViewport);
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, mTarget.framebuffer());
+  gl().viewport(0, 0, size.x, size.y);
+  mActive = true;
+}
+
+/*
+The window is cleared before scaling, which covers the bars beside the frame,
+and the frame is then blitted over it with linear filtering.
+*/
+void FrameScaler::end() {
+  if(!mActive) {
+    return;
+  }
+  mActive = false;
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(mPrevFramebuffer));
+  gl().viewport(mPrevViewport[0], mPrevViewport[1],
+    mPrevViewport[2], mPrevViewport[3]);
+  render::clear({0, 0, 0});
+
+  glm::ivec2 window = render::windowSize();
+  glm::ivec2 size = mTarget.size();
+  // fit the frame inside the window, keeping its aspect ratio
+  s64 width = s64(window.y) * size.x / size.y;
+  s64 height = window.y;
+  if(width > window.x) {
+    width = window.x;
+    height = s64(window.x) * size.y / size.x;
+  }
+  s32 x = s32((window.x - width) / 2);
+  s32 y = s32((window.y - height) / 2);
+
+  GLint prevRead = 0;
+  gl().getIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevRead);
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, mTarget.framebuffer());
+  gl().blitFramebuffer(
+    0, 0, size.x, size.y,
+    x, y, x + s32(width), y + s32(height),
+    GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(prevRead));
+}
+
+FrameScaler &frameScaler() {
+  static auto *scaler = new FrameScaler;
+  return *scaler;
+}
+
+ScaledFrame::ScaledFrame() {
+  frameScaler().begin();
+}
+
+ScaledFrame::~ScaledFrame() {
+  frameScaler().end();
+}
+
+} // namespace sigmoid
@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+RenderTarget.hpp
+----------------
+Offscreen targets & drawing frames at a fixed resolution
+*/
+
+#include <nwge/common/string.hpp>
+#include <glm/glm.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief A texture drawn into instead of the window.
+ *
+ * Has a depth buffer of its own, as the engine orders its draws by depth.
+ */
+class RenderTarget {
+public:
+  RenderTarget() = default;
+  RenderTarget(const RenderTarget&) = delete;
+  RenderTarget(RenderTarget&&) = delete;
+  RenderTarget &operator=(const RenderTarget&) = delete;
+  RenderTarget &operator=(RenderTarget&&) = delete;
+  ~RenderTarget();
+
+  // Creates the target again if its size differs. Returns false if the driver
+  // can't draw into a target of that size, leaving no target behind.
+  bool resize(glm::ivec2 size);
+  void destroy();
+
+  [[nodiscard]]
+  bool valid() const;
+  [[nodiscard]]
+  glm::ivec2 size() const;
+  [[nodiscard]]
+  u32 framebuffer() const;
+  [[nodiscard]]
+  u32 texture() const;
+
+private:
+  u32 mFramebuffer = 0;
+  u32 mTexture = 0;
+  u32 mDepth = 0;
+  glm::ivec2 mSize{0, 0};
+};
+
+/**
+ * @brief Draws frames at a fixed height & scales them up to the window.
+ *
+ * Once a height is set, frames are drawn into a target that many pixels tall
+ * whenever the window is taller, then stretched over the window in one pass.
+ * The target keeps the window's aspect ratio, so the engine lays everything
+ * out just as it would in the window, and the scaled frame is centered with
+ * black bars left over from rounding. Windows no taller than the height are
+ * drawn into directly.
+ */
+class FrameScaler {
+public:
+  // Sets the height frames are drawn at. 0 draws into the window directly.
+  void setHeight(u32 height);
+  // Starts drawing a frame, into the target if the window is tall enough.
+  void begin();
+  // Scales the frame begun to the window, if it was drawn into the target.
+  void end();
+
+private:
+  u32 mHeight = 0;
+  RenderTarget mTarget;
+  glm::ivec2 mFailedSize{0, 0};
+  bool mActive = false;
+  s32 mPrevFramebuffer = 0;
+  s32 mPrevViewport[4]{};
+};
+
+// The process-wide frame scaler.
+FrameScaler &frameScaler();
+
+// Draws into the scaled frame for the lifetime of the object, from `render()`.
+class ScaledFrame {
+public:
+  ScaledFrame();
+  ScaledFrame(const ScaledFrame&) = delete;
+  ScaledFrame(ScaledFrame&&) = delete;
+  ScaledFrame &operator=(const ScaledFrame&) = delete;
+  ScaledFrame &operator=(ScaledFrame&&) = delete;
+  ~ScaledFrame();
+};
+
+} // namespace sigmoid
@@ -0,0 +1,513 @@
+#include "ResourceCache.hpp"
+#include "Downscale.hpp"
+#include <nwge/console.hpp>
+#include <nwge/render/window.hpp>
+#include <algorithm>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+ResourceCache::~ResourceCache() {
+  for(auto *texture: mTextures) {
+    delete texture;
+  }
+  for(auto *image: mImages) {
+    delete image;
+  }
+  for(auto *font: mFonts) {
+    delete font;
+  }
+  for(auto *bundle: mBundles) {
+    delete bundle;
+  }
+}
+
+data::Bundle &ResourceCache::bundle(const StringView &dir, const StringView &file) {
+  for(auto *cached: mBundles) {
+    if(cached->dir.view().equals(dir) && cached->file.view().equals(file)) {
+      return cached->bundle;
+    }
+  }
+  auto *cached = new CachedBundle{dir, file, {}};
+  if(dir.empty()) {
+    cached->bundle.load({file});
+  } else {
+    cached->bundle.load({dir, file});
+  }
+  mBundles.push(cached);
+  return cached->bundle;
+}
+
+SharedTexture ResourceCache::texture(data::Bundle &bundle, const StringView &entry) {
+  auto *cached = find(mTextures, bundle, entry);
+  if(cached == nullptr) {
+    cached = new CachedResource<render::Texture>{&bundle, entry, {}};
+    enqueue(cached);
+    mTextures.push(cached);
+  }
+  // asking for a texture counts as using it, so prefetched ones aren't the
+  // first to be evicted
+  touch(cached);
+  return SharedTexture{cached};
+}
+
+SharedImage ResourceCache::image(data::Bundle &bundle, const StringView &entry) {
+  auto *cached = find(mImages, bundle, entry);
+  if(cached == nullptr) {
+    cached = new CachedResource<Image>{&bundle, entry, {}};
+    startLoad(cached);
+    mImages.push(cached);
+  }
+  touch(cached);
+  return SharedImage{cached};
+}
+
+SharedFont ResourceCache::font(data::Bundle &bundle, const StringView &entry) {
+  auto *cached = find(mFonts, bundle, entry);
+  if(cached == nullptr) {
+    cached = new CachedResource<render::Font>{&bundle, entry, {}};
+    bundle.nqFont(entry, cached->resource);
+    mFonts.push(cached);
+  }
+  return SharedFont{cached};
+}
+
+template<typename T>
+CachedResource<T> *ResourceCache::find(Slice<CachedResource<T>*> &entries,
+  const data::Bundle &bundle, const StringView &entry)
+{
+  /*
+  A game uses at most a few hundred assets & lookups only happen when an asset
+  is first needed, so a linear search does fine here.
+  */
+  for(auto *cached: entries) {
+    if(cached->bundle == &bundle && cached->entry.view().equals(entry)) {
+      ++mHits;
+      return cached;
+    }
+  }
+  ++mMisses;
+  return nullptr;
+}
+
+/*
+A texture has pixels once its load completed. One enqueued after the batch
+started may still be waiting for the next one, so a texture without pixels is
+only given up on once a whole batch went by since it was enqueued.
+*/
+void ResourceCache::loaded() {
+  for(auto *texture: mTextures) {
+    if(texture->state != ResourcePending) {
+      continue;
+    }
+    glm::ivec2 size = texture->resource.size();
+    if(size.x <= 0 || size.y <= 0) {
+      if(texture->batch == mBatch) {
+        continue;
+      }
+      console::warn("Could not load {}", texture->entry);
+      // keep the entry as an empty texture, so it's not loaded over and over
+      texture->state = ResourceResident;
+      continue;
+    }
+    texture->state = ResourceResident;
+    // textures are uploaded as RGBA8
+    texture->bytes = usize(size.x) * usize(size.y) * 4;
+    mResidentBytes += texture->bytes;
+  }
+  ++mBatch;
+  mPeakBytes = std::max(mPeakBytes, mResidentBytes);
+  for(auto *font: mFonts) {
+    font->state = ResourceResident;
+  }
+  enforceBudget();
+}
+
+void ResourceCache::update() {
+  watchWindow();
+  while(auto *job = mDecoder.poll()) {
+    mUploads.push(static_cast<ImageLoad*>(job));
+    if(job->cooked.valid()) {
+      ++mCooked;
+    } else {
+      ++mDecoded;
+    }
+  }
+  if(mUploads.size() == 0) {
+    return;
+  }
+
+  u64 start = SDL_GetPerformanceCounter();
+  u64 budget = u64(cUploadBudget * f64(SDL_GetPerformanceFrequency()));
+  usize done = 0;
+  while(done < mUploads.size() && upload(*mUploads[done], start, budget)) {
+    ++done;
+  }
+  if(done != 0) {
+    Slice<ImageLoad*> remaining{mUploads.size() - done};
+    for(usize i = done; i < mUploads.size(); ++i) {
+      remaining.push(mUploads[i]);
+    }
+    mUploads = std::move(remaining);
+    mPeakBytes = std::max(mPeakBytes, mResidentBytes);
+    enforceBudget();
+  }
+}
+
+/*
+At least one band of rows is uploaded per call, so every image gets there even
+if a band takes longer than the whole budget.
+*/
+bool ResourceCache::upload(ImageLoad &load, u64 start, u64 budget) {
+  auto *entry = load.entry;
+  if(load.error != nullptr) {
+    console::warn("Could not load {}: {}", entry->entry, load.error);
+    // keep the entry as an empty image, so it's not loaded over and over
+    entry->state = ResourceResident;
+    delete &load;
+    return true;
+  }
+  // cooked textures are uploaded straight from the file
+  const auto &cooked = load.cooked;
+  if(load.image.id() == 0) {
+    if(cooked.valid()) {
+      load.image.create(cooked.levelSize(load.baseLevel), load.sourceSize,
+        cooked.levelCount() - load.baseLevel, cooked.premultiplied());
+    } else {
+      load.image.create(load.pixels.size, load.sourceSize, 1,
+        load.pixels.premultiplied);
+    }
+  }
+  while(!(cooked.valid()
+    ? load.image.upload(cooked, load.baseLevel)
+    : load.image.upload(load.pixels)))
+  {
+    if(SDL_GetPerformanceCounter() - start >= budget) {
+      return false;
+    }
+  }
+  // an image being rescaled gives up its old size only now
+  mResidentBytes -= entry->bytes;
+  entry->resource = std::move(load.image);
+  entry->bytes = entry->resource.bytes();
+  entry->state = ResourceResident;
+  mResidentBytes += entry->bytes;
+  delete &load;
+  return true;
+}
+
+void ResourceCache::startLoad(CachedResource<Image> *entry) {
+  auto *load = new ImageLoad;
+  load->entry = entry;
+  load->pool = &mDecoder;
+  load->target = imageTarget();
+  entry->bundle->nqCustom(entry->entry, *load);
+  entry->state = ResourcePending;
+}
+
+/*
+Runs wherever the engine reads files. Decoding happens on the pool, which also
+hands back files that could not be read, so `upload()` settles their entry.
+*/
+bool ResourceCache::ImageLoad::load(data::RW &file) {
+  s64 size = file.size();
+  if(size <= 0) {
+    error = "Empty file";
+    pool->submit(*this);
+    return false;
+  }
+  encoded = {usize(size)};
+  if(!file.read({reinterpret_cast<char*>(encoded.data()), usize(size)})) {
+    encoded = {};
+    error = "Could not read file";
+    pool->submit(*this);
+    return false;
+  }
+  pool->submit(*this);
+  return true;
+}
+
+/*
+Images are drawn within the 4:3 area of the window at most, so that's as big as
+they need to be.
+*/
+glm::ivec2 ResourceCache::imageTarget() {
+  if(mWindow.x <= 0 || mWindow.y <= 0) {
+    mWindow = render::windowSize();
+  }
+  s32 height = std::min(mWindow.y, mWindow.x * 3 / 4);
+  return {height * 4 / 3, height};
+}
+
+/*
+Resizing a window goes through many sizes, so images are only rescaled once it
+has settled. A minimized window keeps the images as they are.
+*/
+void ResourceCache::watchWindow() {
+  glm::ivec2 window = render::windowSize();
+  if(window.x <= 0 || window.y <= 0) {
+    return;
+  }
+  u64 now = SDL_GetPerformanceCounter();
+  if(window != mPendingWindow) {
+    mPendingWindow = window;
+    mWindowChanged = now;
+    return;
+  }
+  u64 delay = u64(cResizeDelay * f64(SDL_GetPerformanceFrequency()));
+  if(window == mWindow || now - mWindowChanged < delay) {
+    return;
+  }
+  mWindow = window;
+  rescale();
+}
+
+/*
+Images in use are loaded again while the old ones are still drawn. The rest are
+evicted, so they are loaded at the new size when next used.
+*/
+void ResourceCache::rescale() {
+  glm::ivec2 target = imageTarget();
+  for(auto *image: mImages) {
+    const auto &resource = image->resource;
+    if(image->state != ResourceResident || resource.id() == 0) {
+      continue;
+    }
+    glm::ivec2 source = resource.sourceSize();
+    if(downscaledSize(source, downscaleSteps(source, target)) == resource.size()) {
+      continue;
+    }
+    if(image->refs == 0) {
+      evict(image);
+      continue;
+    }
+    startLoad(image);
+    ++mRescaled;
+  }
+}
+
+void ResourceCache::setBudget(usize bytes) {
+  mBudget = bytes;
+  enforceBudget();
+}
+
+void ResourceCache::touch(CachedResource<render::Texture> *entry) {
+  entry->lastUse = ++mClock;
+  if(entry->state != ResourceEvicted) {
+    return;
+  }
+  enqueue(entry);
+  ++mReloads;
+}
+
+void ResourceCache::enqueue(CachedResource<render::Texture> *entry) {
+  entry->bundle->nqTexture(entry->entry, entry->resource);
+  entry->batch = mBatch;
+  entry->state = ResourcePending;
+}
+
+void ResourceCache::touch(CachedResource<Image> *entry) {
+  entry->lastUse = ++mClock;
+  if(entry->state != ResourceEvicted) {
+    return;
+  }
+  startLoad(entry);
+  ++mReloads;
+}
+
+namespace {
+
+template<typename A, typename B>
+bool evictsBefore(const CachedResource<A> &lhs, const CachedResource<B> &rhs) {
+  bool lhsReferenced = lhs.refs != 0;
+  bool rhsReferenced = rhs.refs != 0;
+  if(lhsReferenced != rhsReferenced) {
+    return !lhsReferenced;
+  }
+  return lhs.lastUse < rhs.lastUse;
+}
+
+/*
+Unreferenced resources go before referenced ones, and within each group the
+least recently used goes first. The resource used last is never evicted, so
+whatever was just drawn or loaded stays.
+*/
+template<typename T>
+CachedResource<T> *evictionCandidate(const Slice<CachedResource<T>*> &entries,
+  u64 clock)
+{
+  CachedResource<T> *found = nullptr;
+  for(auto *entry: entries) {
+    if(entry->state != ResourceResident || entry->lastUse == clock) {
+      continue;
+    }
+    if(found == nullptr || evictsBefore(*entry, *found)) {
+      found = entry;
+    }
+  }
+  return found;
+}
+
+} // namespace
+
+/*
+Peak usage is recorded before evicting, so it shows how far over budget the
+textures needed at once went.
+*/
+void ResourceCache::enforceBudget() {
+  while(mResidentBytes > mBudget) {
+    auto *texture = evictionCandidate(mTextures, mClock);
+    auto *image = evictionCandidate(mImages, mClock);
+    if(image != nullptr && (texture == nullptr || evictsBefore(*image, *texture))) {
+      evict(image);
+    } else if(texture != nullptr) {
+      evict(texture);
+    } else {
+      break;
+    }
+  }
+}
+
+template<typename T>
+void ResourceCache::evict(CachedResource<T> *entry) {
+  mResidentBytes -= entry->bytes;
+  entry->resource = {};
+  entry->bytes = 0;
+  entry->state = ResourceEvicted;
+  ++mEvictions;
+}
+
+/*
+Resources which are still loading are kept, as the engine holds on to their
+address until they are done.
+*/
+usize ResourceCache::trim() {
+  usize freed = 0;
+  Slice<CachedResource<render::Texture>*> textures{mTextures.size()};
+  for(auto *texture: mTextures) {
+    if(texture->refs == 0 && texture->state != ResourcePending) {
+      freed += texture->bytes;
+      mResidentBytes -= texture->bytes;
+      delete texture;
+    } else {
+      textures.push(texture);
+    }
+  }
+  mTextures = std::move(textures);
+
+  Slice<CachedResource<Image>*> images{mImages.size()};
+  for(auto *image: mImages) {
+    if(image->refs == 0 && image->state != ResourcePending) {
+      freed += image->bytes;
+      mResidentBytes -= image->bytes;
+      delete image;
+    } else {
+      images.push(image);
+    }
+  }
+  mImages = std::move(images);
+
+  Slice<CachedResource<render::Font>*> fonts{mFonts.size()};
+  for(auto *font: mFonts) {
+    if(font->refs == 0 && font->state != ResourcePending) {
+      delete font;
+    } else {
+      fonts.push(font);
+    }
+  }
+  mFonts = std::move(fonts);
+  return freed;
+}
+
+ResourceCache::Stats ResourceCache::stats() const {
+  Stats stats{
+    .hits = mHits,
+    .misses = mMisses,
+    .textures = mTextures.size(),
+    .images = mImages.size(),
+    .fonts = mFonts.size(),
+    .residentBytes = mResidentBytes,
+    .peakBytes = mPeakBytes,
+    .budgetBytes = mBudget,
+    .evictions = mEvictions,
+    .reloads = mReloads,
+    .decoded = mDecoded,
+    .cooked = mCooked,
+    .rescaled = mRescaled,
+    .uploading = mUploads.size(),
+  };
+  for(const auto *texture: mTextures) {
+    if(texture->refs == 0) {
+      ++stats.unreferenced;
+    }
+  }
+  for(const auto *image: mImages) {
+    if(image->refs == 0) {
+      ++stats.unreferenced;
+    }
+  }
+  for(const auto *font: mFonts) {
+    if(font->refs == 0) {
+      ++stats.unreferenced;
+    }
+  }
+  return stats;
+}
+
+template<typename T>
+static bool anyPending(const Slice<CachedResource<T>*> &entries) {
+  for(const auto *entry: entries) {
+    if(entry->state == ResourcePending) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ResourceCache::busy() const {
+  return mUploads.size() != 0
+    || mPendingWindow != mWindow
+    || anyPending(mTextures)
+    || anyPending(mImages)
+    || anyPending(mFonts);
+}
+
+void ResourceCache::printStats() const {
+  auto stats = this->stats();
+  console::print("Resources: {} hits, {} misses, {} textures, {} images, {} fonts, {} unreferenced",
+    stats.hits, stats.misses, stats.textures, stats.images, stats.fonts,
+    stats.unreferenced);
+  console::print("Images: {} decoded, {} cooked, {} rescaled, {} uploading",
+    stats.decoded, stats.cooked, stats.rescaled, stats.uploading);
+  console::print("Texture memory: {}/{} bytes, {} peak, {} evictions, {} reloads",
+    stats.residentBytes, stats.budgetBytes, stats.peakBytes,
+    stats.evictions, stats.reloads);
+}
+
+/*
+The cache is never destroyed: by the time static destructors run the engine
+has already torn down the render context the textures belong to.
+*/
+ResourceCache &resources() {
+  static auto *cache = new ResourceCache;
+  return *cache;
+}
+
+void touchResource(CachedResource<render::Texture> *entry) {
+  resources().touch(entry);
+}
+
+void touchResource(CachedResource<Image> *entry) {
+  resources().touch(entry);
+}
+
+// Fonts are small & always in use, so they're never evicted.
+void touchResource([[maybe_unused]] CachedResource<render::Font> *entry) {}
+
+SharedFont engineFont() {
+  auto &cache = resources();
+  return cache.font(cache.bundle({}, "sigmoid.bndl"_sv), "INTER.CFN"_sv);
+}
+
+} // namespace sigmoid
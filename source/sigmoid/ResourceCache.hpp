@@ -0,0 +1,300 @@
+#pragma once
+
+/*
+ResourceCache.hpp
+-----------------
+Process-wide cache of bundles, fonts & textures
+*/
+
+#include "DecodePool.hpp"
+#include "Image.hpp"
+#include <cstdint>
+#include <nwge/common/slice.hpp>
+#include <nwge/common/string.hpp>
+#include <nwge/data/bundle.hpp>
+#include <nwge/render/Font.hpp>
+#include <nwge/render/Texture.hpp>
+
+namespace sigmoid {
+
+enum ResourceState: u8 {
+  ResourcePending,
+  ResourceResident,
+  ResourceEvicted, // -> freed to stay within the texture budget
+};
+
+template<typename T>
+struct CachedResource {
+  nwge::data::Bundle *bundle;
+  nwge::String<> entry;
+  T resource;
+  usize refs = 0;
+  usize bytes = 0;  // -> only known once resident
+  u64 lastUse = 0;  // -> `ResourceCache` clock at the last use
+  u64 batch = 0;    // -> `ResourceCache` load batch it was last enqueued in
+  ResourceState state = ResourcePending;
+};
+
+// Stamp the resource as used, reloading it if it was evicted.
+void touchResource(CachedResource<nwge::render::Texture> *entry);
+void touchResource(CachedResource<Image> *entry);
+void touchResource(CachedResource<nwge::render::Font> *entry);
+
+/**
+ * @brief Reference to a resource owned by the `ResourceCache`.
+ *
+ * Copying the reference shares the resource. The resource stays in the cache
+ * after the last reference to it is gone, until `ResourceCache::trim()` or
+ * until it's evicted.
+ *
+ * Draw through `use()`, which keeps the resource from being evicted while
+ * it's on screen & brings it back if it was.
+ */
+template<typename T>
+class Shared {
+public:
+  Shared() = default;
+
+  Shared(const Shared &other)
+    : mEntry(other.mEntry)
+  {
+    acquire();
+  }
+
+  Shared(Shared &&other) noexcept
+    : mEntry(other.mEntry)
+  {
+    other.mEntry = nullptr;
+  }
+
+  Shared &operator=(const Shared &other) {
+    if(this != &other) {
+      release();
+      mEntry = other.mEntry;
+      acquire();
+    }
+    return *this;
+  }
+
+  Shared &operator=(Shared &&other) noexcept {
+    if(this != &other) {
+      release();
+      mEntry = other.mEntry;
+      other.mEntry = nullptr;
+    }
+    return *this;
+  }
+
+  ~Shared() {
+    release();
+  }
+
+  [[nodiscard]]
+  bool present() const {
+    return mEntry != nullptr;
+  }
+
+  // Whether the engine has finished loading the resource.
+  [[nodiscard]]
+  bool resident() const {
+    return mEntry != nullptr && mEntry->state == ResourceResident;
+  }
+
+  const T &use() const {
+    touchResource(mEntry);
+    return mEntry->resource;
+  }
+
+  constexpr const T &operator*() const {
+    return mEntry->resource;
+  }
+
+  constexpr const T *operator->() const {
+    return &mEntry->resource;
+  }
+
+private:
+  friend class ResourceCache;
+
+  CachedResource<T> *mEntry = nullptr;
+
+  explicit Shared(CachedResource<T> *entry)
+    : mEntry(entry)
+  {
+    acquire();
+  }
+
+  void acquire() {
+    if(mEntry != nullptr) {
+      ++mEntry->refs;
+    }
+  }
+
+  void release() {
+    if(mEntry != nullptr) {
+      --mEntry->refs;
+      mEntry = nullptr;
+    }
+  }
+};
+
+using SharedTexture = Shared<nwge::render::Texture>;
+using SharedImage = Shared<Image>;
+using SharedFont = Shared<nwge::render::Font>;
+
+/**
+ * @brief Loads every bundle, font & texture at most once per process.
+ *
+ * Resources are keyed by the bundle they come from and their entry name in it.
+ * The first request for a resource enqueues its load, any later request is a
+ * hit and shares it. The cache outlives States, so assets used by both the
+ * menu & the scenes, or by several scenes, are not loaded again on
+ * `swapStatePtr`.
+ *
+ * Cached objects are heap-allocated and never move, as the engine holds on to
+ * their address while loading them.
+ *
+ * Images differ from textures in how they load: the engine only reads their
+ * files, which are then decoded by a `DecodePool` & uploaded by `update()` a
+ * few rows at a time, so a large image never holds up a frame. Cooked textures
+ * skip the decoding & are uploaded straight from their file. An image is
+ * resident once its last row is uploaded.
+ *
+ * Images are never drawn bigger than the 4:3 area of the window, so ones at
+ * least twice that size are loaded downscaled. When the window is resized,
+ * images in use are loaded again at the size that suits it, & drawn at their
+ * old size until then.
+ *
+ * Texture memory is kept within a budget. Once resident textures go over it,
+ * the least recently used ones are evicted, starting with those nothing refers
+ * to any more. Holders of a reference, such as a scene's prefetcher for the
+ * textures its remaining commands use, thus keep their textures in longer.
+ * An evicted texture is loaded again the next time it's used.
+ */
+class ResourceCache {
+public:
+  struct Stats {
+    usize hits = 0;          // -> requests for resources already cached
+    usize misses = 0;        // -> requests which enqueued a load
+    usize textures = 0;      // -> textures in the cache
+    usize images = 0;        // -> images in the cache
+    usize fonts = 0;         // -> fonts in the cache
+    usize unreferenced = 0;  // -> resources nothing refers to any more
+    usize residentBytes = 0; // -> texture memory of resident textures & images
+    usize peakBytes = 0;     // -> highest `residentBytes` so far
+    usize budgetBytes = 0;
+    usize evictions = 0;     // -> textures evicted to stay within budget
+    usize reloads = 0;       // -> evicted textures loaded again
+    usize decoded = 0;       // -> images decoded so far
+    usize cooked = 0;        // -> cooked textures loaded so far, without decoding
+    usize rescaled = 0;      // -> images loaded again after a window resize
+    usize uploading = 0;     // -> decoded images not fully uploaded yet
+  };
+
+  // Time spent uploading images per `update()`, in seconds.
+  static constexpr f64 cUploadBudget = 0.002;
+  // Time the window size must stay the same for before images are rescaled,
+  // in seconds.
+  static constexpr f64 cResizeDelay = 0.25;
+
+
+  ResourceCache() = default;
+  ResourceCache(const ResourceCache&) = delete;
+  ResourceCache(ResourceCache&&) = delete;
+  ResourceCache &operator=(const ResourceCache&) = delete;
+  ResourceCache &operator=(ResourceCache&&) = delete;
+  ~ResourceCache();
+
+  // Opens the bundle `file` in `dir`, or in the data root if `dir` is empty.
+  nwge::data::Bundle &bundle(const nwge::StringView &dir, const nwge::StringView &file);
+  // `bundle` must have been opened through the cache.
+  SharedTexture texture(nwge::data::Bundle &bundle, const nwge::StringView &entry);
+  SharedImage image(nwge::data::Bundle &bundle, const nwge::StringView &entry);
+  SharedFont font(nwge::data::Bundle &bundle, const nwge::StringView &entry);
+
+  // Marks textures which finished loading & fonts enqueued so far as
+  // resident. Call once a batch of loads is done, i.e. in `init()` or on
+  // `Event::PostLoad`.
+  void loaded();
+  // Uploads decoded images within `cUploadBudget` & rescales images after
+  // the window was resized. Call once per frame.
+  void update();
+  // Frees the resources nothing refers to. Returns the texture memory freed.
+  usize trim();
+  // Sets the texture memory budget, evicting textures to get within it.
+  void setBudget(usize bytes);
+  // Whether anything is still loading, uploading or waiting to be rescaled,
+  // i.e. whether `update()` may have work to do on the next frames.
+  [[nodiscard]]
+  bool busy() const;
+
+  [[nodiscard]]
+  Stats stats() const;
+  void printStats() const;
+
+private:
+  struct CachedBundle {
+    nwge::String<> dir;
+    nwge::String<> file;
+    nwge::data::Bundle bundle;
+  };
+
+  // Follows an image from its file being read, through decoding to upload.
+  struct ImageLoad: DecodeJob {
+    CachedResource<Image> *entry = nullptr;
+    DecodePool *pool = nullptr;
+    Image image;
+
+    bool load(nwge::data::RW &file);
+  };
+
+  nwge::Slice<CachedBundle*> mBundles{2};
+  nwge::Slice<CachedResource<nwge::render::Texture>*> mTextures{16};
+  nwge::Slice<CachedResource<Image>*> mImages{16};
+  nwge::Slice<CachedResource<nwge::render::Font>*> mFonts{2};
+  DecodePool mDecoder;
+  nwge::Slice<ImageLoad*> mUploads{4};
+  usize mHits = 0;
+  usize mMisses = 0;
+  u64 mClock = 0;
+  u64 mBatch = 0; // -> load batch textures enqueued now belong to
+  usize mBudget = SIZE_MAX; // -> set once the game is known
+  usize mResidentBytes = 0;
+  usize mPeakBytes = 0;
+  usize mEvictions = 0;
+  usize mReloads = 0;
+  usize mDecoded = 0;
+  usize mCooked = 0;
+  usize mRescaled = 0;
+  glm::ivec2 mWindow{0, 0};        // -> size images are loaded for
+  glm::ivec2 mPendingWindow{0, 0}; // -> size the window was last seen at
+  u64 mWindowChanged = 0;          // -> when `mPendingWindow` last changed
+
+  friend void touchResource(CachedResource<nwge::render::Texture> *entry);
+  friend void touchResource(CachedResource<Image> *entry);
+
+  void touch(CachedResource<nwge::render::Texture> *entry);
+  void touch(CachedResource<Image> *entry);
+  void enqueue(CachedResource<nwge::render::Texture> *entry);
+  void startLoad(CachedResource<Image> *entry);
+  // Returns false if the budget ran out before the image was done.
+  bool upload(ImageLoad &load, u64 start, u64 budget);
+  [[nodiscard]]
+  glm::ivec2 imageTarget();
+  void watchWindow();
+  void rescale();
+  void enforceBudget();
+  template<typename T>
+  void evict(CachedResource<T> *entry);
+
+  template<typename T>
+  CachedResource<T> *find(nwge::Slice<CachedResource<T>*> &entries,
+    const nwge::data::Bundle &bundle, const nwge::StringView &entry);
+};
+
+// The process-wide cache.
+ResourceCache &resources();
+// The engine's UI font from sigmoid.bndl.
+SharedFont engineFont();
+
+} // namespace sigmoid
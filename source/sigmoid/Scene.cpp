@@ -1,7 +1,9 @@
 #include "Scene.hpp"
 #include <nwge/bndl/tree.h>
 #include <nwge/dialog.hpp>
-#include <nwge/json/Schema.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
 
 using namespace nwge;
 
@@ -28,119 +30,232 @@ bool Scene::load(data::RW &file) {
     return false;
   }
 
-  ScratchArray<char> raw{usize(size)};
-  if(!file.read(raw.view())) {
+  // Compiled scenes are loaded in place, JSON scenes are streamed. Peeking at
+  // the magic number tells them apart.
+  std::array<char, cSceneBinaryMagic.size()> magic{};
+  usize magicSize = std::min(usize(size), magic.size());
+  if(!file.read(ArrayView<char>{magic.data(), magicSize})) {
     dialog::error("Failure"_sv,
       "Could not load scene {}.",
       name);
     return false;
   }
 
-  auto res = json::parse(raw.view());
-  if(res.error != json::OK) {
-    dialog::error("Failure"_sv,
-      "Could not parse scene {}:\n"
-      "{}",
-      name,
-      json::errorMessage(res.error));
-    return false;
+  if(SceneBinary::detect(ArrayView<const char>{magic.data(), magicSize})) {
+    mBinary = {usize(size)};
+    std::memcpy(mBinary.data(), magic.data(), magicSize);
+    ArrayView<char> rest{mBinary.data() + magicSize, usize(size) - magicSize};
+    if(!file.read(rest)) {
+      dialog::error("Failure"_sv,
+        "Could not load scene {}.",
+        name);
+      return false;
+    }
+    return checkLoaded(loadBinary());
   }
 
-  auto maybeRoot = json::Schema::object(*res.value);
-  if(!maybeRoot.present()) {
+  JSONReader reader{file, usize(size), StringView{magic.data(), magicSize}};
+  return checkLoaded(load(reader));
+}
+
+// A scene which failed to load is left as `SceneInvalid`, even if its type was
+// read before the error.
+bool Scene::checkLoaded(bool loaded) {
+  if(!loaded) {
+    type = SceneInvalid;
+  }
+  return loaded;
+}
+
+bool Scene::loadBinary() {
+  SceneBinary binary;
+  if(!binary.open(mBinary.view())) {
     dialog::error("Failure"_sv,
-      "Could not parse scene {}\n"
-      "Expected object.",
+      "Could not parse compiled scene {}:\n"
+      "Invalid or unsupported file.",
       name);
     return false;
   }
 
-  auto maybeTitle = maybeRoot->expectStringField("title"_sv);
-  if(!maybeTitle.present()) {
-    dialog::warning("Warning",
-      "Could not find title in scene {}, fallback will be used.",
-      name);
+  const auto &header = binary.header();
+  title = binary.string(header.title);
+  if(title.empty()) {
     title = name;
-  } else {
-    title = *maybeTitle;
   }
+  background = binary.string(header.background);
+  music = binary.string(header.music);
+  next = binary.string(header.next);
 
-  auto maybeBackground = maybeRoot->expectStringField("background"_sv);
-  if(maybeBackground.present()) {
-    background = *maybeBackground;
-  }
-
-  auto maybeMusic = maybeRoot->expectStringField("music"_sv);
-  if(maybeMusic.present()) {
-    music = *maybeMusic;
+  switch(header.type) {
+  case SceneField:
+    type = SceneField;
+    // TODO: FieldScene loading
+    break;
+  case SceneStory:
+    type = SceneStory;
+    story.emplace();
+    if(!story->load(binary)) {
+      return false;
+    }
+    break;
+  default:
+    dialog::error("Failure"_sv,
+      "Could not parse compiled scene {}:\n"
+      "Unknown scene type {}.",
+      name, header.type);
+    return false;
   }
+  return true;
+}
 
-  auto maybeNext =  maybeRoot->expectStringField("next"_sv);
-  if(maybeNext.present()) {
-    next = *maybeNext;
+bool Scene::load(JSONReader &reader) {
+  bool hasTitle = false;
+  bool hasActors = false;
+  bool hasCommands = false;
+  StringView key;
+  StringView value;
+  reader.beginObject();
+  while(reader.nextKey(key)) {
+    if(key.equals("title"_sv)) {
+      if(!reader.readString(value)) {
+        break;
+      }
+      title = value;
+      hasTitle = true;
+    } else if(key.equals("background"_sv)) {
+      if(!reader.readString(value)) {
+        break;
+      }
+      background = value;
+    } else if(key.equals("music"_sv)) {
+      if(!reader.readString(value)) {
+        break;
+      }
+      music = value;
+    } else if(key.equals("next"_sv)) {
+      if(!reader.readString(value)) {
+        break;
+      }
+      next = value;
+    } else if(key.equals("type"_sv)) {
+      if(!reader.readString(value)) {
+        break;
+      }
+      if(value.equalsIgnoreCase("field"_sv)) {
+        type = SceneField;
+        // TODO: FieldScene loading
+      } else if(value.equalsIgnoreCase("story"_sv)) {
+        type = SceneStory;
+      } else {
+        dialog::error("Failure"_sv,
+          "Could not parse scene {}:\n"
+          "Unknown scene type {}.",
+          name, value);
+        return false;
+      }
+    } else if(key.equals("actors"_sv)) {
+      // the story's fields can come before the type
+      if(!story.present()) {
+        story.emplace();
+      }
+      if(!story->loadActors(reader)) {
+        return false;
+      }
+      hasActors = true;
+    } else if(key.equals("commands"_sv)) {
+      if(!hasActors) {
+        dialog::error("Failure"_sv,
+          "Could not parse story scene:\n"
+          "`actors` must come before `commands`.");
+        return false;
+      }
+      if(!story->loadCommands(reader)) {
+        return false;
+      }
+      hasCommands = true;
+    } else if(!reader.skip()) {
+      break;
+    }
   }
 
-  auto maybeType = maybeRoot->expectStringField("type"_sv);
-  if(!maybeType.present()) {
+  if(reader.failed() || !reader.finish()) {
     dialog::error("Failure"_sv,
       "Could not parse scene {}:\n"
-      "Could not find type.",
-      name);
+      "{}",
+      name,
+      reader.error());
     return false;
   }
 
-  if(maybeType->equalsIgnoreCase("field"_sv)) {
-    type = SceneField;
-    // TODO: FieldScene loading
-  } else if(maybeType->equalsIgnoreCase("story"_sv)) {
-    type = SceneStory;
-    story.emplace();
-    if(!story->load(*maybeRoot)) {
+  if(!hasTitle) {
+    dialog::warning("Warning",
+      "Could not find title in scene {}, fallback will be used.",
+      name);
+    title = name;
+  }
+
+  switch(type) {
+  case SceneField:
+    break;
+  case SceneStory:
+    if(!hasActors) {
+      dialog::error("Failure"_sv,
+        "Could not parse story scene:\n"
+        "Could not find `actors`.");
+      return false;
+    }
+    if(!hasCommands) {
+      dialog::error("Failure"_sv,
+        "Could not parse story scene:\n"
+        "Could not find `commands`.");
       return false;
     }
-  } else {
+    break;
+  default:
     dialog::error("Failure"_sv,
       "Could not parse scene {}:\n"
-      "Unknown scene type {}.",
-      name, maybeType);
+      "Could not find type.",
+      name);
     return false;
   }
   return true;
 }
 
 bool Scene::save(data::RW &file) {
-  ScratchSlice<json::Object::Pair> pairs{4};
+  JSONWriter writer{file};
+  writer.beginObject();
   if(!title.empty()) {
-    pairs.push({"title"_sv, title.view()});
+    writer.key("title"_sv);
+    writer.string(title.view());
   }
   if(!background.empty()) {
-    pairs.push({"background"_sv, background.view()});
+    writer.key("background"_sv);
+    writer.string(background.view());
   }
   if(!music.empty()) {
-    pairs.push({"music"_sv, music.view()});
+    writer.key("music"_sv);
+    writer.string(music.view());
   }
   if(!next.empty()) {
-    pairs.push({"next"_sv, next.view()});
+    writer.key("next"_sv);
+    writer.string(next.view());
   }
   switch(type) {
   case SceneField:
-    pairs.push({"type"_sv, "field"_sv});
+    writer.key("type"_sv);
+    writer.string("field"_sv);
     break;
-  case SceneStory: {
-    pairs.push({"type"_sv, "story"_sv});
-    auto object = story->toObject();
-    for(const auto &pair: object.pairs()) {
-      pairs.push(pair);
-    }
+  case SceneStory:
+    writer.key("type"_sv);
+    writer.string("story"_sv);
+    story->save(writer);
     break;
-  }
   case SceneInvalid:
   case SceneMax:
     return false;
   }
-  json::Object object{pairs.view()};
-  auto res = json::encode(object);
-  return file.write(res.view());
+  writer.endObject();
+  return writer.finish();
 }
 
 } // namespace sigmoid
\ No newline at end of file
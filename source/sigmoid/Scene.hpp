@@ -6,11 +6,14 @@ Scene.hpp
 Scene definition
 */
 
+#include "JSONReader.hpp"
+#include "JSONWriter.hpp"
+#include "SceneBinary.hpp"
 #include "StoryScene.hpp"
+#include <nwge/common/array.hpp>
 #include <nwge/common/slice.hpp>
 #include <nwge/common/string.hpp>
 #include <nwge/data/bundle.hpp>
-#include <nwge/json.hpp>
 
 namespace sigmoid {
 
@@ -40,7 +43,17 @@ class Scene {
 
   void enqueue(nwge::data::Bundle &bundle);
   bool load(nwge::data::RW &file);
+  // Loads a JSON scene as it is read.
+  bool load(JSONReader &reader);
   bool save(nwge::data::RW &file);
+
+private:
+  // Backing storage of a compiled scene. Strings of the scene's commands point
+  // directly into it.
+  nwge::Array<char> mBinary;
+
+  bool loadBinary();
+  bool checkLoaded(bool loaded);
 };
 
 } // namespace sigmoid
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "SceneBinary.hpp"
+#include <algorithm>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+bool SceneBinary::detect(ArrayView<const char> data) {
+  if(data.size() < cSceneBinaryMagic.size()) {
+    return false;
+  }
+  return std::equal(
+    cSceneBinaryMagic.begin(), cSceneBinaryMagic.end(),
+    data.begin());
+}
+
+static inline bool inBounds(usize total, u32 offset, usize size) {
+  return offset <= total && size <= total - offset;
+}
+
+bool SceneBinary::open(ArrayView<const char> data) {
+  if(!detect(data) || data.size() < sizeof(SceneBinaryHeader)) {
+    return false;
+  }
+  // the file is read into a freshly allocated buffer, so it is suitably
+  // aligned for the tables
+  mHeader = reinterpret_cast<const SceneBinaryHeader*>(data.begin());
+  if(mHeader->version != cSceneBinaryVersion) {
+    return false;
+  }
+
+  usize actorsSize = usize(mHeader->actorCount) * sizeof(SceneBinaryActor);
+  usize commandsSize = usize(mHeader->commandCount) * sizeof(SceneBinaryCommand);
+  if(!inBounds(data.size(), mHeader->actorOffset, actorsSize)
+  || !inBounds(data.size(), mHeader->commandOffset, commandsSize)
+  || !inBounds(data.size(), mHeader->stringsOffset, mHeader->stringsSize)
+  || mHeader->actorOffset % alignof(SceneBinaryActor) != 0
+  || mHeader->commandOffset % alignof(SceneBinaryCommand) != 0) {
+    return false;
+  }
+  mActors = {
+    reinterpret_cast<const SceneBinaryActor*>(data.begin() + mHeader->actorOffset),
+    mHeader->actorCount
+  };
+  mCommands = {
+    reinterpret_cast<const SceneBinaryCommand*>(data.begin() + mHeader->commandOffset),
+    mHeader->commandCount
+  };
+  mStrings = data.begin() + mHeader->stringsOffset;
+  mStringsSize = mHeader->stringsSize;
+
+  if(!validString(mHeader->title) || !validString(mHeader->background)
+  || !validString(mHeader->music) || !validString(mHeader->next)) {
+    return false;
+  }
+  for(const auto &actor: mActors) {
+    if(!validString(actor.id) || !validString(actor.name)
+    || !validString(actor.sheet)) {
+      return false;
+    }
+  }
+  for(const auto &command: mCommands) {
+    for(const auto &ref: command.strings) {
+      if(!validString(ref)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+const SceneBinaryHeader &SceneBinary::header() const {
+  return *mHeader;
+}
+
+ArrayView<const SceneBinaryActor> SceneBinary::actors() const {
+  return mActors;
+}
+
+ArrayView<const SceneBinaryCommand> SceneBinary::commands() const {
+  return mCommands;
+}
+
+StringView SceneBinary::string(SceneBinaryString ref) const {
+  return {mStrings + ref.offset, ref.size};
+}
+
+bool SceneBinary::validString(SceneBinaryString ref) const {
+  return inBounds(mStringsSize, ref.offset, ref.size);
+}
+
+} // namespace sigmoid
@@ -0,0 +1,128 @@
+#pragma once
+
+/*
+SceneBinary.hpp
+---------------
+Compiled scene format
+*/
+
+#include <array>
+#include <nwge/common/array.hpp>
+#include <nwge/common/string.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Reference to a string in the string pool of a compiled scene.
+ *
+ * `offset` is relative to the start of the string pool. Strings are not NUL
+ * terminated.
+ */
+struct SceneBinaryString {
+  u32 offset = 0;
+  u32 size = 0;
+};
+
+/**
+ * @brief Header of a compiled scene.
+ *
+ * Compiled scenes (SCB) are generated from the JSON scene files by the bundle
+ * plugin. Cooked bundles store the compiled scene under the scene's usual
+ * `.SCN` entry, the loader tells the two apart by the magic number. All
+ * offsets are relative to the start of the file and all values are little
+ * endian.
+ */
+struct SceneBinaryHeader {
+  std::array<char, 4> magic;
+  u32 version;
+  u32 type;
+  u32 actorCount;
+  u32 actorOffset;
+  u32 commandCount;
+  u32 commandOffset;
+  u32 stringsOffset;
+  u32 stringsSize;
+  u32 reserved;
+  SceneBinaryString title;
+  SceneBinaryString background;
+  SceneBinaryString music;
+  SceneBinaryString next;
+};
+static_assert(sizeof(SceneBinaryHeader) == 72);
+
+struct SceneBinaryActor {
+  SceneBinaryString id;
+  SceneBinaryString name;
+  SceneBinaryString sheet;
+  s32 sheetWidth;
+  s32 sheetHeight;
+};
+static_assert(sizeof(SceneBinaryActor) == 32);
+
+/**
+ * @brief Fixed-layout command record.
+ *
+ * The meaning of `strings` depends on the command code:
+ *  * sprite: ID, actor
+ *  * speak: actor, text
+ *  * background: background, music
+ *
+ * `time` is the duration of wait commands, the reveal speed of speak
+ * commands & the transition time of sprite & background commands. The easing
+ * of sprite commands is kept in the flags.
+ */
+struct SceneBinaryCommand {
+  u32 code;
+  u32 flags;
+  s32 portrait;
+  f32 time;
+  std::array<SceneBinaryString, 2> strings;
+  std::array<f32, 2> pos;
+  std::array<f32, 2> size;
+};
+static_assert(sizeof(SceneBinaryCommand) == 48);
+
+static constexpr std::array<char, 4> cSceneBinaryMagic{'S', 'C', 'B', '\x1A'};
+static constexpr u32 cSceneBinaryVersion = 2;
+// Command record flags
+static constexpr u32 cSceneBinaryHide = 1 << 0;
+static constexpr u32 cSceneBinaryHasBackground = 1 << 1;
+static constexpr u32 cSceneBinaryHasMusic = 1 << 2;
+static constexpr u32 cSceneBinaryEaseShift = 8;
+static constexpr u32 cSceneBinaryEaseMask = 0xFF << cSceneBinaryEaseShift;
+
+/**
+ * @brief Read-only view over a compiled scene.
+ *
+ * Nothing is copied, all accessors point directly into the viewed buffer, so
+ * it must outlive the view.
+ */
+class SceneBinary {
+public:
+  [[nodiscard]]
+  static bool detect(nwge::ArrayView<const char> data);
+
+  // Validates the header, tables & all string references.
+  bool open(nwge::ArrayView<const char> data);
+
+  [[nodiscard]]
+  const SceneBinaryHeader &header() const;
+  [[nodiscard]]
+  nwge::ArrayView<const SceneBinaryActor> actors() const;
+  [[nodiscard]]
+  nwge::ArrayView<const SceneBinaryCommand> commands() const;
+  [[nodiscard]]
+  nwge::StringView string(SceneBinaryString ref) const;
+
+private:
+  const SceneBinaryHeader *mHeader = nullptr;
+  nwge::ArrayView<const SceneBinaryActor> mActors;
+  nwge::ArrayView<const SceneBinaryCommand> mCommands;
+  const char *mStrings = nullptr;
+  u32 mStringsSize = 0;
+
+  [[nodiscard]]
+  bool validString(SceneBinaryString ref) const;
+};
+
+} // namespace sigmoid
@@ -0,0 +1,92 @@
+#include "SceneChain.hpp"
+#include "Debug.hpp"
+#include <nwge/console.hpp>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+SceneChain::SceneChain(Game &game, Scene &scene)
+  : mGame(game),
+    mScene(scene)
+{}
+
+void SceneChain::start() {
+  setUp(mScene, mPrefetcher);
+  startNext();
+}
+
+/*
+Scenes are parsed by the engine's loader, so we only learn whether the next
+scene has loaded once the batch it was enqueued in is done.
+*/
+void SceneChain::loaded() {
+  resources().loaded();
+  mPrefetcher.loaded();
+  if(mNextState == NextReady) {
+    mNextPrefetcher.loaded();
+    return;
+  }
+  if(mNextState != NextLoading) {
+    return;
+  }
+  if(mNext->type == SceneInvalid) {
+    console::warn("Could not preload scene {}.", mNext->name);
+    mNextState = NextNone;
+    return;
+  }
+  mNextState = NextReady;
+  setUp(*mNext, mNextPrefetcher);
+  mNextPrefetcher.advance(0);
+}
+
+bool SceneChain::advance() {
+  if(mNextState != NextReady) {
+    return false;
+  }
+  mScene = std::move(*mNext);
+  mPrefetcher = std::move(mNextPrefetcher);
+  if(mScene.story.present()) {
+    mPrefetcher.rebind(*mScene.story);
+  }
+  mNextPrefetcher = {};
+  startNext();
+  return true;
+}
+
+bool SceneChain::waiting() const {
+  return mNextState == NextLoading;
+}
+
+Prefetcher &SceneChain::prefetcher() {
+  return mPrefetcher;
+}
+
+void SceneChain::startNext() {
+  mNextState = NextNone;
+  if(mScene.next.empty()) {
+    return;
+  }
+  mNext.emplace(mScene.next.view());
+  mNext->enqueue(*mGame.bundle);
+  mNextState = NextLoading;
+  if(statsEnabled()) {
+    console::print("Preloading scene {}.", mScene.next);
+  }
+}
+
+void SceneChain::setUp(Scene &scene, Prefetcher &prefetcher) {
+  if(scene.type != SceneStory) {
+    return;
+  }
+  auto &story = *scene.story;
+  // the scene's own background is prefetched like any other
+  SymbolID background = cNoSymbol;
+  if(!scene.background.empty()) {
+    background = story.ensureBackground(scene.background);
+  }
+  prefetcher = {*mGame.bundle, mGame.atlas, story, background,
+    mGame.prefetchWindow};
+}
+
+} // namespace sigmoid
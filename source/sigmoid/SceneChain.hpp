@@ -0,0 +1,57 @@
+#pragma once
+
+/*
+SceneChain.hpp
+--------------
+Plays scenes one after another
+*/
+
+#include "Game.hpp"
+#include "Prefetcher.hpp"
+#include "Scene.hpp"
+#include <nwge/common/maybe.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Follows `Scene::next` from one scene to the next.
+ *
+ * While a scene plays, the scene after it is loaded & the assets of its first
+ * commands are prefetched, so switching to it doesn't have to wait on loads.
+ * Textures both scenes use are shared through the `ResourceCache`.
+ */
+class SceneChain {
+public:
+  SceneChain(Game &game, Scene &scene);
+
+  // Starts playing the scene, which must have been loaded.
+  void start();
+  // Call on `Event::PostLoad`, instead of `ResourceCache::loaded()`.
+  void loaded();
+  // Makes the next scene the current one. Returns false if it's not loaded.
+  bool advance();
+  // Whether the next scene is still loading.
+  [[nodiscard]]
+  bool waiting() const;
+
+  Prefetcher &prefetcher();
+
+private:
+  enum NextState {
+    NextNone,
+    NextLoading,
+    NextReady,
+  };
+
+  Game &mGame;
+  Scene &mScene;
+  Prefetcher mPrefetcher;
+  nwge::Maybe<Scene> mNext;
+  Prefetcher mNextPrefetcher;
+  NextState mNextState = NextNone;
+
+  void startNext();
+  void setUp(Scene &scene, Prefetcher &prefetcher);
+};
+
+} // namespace sigmoid
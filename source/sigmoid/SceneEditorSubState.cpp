@@ -1,6 +1,9 @@
+#include "DrawList.hpp"
+#include "Redraw.hpp"
 #include "StoryScene.hpp"
 #include "imgui/imgui.hpp"
 #include "states.hpp"
+#include <algorithm>
 #include <nwge/common/cast.hpp>
 #include <nwge/render/AspectRatio.hpp>
 #include <nwge/render/draw.hpp>
@@ -52,14 +55,16 @@ class SceneEditorSubState final: public SubState {
   }
 
   void render() const override {
+    redraw().frame();
     render::clear({0, 0, 0});
     if(mShowBackground) {
-      m4x3.rect({
+      drawList().image(m4x3.rect({
         {0, 0, 0.9},
         {1, 1},
         mBackground.id
-      }).draw();
+      }), false);
     }
+    drawList().flush();
   }
 
 private:
@@ -101,42 +106,53 @@ class SceneEditorSubState final: public SubState {
   }
 
   void copyStoryCommands() {
-    if(mScene.story->commands.empty()) {
+    if(mScene.story->commands.size() == 0) {
       mCommands.clear();
       return;
     }
     mCommands = {mScene.story->commands.size()};
-    for(const auto &src: mScene.story->commands) {
+    const auto &story = *mScene.story;
+    for(const auto &src: story.commands) {
       CommandInfo info{src.code};
       switch(info.code) {
-      case CommandSprite:
-        safeCopyString(src.sprite->id, info.idBuf);
-        info.shown = !src.sprite->hide;
-        if(src.sprite->pos.x != -1 && src.sprite->pos.y != -1) {
+      case CommandSprite: {
+        const auto &sprite = story.sprite(src);
+        safeCopyString(story.sprites.name(sprite.id), info.idBuf);
+        info.shown = !sprite.hide;
+        if(sprite.pos.x != -1 && sprite.pos.y != -1) {
           info.move = true;
-          info.posX = src.sprite->pos.x;
-          info.posY = src.sprite->pos.y;
+          info.posX = sprite.pos.x;
+          info.posY = sprite.pos.y;
         }
-        if(src.sprite->size.x != -1 && src.sprite->size.y != -1) {
+        if(sprite.size.x != -1 && sprite.size.y != -1) {
           info.scale = true;
-          info.sizeX = src.sprite->size.x;
-          info.sizeY = src.sprite->size.y;
+          info.sizeX = sprite.size.x;
+          info.sizeY = sprite.size.y;
         }
-        safeCopyString(src.sprite->actor, info.actorBuf);
-        info.portraitX = src.sprite->portrait;
+        safeCopyString(story.actorIDs.name(sprite.actor), info.actorBuf);
+        info.portraitX = sprite.portrait;
+        info.time = sprite.time;
+        info.ease = sprite.ease;
         break;
-      case CommandSpeak:
-        safeCopyString(src.speak->actor, info.actorBuf);
-        info.portraitX = src.speak->portrait;
-        safeCopyString(src.speak->text, info.textBuf);
+      }
+      case CommandSpeak: {
+        const auto &speak = story.speak(src);
+        safeCopyString(story.actorIDs.name(speak.actor), info.actorBuf);
+        info.portraitX = speak.portrait;
+        safeCopyString(speak.text, info.textBuf);
+        info.speed = speak.speed;
         break;
+      }
       case CommandWait:
-        info.waitTime = src.wait->duration;
+        info.waitTime = story.wait(src).duration;
         break;
-      case CommandBackground:
-        safeCopyString(src.background->background, info.backgroundBuf);
-        safeCopyString(src.background->music, info.musicBuf);
+      case CommandBackground: {
+        const auto &background = story.background(src);
+        safeCopyString(story.backgrounds.name(background.background), info.backgroundBuf);
+        safeCopyString(story.musics.name(background.music), info.musicBuf);
+        info.time = background.time;
         break;
+      }
       default:
         break;
       }
@@ -184,12 +200,13 @@ class SceneEditorSubState final: public SubState {
     if(!mScene.story.present()) {
       mScene.story.emplace();
     }
+    // everything is rebuilt from the editor's copy
+    mScene.story->clear();
     setUpStoryActors();
     setUpStoryCommands();
   }
 
   void setUpStoryActors() {
-    mScene.story->actors.clear();
     if(mActors.size() == 0) {
       return;
     }
@@ -203,55 +220,68 @@ class SceneEditorSubState final: public SubState {
         src.sheetWidth,
         src.sheetHeight
       };
-      mScene.story->actors.push(actor);
+      mScene.story->addActor(std::move(actor));
     }
   }
 
   void setUpStoryCommands() {
+    auto &story = *mScene.story;
     if(mCommands.size() == 0) {
-      mScene.story->commands = {};
       return;
     }
-    mScene.story->commands = {mCommands.size()};
+    story.commands = {mCommands.size()};
     for(usize i = 0; i < mCommands.size(); ++i) {
-      auto &command = mScene.story->commands[i];
       const auto &src = mCommands[i];
-      command.code = src.code;
       switch(src.code) {
-      case CommandSprite:
-        command.sprite.emplace();
-        command.sprite->id = src.idBuf.data();
-        command.sprite->hide = !src.shown;
+      case CommandSprite: {
+        SpriteCommand sprite;
+        sprite.id = story.ensureSprite(src.idBuf.data());
+        sprite.hide = !src.shown;
         if(src.move) {
-          command.sprite->pos.x = src.posX;
-          command.sprite->pos.y = src.posY;
+          sprite.pos.x = src.posX;
+          sprite.pos.y = src.posY;
         }
         if(src.scale) {
-          command.sprite->size.x = src.sizeX;
-          command.sprite->size.y = src.sizeY;
+          sprite.size.x = src.sizeX;
+          sprite.size.y = src.sizeY;
         }
-        command.sprite->actor = src.actorBuf.data();
-        command.sprite->portrait = src.portraitX;
+        sprite.actor = story.ensureActor(src.actorBuf.data());
+        sprite.portrait = src.portraitX;
+        sprite.time = src.time > 0 ? src.time : 0.0f;
+        sprite.ease = src.ease >= 0 && src.ease < EaseMax ? Easing(src.ease) : EaseLinear;
+        story.commands.push(story.addCommand(sprite));
         break;
-      case CommandSpeak:
-        command.speak.emplace();
-        command.speak->actor = src.actorBuf.data();
-        command.speak->portrait = src.portraitX;
-        command.speak->text = src.textBuf.data();
+      }
+      case CommandSpeak: {
+        SpeakCommand speak;
+        speak.actor = story.ensureActor(src.actorBuf.data());
+        speak.portrait = src.portraitX;
+        speak.text = story.storeText(src.textBuf.data());
+        speak.speed = src.speed > 0 ? src.speed : 0.0f;
+        story.commands.push(story.addCommand(speak));
         break;
-      case CommandWait:
-        command.wait.emplace();
-        command.wait->duration = src.waitTime;
+      }
+      case CommandWait: {
+        WaitCommand wait;
+        wait.duration = src.waitTime;
+        story.commands.push(story.addCommand(wait));
         break;
-      case CommandBackground:
-        command.background.emplace();
-        command.background->background = src.backgroundBuf.data();
-        command.background->music = src.musicBuf.data();
+      }
+      case CommandBackground: {
+        BackgroundCommand background;
+        if(src.backgroundBuf[0] != '\0') {
+          background.background = story.ensureBackground(src.backgroundBuf.data());
+        }
+        if(src.musicBuf[0] != '\0') {
+          background.music = story.ensureMusic(src.musicBuf.data());
+        }
+        background.time = src.time > 0 ? src.time : 0.0f;
+        story.commands.push(story.addCommand(background));
         break;
+      }
       default:
         break;
       }
-      mScene.story->commands[i] = command;
     }
   }
 
@@ -281,8 +311,14 @@ class SceneEditorSubState final: public SubState {
     ImGui::InputText("Next", mNextBuf.data(), cBufSize,
       ImGuiInputTextFlags_CharsUppercase);
 
+    // saving would drop the actor of such a command, so it's refused
+    ssize unknownActor = mScene.type == SceneStory ? findUnknownActor() : -1;
     if(ImGui::Button("Save")) {
-      nqSaveSceneInfo();
+      if(unknownActor < 0) {
+        nqSaveSceneInfo();
+      } else {
+        mSelectedCommand = unknownActor;
+      }
     }
     ImGui::SameLine();
     if(ImGui::Button("Restore")) {
@@ -292,6 +328,10 @@ class SceneEditorSubState final: public SubState {
     if(ImGui::Button("Return")) {
       setEditorSubState(gameInfoEditor(mInfo));
     }
+    if(unknownActor >= 0) {
+      ImGui::TextColored(cErrorColor, "Can't save: command %d uses unknown actor `%s`.",
+        s32(unknownActor), mCommands[unknownActor].actorBuf.data());
+    }
 
     ImGui::End();
   }
@@ -307,6 +347,16 @@ class SceneEditorSubState final: public SubState {
   Slice<ActorInfo> mActors{4};
   ssize mSelectedActor = -1;
 
+  [[nodiscard]]
+  bool hasActor(const StringView &id) const {
+    for(const auto &actor: mActors) {
+      if(actor.id.view() == id) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   void actorWindow() {
     if(!ImGui::Begin("Actors", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
       ImGui::End();
@@ -331,6 +381,9 @@ class SceneEditorSubState final: public SubState {
         ImGuiInputTextFlags_CharsUppercase);
       ImGui::InputInt("Sheet width", &actor.sheetWidth);
       ImGui::InputInt("Sheet height", &actor.sheetHeight);
+      // scenes reject sheets without cells
+      actor.sheetWidth = std::max(actor.sheetWidth, 1);
+      actor.sheetHeight = std::max(actor.sheetHeight, 1);
       if(ImGui::Button("Deselect")) {
         mSelectedActor = -1;
       }
@@ -369,6 +422,10 @@ class SceneEditorSubState final: public SubState {
     bool scale = false;
     f32 sizeX = 0;
     f32 sizeY = 0;
+    s32 ease = EaseLinear;
+
+    // used by sprite & background
+    f32 time = 0;
 
     // used by speak & sprite
     std::array<char, cBufSize> actorBuf{};
@@ -377,6 +434,7 @@ class SceneEditorSubState final: public SubState {
 
     // used by speak
     std::array<char, cBufSize> textBuf{};
+    f32 speed = 0;
 
     // used by wait
     f32 waitTime = 0;
@@ -388,6 +446,19 @@ class SceneEditorSubState final: public SubState {
   Slice<CommandInfo> mCommands{4};
   ssize mSelectedCommand = -1;
 
+  // Returns the first sprite or speak command whose actor isn't defined, or -1.
+  [[nodiscard]]
+  ssize findUnknownActor() const {
+    for(usize i = 0; i < mCommands.size(); ++i) {
+      const auto &command = mCommands[i];
+      bool usesActor = command.code == CommandSprite || command.code == CommandSpeak;
+      if(usesActor && !hasActor(command.actorBuf.data())) {
+        return saturate_cast<ssize>(i);
+      }
+    }
+    return -1;
+  }
+
   void commandWindow() {
     if(!ImGui::Begin("Commands", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
       ImGui::End();
@@ -463,7 +534,19 @@ class SceneEditorSubState final: public SubState {
     ImGui::End();
   }
 
-  static void spriteCommandOptions(CommandInfo &info) {
+  static constexpr std::array<const char*, EaseMax> cEasingLabels{
+    "Linear", "Ease in", "Ease out", "Ease in & out",
+  };
+  static constexpr ImVec4 cErrorColor{1.0f, 0.4f, 0.4f, 1.0f};
+
+  void actorOptions(CommandInfo &info) const {
+    ImGui::InputText("Actor", info.actorBuf.data(), cBufSize);
+    if(!hasActor(info.actorBuf.data())) {
+      ImGui::TextColored(cErrorColor, "No such actor.");
+    }
+  }
+
+  void spriteCommandOptions(CommandInfo &info) const {
     ImGui::InputText("ID", info.idBuf.data(), cBufSize);
     ImGui::Checkbox("Shown", &info.shown);
 
@@ -475,16 +558,20 @@ class SceneEditorSubState final: public SubState {
     ImGui::InputFloat("Size X", &info.sizeX);
     ImGui::InputFloat("Size Y", &info.sizeY);
 
-    ImGui::InputText("Actor", info.actorBuf.data(), cBufSize);
+    ImGui::InputFloat("Time", &info.time);
+    ImGui::Combo("Easing", &info.ease, cEasingLabels.data(), EaseMax);
+
+    actorOptions(info);
     ImGui::InputInt("Portrait X", &info.portraitX);
     ImGui::InputInt("Portrait Y", &info.portraitY);
   }
 
-  static void speakCommandOptions(CommandInfo &info) {
-    ImGui::InputText("Actor", info.actorBuf.data(), cBufSize);
+  void speakCommandOptions(CommandInfo &info) const {
+    actorOptions(info);
     ImGui::InputInt("Portrait X", &info.portraitX);
     ImGui::InputInt("Portrait Y", &info.portraitY);
     ImGui::InputText("Text", info.textBuf.data(), cBufSize);
+    ImGui::InputFloat("Speed", &info.speed);
   }
 
   static void waitCommandOptions(CommandInfo &info) {
@@ -496,6 +583,7 @@ class SceneEditorSubState final: public SubState {
       ImGuiInputTextFlags_CharsUppercase);
     ImGui::InputText("Music", info.musicBuf.data(), cBufSize,
       ImGuiInputTextFlags_CharsUppercase);
+    ImGui::InputFloat("Fade Time", &info.time);
   }
 };
 
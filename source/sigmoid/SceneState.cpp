@@ -1,4 +1,6 @@
+#include "Debug.hpp"
 #include "states.hpp"
+#include <nwge/console.hpp>
 #include <nwge/render/window.hpp>
 
 using namespace nwge;
@@ -12,9 +14,7 @@ class SceneState final: public State {
   {}
 
   bool preload() override {
-    mBundle
-      .load({"sigmoid.bndl"_sv})
-      .nqFont("INTER.CFN"_sv, mFont);
+    mFont = engineFont();
 
     const auto &name = mScene.name;
     if(name.empty()) {
@@ -23,32 +23,47 @@ class SceneState final: public State {
     }
     ScratchArray<char> filename = ScratchString::formatted("{}.scn", name);
     toUpper(filename.view());
-    mGame.bundle
-      .nqCustom(filename.view(), mScene);
+    mGame.bundle->nqCustom(filename.view(), mScene);
+    if(!mGame.atlasManifest.empty() && !mGame.atlas.loaded()) {
+      mGame.bundle->nqCustom(mGame.atlasManifest, mGame.atlas);
+    }
     return true;
   }
 
   bool init() override {
-    switch(mScene.type) {
-    case SceneField:
-      dialog::info("SceneState"_sv,
-        "Field scene not implemented yet."_sv);
-      return false;
-    case SceneStory:
-      pushSubStatePtr(storyScene(mData));
+    resources().loaded();
+    mChain.start();
+    return play();
+  }
+
+  bool on(Event &evt) override {
+    switch(evt.type) {
+    case Event::PostLoad:
+      // while a scene plays, its SubState passes the event on instead
+      if(!mPlaying) {
+        mChain.loaded();
+      }
       break;
     default:
-      NWGE_UNREACHABLE("Invalid scene type");
+      break;
     }
-
     return true;
   }
 
   bool tick([[maybe_unused]] f32 delta) override {
     /*
     We only reach here once the appropriate scene SubState has been popped.
-    Return to menu.
+    Carry on with the next scene, which has usually been preloaded by now, or
+    return to menu once there is none.
     */
+    mPlaying = false;
+    if(mChain.advance()) {
+      return play();
+    }
+    if(mChain.waiting()) {
+      resources().update();
+      return true;
+    }
     swapStatePtr(gameMenu(std::move(mGame)));
     return true;
   }
@@ -58,12 +73,36 @@ class SceneState final: public State {
   }
 
 private:
-  data::Bundle mBundle;
+  bool play() {
+    switch(mScene.type) {
+    case SceneField:
+      dialog::info("SceneState"_sv,
+        "Field scene not implemented yet."_sv);
+      return false;
+    case SceneStory: {
+      if(statsEnabled()) {
+        const auto &stats = mScene.story->arena.stats();
+        console::print("Scene {}: {} allocations from {} blocks ({}/{} bytes)",
+          mScene.name, stats.allocations, stats.blocks,
+          stats.used, stats.reserved);
+      }
+      pushSubStatePtr(storyScene(mData));
+      mPlaying = true;
+      break;
+    }
+    default:
+      NWGE_UNREACHABLE("Invalid scene type");
+    }
+
+    return true;
+  }
 
-  render::Font mFont;
+  SharedFont mFont;
   Game mGame;
   Scene mScene;
-  SceneStateData mData{mGame, mScene, mFont};
+  SceneChain mChain{mGame, mScene};
+  SceneStateData mData{mGame, mScene, mFont, mChain};
+  bool mPlaying = false;
 };
 
 State *scene(Game &&game, const StringView &sceneName) {
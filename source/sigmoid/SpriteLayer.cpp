@@ -0,0 +1,185 @@
+#include "SpriteLayer.hpp"
+#include <nwge/console.hpp>
+#include <algorithm>
+#include <functional>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+SpriteLayer::SpriteLayer(usize count)
+  : mCount(count),
+    mActors(count),
+    mPortraits(count),
+    mChannels(count * ChannelMax),
+    mCells(count),
+    mTextures(count)
+{
+  std::fill(mActors.begin(), mActors.end(), cNoSymbol);
+  std::fill(mPortraits.begin(), mPortraits.end(), -1);
+  for(usize sprite = 0; sprite < count; ++sprite) {
+    mChannels[channelIndex(ChannelX, sprite)] = cDefaultPos.x;
+    mChannels[channelIndex(ChannelY, sprite)] = cDefaultPos.y;
+    mChannels[channelIndex(ChannelWidth, sprite)] = 0;
+    mChannels[channelIndex(ChannelHeight, sprite)] = 0;
+    mChannels[channelIndex(ChannelAlpha, sprite)] = 0;
+  }
+}
+
+void SpriteLayer::apply(const SpriteCommand &command,
+  const ArrayView<const AtlasCell> &cells, const SharedTexture &sheet)
+{
+  if(command.id == cNoSymbol || usize(command.id) >= mCount) {
+    return;
+  }
+  usize sprite = command.id;
+  // only sprites already on screen move, scale or fade out
+  bool shown = channel(ChannelAlpha, sprite) > 0;
+  f32 moveTime = shown ? command.time : 0;
+  if(command.actor != cNoSymbol) {
+    mActors[sprite] = command.actor;
+    mTextures[sprite] = sheet;
+  }
+  if(command.portrait >= 0) {
+    mPortraits[sprite] = command.portrait;
+  }
+  if(command.pos.x != -1 && command.pos.y != -1) {
+    set(ChannelX, sprite, command.pos.x, moveTime, command.ease);
+    set(ChannelY, sprite, command.pos.y, moveTime, command.ease);
+  }
+  if(command.size.x != -1 && command.size.y != -1) {
+    set(ChannelWidth, sprite, command.size.x, moveTime, command.ease);
+    set(ChannelHeight, sprite, command.size.y, moveTime, command.ease);
+  }
+  mDirty = true;
+
+  // a portrait the actor doesn't have shows nothing
+  s32 portrait = mPortraits[sprite];
+  if(portrait >= 0 && usize(portrait) < cells.size()) {
+    mCells[sprite] = cells[portrait];
+  } else {
+    mCells[sprite] = {};
+    mCells[sprite].extent = {0, 0};
+  }
+  if(command.hide) {
+    set(ChannelAlpha, sprite, 0, shown ? command.time : 0, command.ease);
+    return;
+  }
+  // a size the command tweens to counts as set already
+  glm::vec2 spriteSize = command.size.x != -1 && command.size.y != -1
+    ? command.size : size(sprite);
+  if(mActors[sprite] == cNoSymbol || portrait < 0) {
+    console::warn("Sprite {} has no actor & portrait, it stays hidden.", sprite);
+    set(ChannelAlpha, sprite, 0, 0, command.ease);
+  } else if(spriteSize.x <= 0 || spriteSize.y <= 0) {
+    console::warn("Sprite {} has no size, it stays hidden.", sprite);
+    set(ChannelAlpha, sprite, 0, 0, command.ease);
+  } else {
+    set(ChannelAlpha, sprite, 1, command.time, command.ease);
+  }
+}
+
+u32 SpriteLayer::channelIndex(Channel channel, usize sprite) const {
+  return u32(channel * mCount + sprite);
+}
+
+f32 SpriteLayer::channel(Channel channel, usize sprite) const {
+  return mChannels[channelIndex(channel, sprite)];
+}
+
+glm::vec2 SpriteLayer::pos(usize sprite) const {
+  return {channel(ChannelX, sprite), channel(ChannelY, sprite)};
+}
+
+glm::vec2 SpriteLayer::size(usize sprite) const {
+  return {channel(ChannelWidth, sprite), channel(ChannelHeight, sprite)};
+}
+
+void SpriteLayer::set(Channel channel, usize sprite, f32 value, f32 time, Easing ease) {
+  u32 target = channelIndex(channel, sprite);
+  if(time > 0) {
+    mTweens.add(target, mChannels[target], value, time, ease);
+  } else {
+    mTweens.cancel(target);
+    mChannels[target] = value;
+  }
+}
+
+bool SpriteLayer::onScreen(usize sprite) const {
+  if(channel(ChannelAlpha, sprite) <= 0 || !mTextures[sprite].present()
+    || !mCells[sprite].visible())
+  {
+    return false;
+  }
+  glm::vec2 half = size(sprite) * 0.5f;
+  glm::vec2 start = pos(sprite) - half;
+  glm::vec2 end = pos(sprite) + half;
+  return end.x > 0 && end.y > 0 && start.x < 1 && start.y < 1;
+}
+
+/*
+A sprite's depth is its bottom edge. Sprites at the same depth are ordered by
+texture & then by ID, which keeps the order stable between sorts.
+*/
+void SpriteLayer::update(f32 delta) {
+  if(!mTweens.empty()) {
+    mTweens.update(delta, {mChannels.data(), mChannels.size()});
+    mDirty = true;
+  }
+  if(!mDirty) {
+    return;
+  }
+  mDirty = false;
+  mOrder.clear();
+  for(usize sprite = 0; sprite < mCount; ++sprite) {
+    if(onScreen(sprite)) {
+      mOrder.push(u32(sprite));
+    }
+  }
+  std::sort(mOrder.begin(), mOrder.end(), [this](u32 lhs, u32 rhs){
+    f32 lhsDepth = pos(lhs).y + size(lhs).y * 0.5f;
+    f32 rhsDepth = pos(rhs).y + size(rhs).y * 0.5f;
+    if(lhsDepth != rhsDepth) {
+      return lhsDepth < rhsDepth;
+    }
+    const auto *lhsTexture = &*mTextures[lhs];
+    const auto *rhsTexture = &*mTextures[rhs];
+    if(lhsTexture != rhsTexture) {
+      return std::less<>{}(lhsTexture, rhsTexture);
+    }
+    return lhs < rhs;
+  });
+}
+
+/*
+Each sprite gets a depth of its own, so later ones are always in front. Textures
+are only marked as used once per run of sprites sharing them.
+*/
+void SpriteLayer::draw(DrawList &list, const render::AspectRatio &area) const {
+  f32 step = (cBackZ - cFrontZ) / f32(mOrder.size() + 1);
+  f32 z = cBackZ;
+  const render::Texture *texture = nullptr;
+  for(u32 sprite: mOrder) {
+    z -= step;
+    if(texture != &*mTextures[sprite]) {
+      texture = &mTextures[sprite].use();
+    }
+    const auto &cell = mCells[sprite];
+    glm::vec2 spriteSize = size(sprite);
+    glm::vec2 topLeft = pos(sprite) - spriteSize * 0.5f;
+    list.color({1, 1, 1, channel(ChannelAlpha, sprite)});
+    list.rect(
+      area.pos(cell.pos({topLeft, z}, spriteSize)),
+      area.size(cell.size(spriteSize)),
+      *texture,
+      cell.texCoord
+    );
+  }
+  list.color();
+}
+
+bool SpriteLayer::animating() const {
+  return !mTweens.empty();
+}
+
+} // namespace sigmoid
@@ -0,0 +1,115 @@
+#pragma once
+
+/*
+SpriteLayer.hpp
+---------------
+Sprites placed on screen by a story scene
+*/
+
+#include "Atlas.hpp"
+#include "DrawList.hpp"
+#include "ResourceCache.hpp"
+#include "StoryScene.hpp"
+#include "Tween.hpp"
+#include <nwge/common/array.hpp>
+#include <nwge/common/slice.hpp>
+#include <nwge/render/AspectRatio.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Table of a story scene's sprites, drawn as one layer.
+ *
+ * Sprites are indexed by the IDs `StoryScene::sprites` assigned to them, and
+ * each property is kept in an array of its own, so sprite commands are a
+ * handful of stores & drawing only touches what it reads.
+ *
+ * Sprites are drawn back to front, sprites lower on screen standing in front of
+ * those above them. Sprites at the same depth are grouped by texture, so
+ * actors sharing an atlas page are drawn one after another without switching
+ * textures. The draw order is only sorted again after a sprite command changed
+ * it or while sprites are moving, so a still crowd costs nothing but its draws.
+ *
+ * Position, size & opacity are channels of one flat array, which sprite
+ * commands with a time tween instead of setting.
+ */
+class SpriteLayer {
+public:
+  SpriteLayer() = default;
+  // `count` is the number of sprite IDs of the scene.
+  explicit SpriteLayer(usize count);
+
+  /*
+  Position & size are in the 4:3 area of the window, the position being the
+  sprite's center. Sprites start out in the center of the screen, and have no
+  size until a command gives them one.
+  */
+  static constexpr glm::vec2 cDefaultPos{0.5f, 0.5f};
+  // Sprites are drawn between these depths, above the background & under the
+  // text box.
+  static constexpr f32 cBackZ = 0.8f;
+  static constexpr f32 cFrontZ = 0.6f;
+
+  /**
+   * @brief Applies a sprite command.
+   *
+   * `cells` are the portraits of the command's actor & `sheet` the texture
+   * they're on. Properties the command leaves out keep their previous value.
+   * Showing a sprite which has no portrait or size yet leaves it hidden, with a
+   * warning.
+   *
+   * Commands with a time fade sprites in & out, and move & scale sprites that
+   * are already shown. Sprites which aren't shown yet appear where the command
+   * puts them.
+   */
+  void apply(const SpriteCommand &command,
+    const nwge::ArrayView<const AtlasCell> &cells, const SharedTexture &sheet);
+  // Advances tweens by `delta` seconds & sorts the draw order again if it
+  // changed. Call once per tick, before drawing.
+  void update(f32 delta);
+  void draw(DrawList &list, const nwge::render::AspectRatio &area) const;
+
+  // Whether sprites are moving, scaling or fading.
+  [[nodiscard]]
+  bool animating() const;
+
+private:
+  enum Channel: u32 {
+    ChannelX,
+    ChannelY,
+    ChannelWidth,
+    ChannelHeight,
+    ChannelAlpha,
+    ChannelMax,
+  };
+
+  usize mCount = 0;
+  nwge::Array<SymbolID> mActors;
+  nwge::Array<s32> mPortraits;
+  // One run of `mCount` values per channel.
+  nwge::Array<f32> mChannels;
+  Tweens mTweens;
+  // Resolved from actor & portrait when a command changes either.
+  nwge::Array<AtlasCell> mCells;
+  nwge::Array<SharedTexture> mTextures;
+
+  // IDs of the sprites to draw, back to front.
+  nwge::Slice<u32> mOrder{4};
+  bool mDirty = false;
+
+  [[nodiscard]]
+  u32 channelIndex(Channel channel, usize sprite) const;
+  [[nodiscard]]
+  f32 channel(Channel channel, usize sprite) const;
+  [[nodiscard]]
+  glm::vec2 pos(usize sprite) const;
+  [[nodiscard]]
+  glm::vec2 size(usize sprite) const;
+  // Sets a channel, tweening it over `time` seconds unless that's 0.
+  void set(Channel channel, usize sprite, f32 value, f32 time, Easing ease);
+
+  [[nodiscard]]
+  bool onScreen(usize sprite) const;
+};
+
+} // namespace sigmoid
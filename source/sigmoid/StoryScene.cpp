@@ -1,6 +1,7 @@
 #include "StoryScene.hpp"
-#include <nwge/json/builder.hpp>
+#include "CommandRegistry.hpp"
 #include <nwge/dialog.hpp>
+#include <array>
 
 using namespace nwge;
 
@@ -15,425 +16,573 @@ namespace sigmoid {
     FAIL(__VA_ARGS__);\
   }
 
-StringView StoryScene::ensureSprite(const StringView &sprite) {
-  for(const auto &oldSprite: sprites) {
-    if(oldSprite.view().equals(sprite)) {
-      return oldSprite.view();
-    }
-  }
-  sprites.push({sprite});
-  return sprites[sprites.size() - 1];
+SymbolID StoryScene::ensureSprite(const StringView &sprite) {
+  return sprites.intern(arena, sprite);
 }
 
-StringView StoryScene::ensureActor(const StringView &actor) {
-  for(const auto &oldActor: actors) {
-    if(oldActor.id.view().equals(actor)) {
-      return oldActor.id.view();
-    }
-  }
-  return {};
+SymbolID StoryScene::ensureActor(const StringView &actor) const {
+  return actorIDs.find(actor);
 }
 
-Actor *StoryScene::getActor(const StringView &actor) {
-  for(auto &oldActor: actors) {
-    if(oldActor.id.view().equals(actor)) {
-      return &oldActor;
-    }
+SymbolID StoryScene::addActor(Actor &&actor) {
+  if(actorIDs.find(actor.id) != cNoSymbol) {
+    return cNoSymbol;
   }
-  return nullptr;
+  actor.id = arena.copy(actor.id);
+  actor.name = arena.copy(actor.name);
+  actor.sheet = arena.copy(actor.sheet);
+  return insertActor(std::move(actor));
 }
 
-const Actor *StoryScene::getActor(const StringView &actor) const {
-  for(const auto &oldActor: actors) {
-    if(oldActor.id.view().equals(actor)) {
-      return &oldActor;
-    }
-  }
-  return nullptr;
+SymbolID StoryScene::insertActor(Actor &&actor) {
+  SymbolID id = actorIDs.intern(arena, actor.id);
+  actors.push(std::move(actor));
+  return id;
 }
 
-StringView StoryScene::ensureBackground(const StringView &background) {
-  for(const auto &oldBackground: backgrounds) {
-    if(oldBackground.view().equals(background)) {
-      return oldBackground.view();
-    }
+void StoryScene::clearActors() {
+  actors.clear();
+  actorIDs.clear();
+}
+
+Actor *StoryScene::getActor(SymbolID actor) {
+  if(actor < 0 || usize(actor) >= actors.size()) {
+    return nullptr;
   }
-  backgrounds.push({background});
-  return backgrounds[backgrounds.size() - 1];
+  return &actors[actor];
 }
 
-StringView StoryScene::ensureMusic(const StringView &music) {
-  for(const auto &oldMusic: musics) {
-    if(oldMusic.view().equals(music)) {
-      return oldMusic.view();
-    }
+const Actor *StoryScene::getActor(SymbolID actor) const {
+  if(actor < 0 || usize(actor) >= actors.size()) {
+    return nullptr;
   }
-  musics.push({music});
-  return musics[musics.size() - 1];
+  return &actors[actor];
+}
+
+SymbolID StoryScene::ensureBackground(const StringView &background) {
+  return backgrounds.intern(arena, background);
 }
 
-bool StoryScene::load(json::Schema &root) {
-  #define FAIL_HEADER "Could not parse story scene"
+SymbolID StoryScene::ensureMusic(const StringView &music) {
+  return musics.intern(arena, music);
+}
 
-  auto maybeActors = root.expectObjectField("actors"_sv);
-  FAIL_IF(!maybeActors.present(), "Could not find `actors`.");
-  FAIL_IF(!loadActors(*maybeActors), "Could not parse `actors`.");
+StringView StoryScene::storeText(const StringView &text) {
+  return arena.copy(text);
+}
 
-  auto maybeCommands = root.expectArrayField("commands"_sv);
-  FAIL_IF(!maybeCommands.present(), "Could not find `commands`.");
-  FAIL_IF(!loadCommands(*maybeCommands), "Could not parse `commands`.");
+void StoryScene::clear() {
+  clearActors();
+  clearCommands();
+  sprites.clear();
+  backgrounds.clear();
+  musics.clear();
+  arena.reset();
+}
 
-  return true;
+void StoryScene::clearCommands() {
+  commands = {};
+  spriteCommands.clear();
+  speakCommands.clear();
+  waitCommands.clear();
+  backgroundCommands.clear();
+}
 
-  #undef FAIL_HEADER
+Command StoryScene::addCommand(const SpriteCommand &command) {
+  spriteCommands.push(command);
+  return {CommandSprite, u32(spriteCommands.size() - 1)};
 }
 
-bool StoryScene::loadActors(json::Schema &data) {
-  #define FAIL_HEADER "Could not parse story scene actors"
+Command StoryScene::addCommand(const SpeakCommand &command) {
+  speakCommands.push(command);
+  return {CommandSpeak, u32(speakCommands.size() - 1)};
+}
+
+Command StoryScene::addCommand(const WaitCommand &command) {
+  waitCommands.push(command);
+  return {CommandWait, u32(waitCommands.size() - 1)};
+}
 
-  auto pairs = data.pairs();
-  if(pairs.size() == 0) {
-    return true;
+Command StoryScene::addCommand(const BackgroundCommand &command) {
+  backgroundCommands.push(command);
+  return {CommandBackground, u32(backgroundCommands.size() - 1)};
+}
+
+const SpriteCommand &StoryScene::sprite(Command command) const {
+  return spriteCommands[command.slot];
+}
+
+const SpeakCommand &StoryScene::speak(Command command) const {
+  return speakCommands[command.slot];
+}
+
+const WaitCommand &StoryScene::wait(Command command) const {
+  return waitCommands[command.slot];
+}
+
+const BackgroundCommand &StoryScene::background(Command command) const {
+  return backgroundCommands[command.slot];
+}
+
+template<typename T>
+static void reserve(Slice<T> &slice, usize count) {
+  slice = {count == 0 ? 1 : count};
+}
+
+// Whether `portrait` is a cell of the actor's sheet, or -1 for none.
+static bool portraitInSheet(const Actor &actor, s32 portrait) {
+  return portrait >= -1 && portrait < actor.sheetSize.x * actor.sheetSize.y;
+}
+
+bool StoryScene::load(const SceneBinary &binary) {
+  #define FAIL_HEADER "Could not parse compiled story scene"
+
+  auto binaryActors = binary.actors();
+  actors = {binaryActors.size()};
+  for(const auto &src: binaryActors) {
+    auto id = binary.string(src.id);
+    Actor actor;
+    actor.id = id;
+    actor.name = binary.string(src.name);
+    actor.sheet = binary.string(src.sheet);
+    actor.sheetSize = {src.sheetWidth, src.sheetHeight};
+    FAIL_IF(actor.sheetSize.x <= 0 || actor.sheetSize.y <= 0,
+      "Non-positive sheet size of actor {}.", id);
+    FAIL_IF(addActor(std::move(actor)) == cNoSymbol, "Duplicate actor {}.", id);
   }
-  actors = {pairs.size()};
-  for(const auto &[key, val]: pairs) {
-    FAIL_IF(!val.isObject(), "Expected object for actor {}.", key);
-    const auto &obj = val.object();
-    actors.push({});
-    auto &actor = actors[actors.size() - 1];
-    FAIL_IF(!actor.load(key, obj), "Could not parse actor object.");
+
+  auto binaryCommands = binary.commands();
+  std::array<usize, CommandMax> counts{};
+  for(const auto &src: binaryCommands) {
+    if(src.code < CommandMax) {
+      ++counts[src.code];
+    }
   }
+  reserve(spriteCommands, counts[CommandSprite]);
+  reserve(speakCommands, counts[CommandSpeak]);
+  reserve(waitCommands, counts[CommandWait]);
+  reserve(backgroundCommands, counts[CommandBackground]);
+
+  reserve(commands, binaryCommands.size());
+  for(usize i = 0; i < binaryCommands.size(); ++i) {
+    const auto &src = binaryCommands[i];
+    switch(src.code) {
+    case CommandSprite: {
+      SpriteCommand sprite;
+      sprite.id = ensureSprite(binary.string(src.strings[0]));
+      sprite.hide = (src.flags & cSceneBinaryHide) != 0;
+      sprite.actor = ensureActor(binary.string(src.strings[1]));
+      FAIL_IF(sprite.actor == cNoSymbol,
+        "Unknown actor in sprite command {}.", i);
+      sprite.portrait = src.portrait;
+      FAIL_IF(!portraitInSheet(*getActor(sprite.actor), sprite.portrait),
+        "Portrait outside the actor's sheet in sprite command {}.", i);
+      sprite.pos = {src.pos[0], src.pos[1]};
+      sprite.size = {src.size[0], src.size[1]};
+      sprite.time = src.time;
+      sprite.ease = Easing((src.flags & cSceneBinaryEaseMask) >> cSceneBinaryEaseShift);
+      FAIL_IF(sprite.ease >= EaseMax, "Unknown easing in sprite command {}.", i);
+      commands.push(addCommand(sprite));
+      break;
+    }
+    case CommandSpeak: {
+      SpeakCommand speak;
+      speak.actor = ensureActor(binary.string(src.strings[0]));
+      FAIL_IF(speak.actor == cNoSymbol,
+        "Unknown actor in speak command {}.", i);
+      speak.text = binary.string(src.strings[1]);
+      speak.portrait = src.portrait;
+      FAIL_IF(!portraitInSheet(*getActor(speak.actor), speak.portrait),
+        "Portrait outside the actor's sheet in speak command {}.", i);
+      speak.speed = src.time;
+      commands.push(addCommand(speak));
+      break;
+    }
+    case CommandWait: {
+      WaitCommand wait;
+      wait.duration = src.time;
+      commands.push(addCommand(wait));
+      break;
+    }
+    case CommandBackground: {
+      BackgroundCommand background;
+      if((src.flags & cSceneBinaryHasBackground) != 0) {
+        background.background = ensureBackground(binary.string(src.strings[0]));
+      }
+      if((src.flags & cSceneBinaryHasMusic) != 0) {
+        background.music = ensureMusic(binary.string(src.strings[1]));
+      }
+      background.time = src.time;
+      commands.push(addCommand(background));
+      break;
+    }
+    default:
+      FAIL("Invalid command {}.", i);
+    }
+  }
+
   return true;
 
   #undef FAIL_HEADER
 }
 
-bool Actor::load(const StringView &actorID, const json::Object &data) {
-  #define FAIL_HEADER "Could not parse story scene actor {}"
-
-  id = actorID;
-  const auto *nameVal = data.get("name"_sv);
-  FAIL_IF(nameVal == nullptr, "No `name` field.", actorID);
-  FAIL_IF(!nameVal->isString(), "Expected string for `name`.", actorID);
-  name = nameVal->string();
-
-  const auto *sheetVal = data.get("sheet"_sv);
-  FAIL_IF(sheetVal == nullptr, "No `sheet` field.", actorID);
-  FAIL_IF(!sheetVal->isString(), "Expected string for `sheet`.", actorID);
-  FAIL_IF(sheetVal->string().empty(),
-    "Expected non-empty string for `sheet`.", actorID);
-  sheet = sheetVal->string();
-
-  const auto *sheetSizeVal = data.get("sheetSize"_sv);
-  FAIL_IF(sheetSizeVal == nullptr, "No `sheetSize` field.", actorID);
-  FAIL_IF(!sheetSizeVal->isArray(), "Expected array for `sheetSize`.", actorID);
-  auto sizeArr = sheetSizeVal->array();
-  FAIL_IF(sizeArr.size() != 2, "Sprite array must be 2 elements.", actorID);
-  const auto &xVal = sizeArr[0];
-  FAIL_IF(!xVal.isNumber(), "Expected number for sprite array X.", actorID);
-  const auto &yVal = sizeArr[1];
-  FAIL_IF(!yVal.isNumber(), "Expected number for sprite array Y.", actorID);
-  auto width = s32(xVal.number());
-  auto height = s32(yVal.number());
-  sheetSize = {width, height};
+bool StoryScene::loadActors(JSONReader &reader) {
+  #define FAIL_HEADER "Could not parse story scene actors"
 
+  FAIL_IF(!reader.beginObject(), "{}", reader.error());
+  StringView key;
+  while(reader.nextKey(key)) {
+    FAIL_IF(actorIDs.find(key) != cNoSymbol, "Duplicate actor {}.", key);
+    Actor actor;
+    actor.id = arena.copy(key);
+    FAIL_IF(!actor.load(arena, reader), "Could not parse actor object.");
+    insertActor(std::move(actor));
+  }
+  FAIL_IF(reader.failed(), "{}", reader.error());
   return true;
 
   #undef FAIL_HEADER
 }
 
-bool StoryScene::loadCommands(json::Schema data) {
-  #define FAIL_HEADER "Could not parse story scene commands"
+bool Actor::load(Arena &arena, JSONReader &reader) {
+  #define FAIL_HEADER "Could not parse story scene actor {}"
 
-  commands = {data.array().size()};
-  for(usize i = 0; i < commands.size(); ++i) {
-    auto maybeCommand = data.expectObjectElement();
-    FAIL_IF(!maybeCommand.present(), "Could not find command {}.", i);
-    auto &cmd = commands[i];
-
-    auto maybeSprite = maybeCommand->expectObjectField("sprite"_sv);
-    if(maybeSprite.present()) {
-      cmd.code = CommandSprite;
-      cmd.sprite.emplace();
-      FAIL_IF(!cmd.sprite->load(*this, *maybeSprite),
-        "Could not parse sprite command {}.", i);
-      continue;
+  FAIL_IF(!reader.beginObject(), "{}", id, reader.error());
+  bool hasName = false;
+  bool hasSheetSize = false;
+  StringView key;
+  while(reader.nextKey(key)) {
+    if(key.equals("name"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", id, reader.error());
+      name = arena.copy(value);
+      hasName = true;
+    } else if(key.equals("sheet"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", id, reader.error());
+      FAIL_IF(value.empty(), "Expected non-empty string for `sheet`.", id);
+      sheet = arena.copy(value);
+    } else if(key.equals("sheetSize"_sv)) {
+      glm::vec2 size;
+      FAIL_IF(!reader.readVec2(size), "{}", id, reader.error());
+      sheetSize = glm::ivec2(size);
+      FAIL_IF(sheetSize.x <= 0 || sheetSize.y <= 0,
+        "Expected positive `sheetSize`.", id);
+      hasSheetSize = true;
+    } else {
+      FAIL_IF(!reader.skip(), "{}", id, reader.error());
     }
+  }
+  FAIL_IF(reader.failed(), "{}", id, reader.error());
+  FAIL_IF(!hasName, "No `name` field.", id);
+  FAIL_IF(sheet.empty(), "No `sheet` field.", id);
+  FAIL_IF(!hasSheetSize, "No `sheetSize` field.", id);
 
-    auto maybeBackground = maybeCommand->expectObjectField("background"_sv);
-    if(maybeBackground.present()) {
-      cmd.code = CommandBackground;
-      cmd.background.emplace();
-      FAIL_IF(!cmd.background->load(*this, *maybeBackground),
-        "Could not parse background command {}.", i);
-      continue;
-    }
+  return true;
 
-    auto maybeSpeak = maybeCommand->expectObjectField("speak"_sv);
-    if(maybeSpeak.present()) {
-      cmd.code = CommandSpeak;
-      cmd.speak.emplace();
-      FAIL_IF(!cmd.speak->load(*this, *maybeSpeak),
-        "Could not parse speak command {}.", i);
-      continue;
-    }
+  #undef FAIL_HEADER
+}
 
-    auto maybeWait = maybeCommand->expectObjectField("wait"_sv);
-    if(maybeWait.present()) {
-      cmd.code = CommandWait;
-      cmd.wait.emplace();
-      FAIL_IF(!cmd.wait->load(*maybeWait),
-        "Could not parse wait command {}.", i);
-      continue;
-    }
+bool StoryScene::loadCommands(JSONReader &reader) {
+  #define FAIL_HEADER "Could not parse story scene commands"
 
-    FAIL("Invalid command {}.", i);
-    return false;
+  FAIL_IF(!reader.beginArray(), "{}", reader.error());
+  for(usize i = 0; reader.nextElement(); ++i) {
+    FAIL_IF(!reader.beginObject(), "Could not find command {}.", i);
+    StringView key;
+    FAIL_IF(!reader.nextKey(key), "Invalid command {}.", i);
+
+    const auto *type = findCommandType(key);
+    FAIL_IF(type == nullptr, "Invalid command {}.", i);
+    FAIL_IF(reader.peek() != JSONReader::ValueObject,
+      "Expected object for {} command {}.", type->name, i);
+
+    Command command;
+    FAIL_IF(!type->load(*this, command, reader),
+      "Could not parse {} command {}.", type->name, i);
+    FAIL_IF(reader.nextKey(key), "Invalid command {}.", i);
+    FAIL_IF(reader.failed(), "{}", reader.error());
+    commands.push(command);
   }
+  FAIL_IF(reader.failed(), "{}", reader.error());
 
   return true;
 
   #undef FAIL_HEADER
 }
 
-bool SpriteCommand::load(StoryScene &scene, json::Schema &data) {
-  #define FAIL_HEADER "Could not parse story scene sprite command"
-
-  auto maybeId = data.expectStringField("id"_sv);
-  FAIL_IF(!maybeId.present(), "Could not find id for sprite command.");
-  id = scene.ensureSprite(*maybeId);
-
-  auto maybeHide = data.expectBooleanField("hide"_sv);
-  if(maybeHide.present()) {
-    hide = *maybeHide;
+/*
+Portraits are given as [x, y] cells of the actor's sheet. The fields of a
+command can come in any order, so this is only done once the whole command has
+been read.
+*/
+static bool portraitIndex(const Actor &actor, glm::vec2 cell, s32 &index) {
+  if(cell.x < 0 || cell.y < 0) {
+    return false;
   }
-
-  auto maybeActor = data.expectStringField("actor"_sv);
-  FAIL_IF(!maybeActor.present(), "Need actor for sprite command.");
-  actor = scene.ensureActor(*maybeActor);
-  FAIL_IF(actor.empty(), "Could not find actor {}.", *maybeActor);
-  const auto *actorData = scene.getActor(actor);
-
-  auto maybePortrait = data.expectArrayField("portrait"_sv);
-  if(maybePortrait.present()) {
-    FAIL_IF(!maybeActor.present(), "Need actor for portrait.");
-    auto maybeX = maybePortrait->expectNumberElement();
-    FAIL_IF(!maybeX.present(), "Could not find x for portrait.");
-    auto maybeY = maybePortrait->expectNumberElement();
-    FAIL_IF(!maybeY.present(), "Could not find y for portrait.");
-    auto portraitX = s32(*maybeX);
-    auto portraitY = s32(*maybeY);
-    portrait = portraitY * actorData->sheetSize.x + portraitX;
+  glm::ivec2 at{cell};
+  if(at.x >= actor.sheetSize.x || at.y >= actor.sheetSize.y) {
+    return false;
   }
+  index = at.y * actor.sheetSize.x + at.x;
+  return true;
+}
 
-  auto maybePos = data.expectArrayField("pos"_sv);
-  if(!maybePos.present()) {
-    auto maybeX = maybePos->expectNumberElement();
-    FAIL_IF(!maybeX.present(), "Could not find x for pos.");
-    auto maybeY = maybePos->expectNumberElement();
-    FAIL_IF(!maybeY.present(), "Could not find y for pos.");
-    pos = {f32(*maybeX), f32(*maybeY)};
-  }
+bool SpriteCommand::load(StoryScene &scene, JSONReader &reader) {
+  #define FAIL_HEADER "Could not parse story scene sprite command"
 
-  auto maybeSize = data.expectArrayField("size"_sv);
-  if(maybeSize.present()) {
-    auto maybeX = maybeSize->expectNumberElement();
-    FAIL_IF(!maybeX.present(), "Could not find x for size.");
-    auto maybeY = maybeSize->expectNumberElement();
-    FAIL_IF(!maybeY.present(), "Could not find y for size.");
-    size = {f32(*maybeX), f32(*maybeY)};
+  FAIL_IF(!reader.beginObject(), "{}", reader.error());
+  bool hasId = false;
+  bool hasPortrait = false;
+  glm::vec2 portraitCell;
+  StringView key;
+  while(reader.nextKey(key)) {
+    if(key.equals("id"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      id = scene.ensureSprite(value);
+      hasId = true;
+    } else if(key.equals("hide"_sv)) {
+      FAIL_IF(!reader.readBoolean(hide), "{}", reader.error());
+    } else if(key.equals("actor"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      actor = scene.ensureActor(value);
+      FAIL_IF(actor == cNoSymbol, "Could not find actor {}.", value);
+    } else if(key.equals("portrait"_sv)) {
+      FAIL_IF(!reader.readVec2(portraitCell), "{}", reader.error());
+      hasPortrait = true;
+    } else if(key.equals("pos"_sv)) {
+      FAIL_IF(!reader.readVec2(pos), "{}", reader.error());
+    } else if(key.equals("size"_sv)) {
+      FAIL_IF(!reader.readVec2(size), "{}", reader.error());
+    } else if(key.equals("time"_sv)) {
+      f64 value = 0;
+      FAIL_IF(!reader.readNumber(value), "{}", reader.error());
+      FAIL_IF(value < 0, "Time of sprite command must not be negative.");
+      time = f32(value);
+    } else if(key.equals("ease"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      FAIL_IF(!easingFromName(value, ease), "Unknown easing {}.", value);
+    } else {
+      FAIL_IF(!reader.skip(), "{}", reader.error());
+    }
   }
+  FAIL_IF(reader.failed(), "{}", reader.error());
+  FAIL_IF(!hasId, "Could not find id for sprite command.");
+  FAIL_IF(actor == cNoSymbol, "Need actor for sprite command.");
+  FAIL_IF(hasPortrait && !portraitIndex(*scene.getActor(actor), portraitCell, portrait),
+    "Portrait [{}, {}] is outside the actor's sheet.", portraitCell.x, portraitCell.y);
 
   return true;
 
   #undef FAIL_HEADER
 }
 
-bool SpeakCommand::load(struct StoryScene &scene, json::Schema &data) {
+bool SpeakCommand::load(struct StoryScene &scene, JSONReader &reader) {
   #define FAIL_HEADER "Could not parse story scene speak command"
 
-  auto maybeActor = data.expectStringField("actor"_sv);
-  FAIL_IF(!maybeActor.present(), "Could not find actor for speak command.");
-  actor = scene.ensureActor(*maybeActor);
-  FAIL_IF(actor.empty(), "Could not find actor {}.", *maybeActor);
-  const auto *actorData = scene.getActor(actor);
-
-  auto maybeText = data.expectStringField("text"_sv);
-  if(maybeText.present()) {
-    text = *maybeText;
-  }
-
-  auto maybePortrait = data.expectArrayField("portrait"_sv);
-  if(maybePortrait.present()) {
-    auto maybeX = maybePortrait->expectNumberElement();
-    FAIL_IF(!maybeX.present(), "Could not find x for portrait.");
-    auto maybeY = maybePortrait->expectNumberElement();
-    FAIL_IF(!maybeY.present(), "Could not find y for portrait.");
-    auto portraitX = s32(*maybeX);
-    auto portraitY = s32(*maybeY);
-    portrait = portraitY * actorData->sheetSize.x + portraitX;
+  FAIL_IF(!reader.beginObject(), "{}", reader.error());
+  bool hasPortrait = false;
+  glm::vec2 portraitCell;
+  StringView key;
+  while(reader.nextKey(key)) {
+    if(key.equals("actor"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      actor = scene.ensureActor(value);
+      FAIL_IF(actor == cNoSymbol, "Could not find actor {}.", value);
+    } else if(key.equals("text"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      text = scene.storeText(value);
+    } else if(key.equals("portrait"_sv)) {
+      FAIL_IF(!reader.readVec2(portraitCell), "{}", reader.error());
+      hasPortrait = true;
+    } else if(key.equals("speed"_sv)) {
+      f64 value = 0;
+      FAIL_IF(!reader.readNumber(value), "{}", reader.error());
+      FAIL_IF(value < 0, "Speed of speak command must not be negative.");
+      speed = f32(value);
+    } else {
+      FAIL_IF(!reader.skip(), "{}", reader.error());
+    }
   }
+  FAIL_IF(reader.failed(), "{}", reader.error());
+  FAIL_IF(actor == cNoSymbol, "Could not find actor for speak command.");
+  FAIL_IF(hasPortrait && !portraitIndex(*scene.getActor(actor), portraitCell, portrait),
+    "Portrait [{}, {}] is outside the actor's sheet.", portraitCell.x, portraitCell.y);
 
   return true;
 
   #undef FAIL_HEADER
 }
 
-bool WaitCommand::load(json::Schema &data) {
+bool WaitCommand::load(JSONReader &reader) {
   #define FAIL_HEADER "Could not parse story scene wait command"
 
-  auto maybeTime = data.expectNumberField("time"_sv);
-  FAIL_IF(!maybeTime.present(), "Could not find time for wait command.");
-  duration = f32(*maybeTime);
+  FAIL_IF(!reader.beginObject(), "{}", reader.error());
+  bool hasTime = false;
+  StringView key;
+  while(reader.nextKey(key)) {
+    if(key.equals("time"_sv)) {
+      f64 time = 0;
+      FAIL_IF(!reader.readNumber(time), "{}", reader.error());
+      duration = f32(time);
+      hasTime = true;
+    } else {
+      FAIL_IF(!reader.skip(), "{}", reader.error());
+    }
+  }
+  FAIL_IF(reader.failed(), "{}", reader.error());
+  FAIL_IF(!hasTime, "Could not find time for wait command.");
 
   return true;
 
   #undef FAIL_HEADER
 }
 
-bool BackgroundCommand::load(StoryScene &scene, json::Schema &data) {
+bool BackgroundCommand::load(StoryScene &scene, JSONReader &reader) {
   #define FAIL_HEADER "Could not parse story scene background command"
 
-  auto maybeBackground = data.expectStringField("background"_sv);
-  if(maybeBackground.present()) {
-    background = scene.ensureBackground(*maybeBackground);
-  }
-
-  auto maybeMusic = data.expectStringField("music"_sv);
-  if(maybeMusic.present()) {
-    music = scene.ensureMusic(*maybeMusic);
+  FAIL_IF(!reader.beginObject(), "{}", reader.error());
+  StringView key;
+  while(reader.nextKey(key)) {
+    if(key.equals("background"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      background = scene.ensureBackground(value);
+    } else if(key.equals("music"_sv)) {
+      StringView value;
+      FAIL_IF(!reader.readString(value), "{}", reader.error());
+      music = scene.ensureMusic(value);
+    } else if(key.equals("time"_sv)) {
+      f64 value = 0;
+      FAIL_IF(!reader.readNumber(value), "{}", reader.error());
+      FAIL_IF(value < 0, "Time of background command must not be negative.");
+      time = f32(value);
+    } else {
+      FAIL_IF(!reader.skip(), "{}", reader.error());
+    }
   }
+  FAIL_IF(reader.failed(), "{}", reader.error());
 
   return true;
 
   #undef FAIL_HEADER
 }
 
-json::Object StoryScene::toObject() const {
-  Slice<json::Object::Pair> pairs{4};
-  pairs.push({"actors"_sv, actorsObject()});
-  pairs.push({"commands"_sv, commandsArray()});
-  return json::Object{pairs.view()};
-}
-
-json::Object StoryScene::actorsObject() const {
-  if(actors.size() == 0) {
-    return {};
+void StoryScene::save(JSONWriter &writer) const {
+  writer.key("actors"_sv);
+  writer.beginObject();
+  for(const auto &actor: actors) {
+    actor.save(writer);
   }
-  Slice<json::Object::Pair> pairs{actors.size()};
-  for(const auto & actor: actors) {
-    pairs.push({actor.id.view(), actor.toObject()});
+  writer.endObject();
+
+  writer.key("commands"_sv);
+  writer.beginArray();
+  for(const auto &command: commands) {
+    command.save(*this, writer);
   }
-  return json::Object{pairs.view()};
+  writer.endArray();
 }
 
-json::Object Actor::toObject() const {
-  Slice<json::Object::Pair> pairs{4};
-  pairs.push({"name"_sv, name.view()});
-  pairs.push({"sheet"_sv, sheet.view()});
-  std::array sheetSizeArray{
-    json::Value{f64(sheetSize.x)},
-    json::Value{f64(sheetSize.y)},
-  };
-  pairs.push({"sheetSize"_sv, ArrayView(sheetSizeArray.data(), 2)});
-  return json::Object{pairs.view()};
+void Actor::save(JSONWriter &writer) const {
+  writer.key(id);
+  writer.beginObject();
+  writer.key("name"_sv);
+  writer.string(name);
+  writer.key("sheet"_sv);
+  writer.string(sheet);
+  writer.key("sheetSize"_sv);
+  writer.ivec2(sheetSize);
+  writer.endObject();
 }
 
-ArrayView<json::Value> StoryScene::commandsArray() const {
-  if(commands.empty()) {
-    return {};
-  }
-  Slice<json::Value> values{commands.size()};
-  for(const auto &command: commands) {
-    values.push(command.toObject(*this));
-  }
-  return values.view();
-}
-
-json::Object Command::toObject(const StoryScene &scene) const {
-  Slice<json::Object::Pair> pairs{1};
-  switch(code) {
-  case CommandSpeak:
-    pairs.push({"speak"_sv, speak->toObject(scene)});
-    break;
-  case CommandSprite:
-    pairs.push({"sprite"_sv, sprite->toObject(scene)});
-    break;
-  case CommandWait:
-    pairs.push({"wait"_sv, wait->toObject()});
-    break;
-  case CommandBackground:
-    pairs.push({"background"_sv, background->toObject()});
-    break;
-  default:
-    NWGE_UNREACHABLE("invalid CommandCode");
-  }
-  return json::Object{pairs.view()};
+void Command::save(const StoryScene &scene, JSONWriter &writer) const {
+  const auto &type = commandType(code);
+  writer.beginObject();
+  writer.key(type.name);
+  writer.beginObject();
+  type.save(scene, *this, writer);
+  writer.endObject();
+  writer.endObject();
+}
+
+static glm::ivec2 portraitCell(const Actor &actor, s32 portrait) {
+  return {portrait % actor.sheetSize.x, portrait / actor.sheetSize.x};
 }
 
-json::Object SpriteCommand::toObject(const StoryScene &scene) const {
-  json::ObjectBuilder builder;
-  builder.set("sprite"_sv, id);
-  if(!actor.empty()) {
-    builder.set("actor"_sv, actor);
+void SpriteCommand::save(const StoryScene &scene, JSONWriter &writer) const {
+  writer.key("id"_sv);
+  writer.string(scene.sprites.name(id));
+  const auto *actorData = scene.getActor(actor);
+  if(actorData != nullptr) {
+    writer.key("actor"_sv);
+    writer.string(actorData->id);
     if(portrait >= 0) {
-      const auto *actorData = scene.getActor(actor);
-      auto portraitX = portrait % actorData->sheetSize.x;
-      auto portraitY = portrait / actorData->sheetSize.x;
-      builder.array("portrait"_sv)
-        .add(f64(portraitX))
-        .add(f64(portraitY))
-        .end();
+      writer.key("portrait"_sv);
+      writer.ivec2(portraitCell(*actorData, portrait));
     }
   }
-  builder.set("hide"_sv, hide);
+  writer.key("hide"_sv);
+  writer.boolean(hide);
   if(pos.x != -1 && pos.y != -1) {
-    builder.array("pos"_sv)
-      .add(f64(pos.x))
-      .add(f64(pos.y))
-      .end();
+    writer.key("pos"_sv);
+    writer.vec2(pos);
   }
   if(size.x != -1 && size.y != -1) {
-    builder.array("size"_sv)
-      .add(f64(size.x))
-      .add(f64(size.y))
-      .end();
+    writer.key("size"_sv);
+    writer.vec2(size);
+  }
+  if(time > 0) {
+    writer.key("time"_sv);
+    writer.number(time);
+  }
+  if(ease != EaseLinear) {
+    writer.key("ease"_sv);
+    writer.string(easingName(ease));
   }
-  return builder.finish();
 }
 
-json::Object SpeakCommand::toObject(const StoryScene &scene) const {
-  json::ObjectBuilder builder;
-
-  builder.set("actor"_sv, actor);
-  if(portrait >= 0) {
-    const auto *actorData = scene.getActor(actor);
-    auto portraitX = portrait % actorData->sheetSize.x;
-    auto portraitY = portrait / actorData->sheetSize.x;
-    builder.array("portrait"_sv)
-      .add(f64(portraitX))
-      .add(f64(portraitY))
-      .end();
+void SpeakCommand::save(const StoryScene &scene, JSONWriter &writer) const {
+  const auto *actorData = scene.getActor(actor);
+  if(actorData != nullptr) {
+    writer.key("actor"_sv);
+    writer.string(actorData->id);
+  }
+  if(actorData != nullptr && portrait >= 0) {
+    writer.key("portrait"_sv);
+    writer.ivec2(portraitCell(*actorData, portrait));
+  }
+  writer.key("text"_sv);
+  writer.string(text);
+  if(speed > 0) {
+    writer.key("speed"_sv);
+    writer.number(speed);
   }
-  builder.set("text"_sv, text.view());
-  return builder.finish();
 }
 
-json::Object WaitCommand::toObject() const {
-  json::ObjectBuilder builder;
-  builder.set("time"_sv, duration);
-  return builder.finish();
+void WaitCommand::save(JSONWriter &writer) const {
+  writer.key("time"_sv);
+  writer.number(duration);
 }
 
-json::Object BackgroundCommand::toObject() const {
-  json::ObjectBuilder builder;
-  if(!background.empty()) {
-    builder.set("background"_sv, background);
+void BackgroundCommand::save(const StoryScene &scene, JSONWriter &writer) const {
+  if(background != cNoSymbol) {
+    writer.key("background"_sv);
+    writer.string(scene.backgrounds.name(background));
+  }
+  if(music != cNoSymbol) {
+    writer.key("music"_sv);
+    writer.string(scene.musics.name(music));
   }
-  if(!music.empty()) {
-    builder.set("music"_sv, music);
+  if(time > 0) {
+    writer.key("time"_sv);
+    writer.number(time);
   }
-  return builder.finish();
 }
 
 } // namespace sigmoid
@@ -6,12 +6,16 @@ StoryScene.hpp
 A scene with a story.
 */
 
+#include "Arena.hpp"
+#include "JSONReader.hpp"
+#include "JSONWriter.hpp"
+#include "SceneBinary.hpp"
+#include "SymbolTable.hpp"
+#include "Tween.hpp"
 #include <nwge/common/array.hpp>
 #include <nwge/common/maybe.hpp>
 #include <nwge/common/slice.hpp>
 #include <nwge/common/string.hpp>
-#include <nwge/json.hpp>
-#include <nwge/json/Schema.hpp>
 #include <nwge/render/Texture.hpp>
 #include <nwge/render/Vertex.hpp>
 
@@ -28,14 +32,16 @@ namespace sigmoid {
  * sprites.
  */
 struct Actor {
-  nwge::String<> id;
-  nwge::String<> name;
-  nwge::String<> sheet;
+  nwge::StringView id;
+  nwge::StringView name;
+  nwge::StringView sheet;
   glm::ivec2 sheetSize;
 
-  bool load(const nwge::StringView &actorID, const nwge::json::Object &data);
-  [[nodiscard]]
-  nwge::json::Object toObject() const;
+  // Reads the actor's object, copying its strings into the arena. `id` must
+  // already be set.
+  bool load(Arena &arena, JSONReader &reader);
+  // Writes the actor's key & object into the `actors` object.
+  void save(JSONWriter &writer) const;
 };
 
 enum CommandCode {
@@ -59,86 +65,126 @@ static constexpr std::array cCommandCodeNames = {
  *
  * While the sprite command uses a string as an ID in the scene file, we use
  * numbers as indices for speed & compactness. We can precalculate how many
- * unique sprites there are and use that to generate the indices. The `actor`
- * field is an index into the `StoryScene::mActors` array.
+ * unique sprites there are and use that to generate the indices. The `id`
+ * field is an ID from `StoryScene::sprites`, the `actor` field is an index into
+ * the `StoryScene::actors` array.
  */
 struct SpriteCommand {
-  nwge::StringView id;
+  SymbolID id = cNoSymbol;
   bool hide = false;
-  nwge::StringView actor;
+  SymbolID actor = cNoSymbol;
   s32 portrait = -1;
   glm::vec2 pos{-1, -1};
   glm::vec2 size{-1, -1};
+  f32 time = 0.0f; // -> seconds to move, scale & fade over, 0 to snap
+  Easing ease = EaseLinear;
 
-  bool load(struct StoryScene &scene, nwge::json::Schema &data);
-  [[nodiscard]]
-  nwge::json::Object toObject(const StoryScene &scene) const;
+  bool load(struct StoryScene &scene, JSONReader &reader);
+  void save(const StoryScene &scene, JSONWriter &writer) const;
 };
 
 struct SpeakCommand {
-  nwge::String<> text;
-  nwge::StringView actor;
+  nwge::StringView text;
+  SymbolID actor = cNoSymbol;
   s32 portrait = -1;
+  f32 speed = 0.0f; // -> glyphs revealed per second, 0 for the default
 
-  bool load(struct StoryScene &scene, nwge::json::Schema &data);
-  [[nodiscard]]
-  nwge::json::Object toObject(const StoryScene &scene) const;
+  bool load(struct StoryScene &scene, JSONReader &reader);
+  void save(const StoryScene &scene, JSONWriter &writer) const;
 };
 
 struct WaitCommand {
   float duration = 0.0f;
 
-  bool load(nwge::json::Schema &data);
-  [[nodiscard]]
-  nwge::json::Object toObject() const;
+  bool load(JSONReader &reader);
+  void save(JSONWriter &writer) const;
 };
 
+// `cNoSymbol` means the background or music is left unchanged.
 struct BackgroundCommand {
-  nwge::StringView background;
-  nwge::StringView music;
+  SymbolID background = cNoSymbol;
+  SymbolID music = cNoSymbol;
+  f32 time = 0.0f; // -> seconds to cross-fade backgrounds over
 
-  bool load(struct StoryScene &scene, nwge::json::Schema &data);
-  [[nodiscard]]
-  nwge::json::Object toObject() const;
+  bool load(struct StoryScene &scene, JSONReader &reader);
+  void save(const StoryScene &scene, JSONWriter &writer) const;
 };
 
+/**
+ * @brief Entry in a story scene's command stream.
+ *
+ * The command's data lives in the scene's array for its type, at index `slot`.
+ * This keeps the stream itself at 8 bytes per command, and every command only
+ * pays for the data of its own type.
+ */
 struct Command {
   CommandCode code = CommandInvalid;
-  nwge::Maybe<SpriteCommand> sprite;
-  nwge::Maybe<SpeakCommand> speak;
-  nwge::Maybe<WaitCommand> wait;
-  nwge::Maybe<BackgroundCommand> background;
+  u32 slot = 0;
 
-  [[nodiscard]]
-  nwge::json::Object toObject(const StoryScene &scene) const;
+  void save(const StoryScene &scene, JSONWriter &writer) const;
 };
+static_assert(sizeof(Command) == 8);
 
 struct StoryScene {
+  // Holds all strings of the scene which don't point into a compiled scene.
+  Arena arena;
+  // Actors are indexed by their ID from `actorIDs`.
   nwge::Slice<Actor> actors{4};
-  nwge::Slice<nwge::String<>> sprites{4};
-  nwge::Slice<nwge::String<>> backgrounds{4};
-  nwge::Slice<nwge::String<>> musics{4};
-  nwge::Array<Command> commands;
-
-  bool load(nwge::json::Schema &root);
+  SymbolTable actorIDs;
+  SymbolTable sprites;
+  SymbolTable backgrounds;
+  SymbolTable musics;
+  nwge::Slice<Command> commands{4};
+  nwge::Slice<SpriteCommand> spriteCommands{4};
+  nwge::Slice<SpeakCommand> speakCommands{4};
+  nwge::Slice<WaitCommand> waitCommands{4};
+  nwge::Slice<BackgroundCommand> backgroundCommands{4};
+
+  // Read the `actors` & `commands` fields of a scene file. Actors must be
+  // loaded before the commands referring to them.
+  bool loadActors(JSONReader &reader);
+  bool loadCommands(JSONReader &reader);
+  bool load(const SceneBinary &binary);
+  // Writes the `actors` & `commands` fields of a scene file.
+  void save(JSONWriter &writer) const;
+
+  SymbolID ensureSprite(const nwge::StringView &sprite);
+  // Returns `cNoSymbol` for actors which were not defined.
   [[nodiscard]]
-  nwge::json::Object toObject() const;
-
-  nwge::StringView ensureSprite(const nwge::StringView &sprite);
-  nwge::StringView ensureActor(const nwge::StringView &actor);
-  Actor *getActor(const nwge::StringView &actor);
+  SymbolID ensureActor(const nwge::StringView &actor) const;
+  // Adds an actor, copying its strings into the arena. Returns `cNoSymbol` if
+  // its ID is already in use.
+  SymbolID addActor(Actor &&actor);
+  void clearActors();
+  Actor *getActor(SymbolID actor);
   [[nodiscard]]
-  const Actor *getActor(const nwge::StringView &actor) const;
-  nwge::StringView ensureBackground(const nwge::StringView &background);
-  nwge::StringView ensureMusic(const nwge::StringView &music);
-
-private:
-  bool loadActors(nwge::json::Schema &data);
+  const Actor *getActor(SymbolID actor) const;
+  SymbolID ensureBackground(const nwge::StringView &background);
+  SymbolID ensureMusic(const nwge::StringView &music);
+  // Copies text not backed by a compiled scene into the scene.
+  nwge::StringView storeText(const nwge::StringView &text);
+  // Drops everything & frees the arena in one go.
+  void clear();
+
+  // Drops all commands, but not the names they refer to.
+  void clearCommands();
+  // Stores the command's data & returns the stream entry referring to it.
+  Command addCommand(const SpriteCommand &command);
+  Command addCommand(const SpeakCommand &command);
+  Command addCommand(const WaitCommand &command);
+  Command addCommand(const BackgroundCommand &command);
   [[nodiscard]]
-  nwge::json::Object actorsObject() const;
-  bool loadCommands(nwge::json::Schema data);
+  const SpriteCommand &sprite(Command command) const;
   [[nodiscard]]
-  nwge::ArrayView<nwge::json::Value> commandsArray() const;
+  const SpeakCommand &speak(Command command) const;
+  [[nodiscard]]
+  const WaitCommand &wait(Command command) const;
+  [[nodiscard]]
+  const BackgroundCommand &background(Command command) const;
+
+private:
+  // Adds an actor whose strings are already owned by the scene.
+  SymbolID insertActor(Actor &&actor);
 };
 
 } // namespace sigmoid
\ No newline at end of file
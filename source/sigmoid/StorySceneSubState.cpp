@@ -1,10 +1,20 @@
+#include "CachedElement.hpp"
+#include "Debug.hpp"
+#include "DrawList.hpp"
+#include "Prefetcher.hpp"
+#include "Redraw.hpp"
+#include "RenderTarget.hpp"
+#include "SpriteLayer.hpp"
 #include "StoryScene.hpp"
+#include "TextPage.hpp"
+#include "TextRun.hpp"
 #include "states.hpp"
 #include <nwge/bind.hpp>
 #include <nwge/common/maybe.hpp>
 #include <nwge/render/AspectRatio.hpp>
 #include <nwge/render/draw.hpp>
 #include <nwge/render/window.hpp>
+#include <algorithm>
 
 using namespace nwge;
 
@@ -19,47 +29,62 @@ class StorySceneSubState final: public SubState {
   */
   StorySceneSubState(SceneStateData &data)
     : mData(data),
-      mActors(mStory.actors.size())
+      mActors(mStory.actors.size()),
+      mSprites(mStory.sprites.size())
   {
     initActors();
 
     const auto &background = mData.scene.background;
     if(!background.empty()) {
-      showBackground(background);
+      // interned by the scene chain
+      mBackground = mPrefetcher.background(mStory.backgrounds.find(background));
     }
+    mPrefetcher.advance(0);
   }
 
-  bool tick(f32 delta) override {
-    if(!mCurrentText.empty()) {
-      if(mTextChars < mCurrentText.size()) {
-        mTextTimer += delta;
-        if(mTextTimer >= cTextCharTime) {
-          mTextChars++;
-          mTextTimer = 0.0f;
-        }
-        return true;
-      }
+  bool on(Event &evt) override {
+    switch(evt.type) {
+    case Event::PostLoad:
+      mData.chain.loaded();
+      break;
+    default:
+      break;
     }
-    if(!mWaitForInput) {
-      nextCommand();
-      return true;
+    return true;
+  }
+
+  bool tick(f32 delta) override {
+    resources().update();
+    // the last step of a tween still has to be drawn
+    if(mSprites.animating() || !mFades.empty()) {
+      redraw().invalidate();
     }
+    mSprites.update(delta);
+    fade(delta);
+    advance(delta);
+    // besides tweens, a line being revealed is the only thing moving by itself
+    redraw().idle();
     return true;
   }
 
   void render() const override {
+    redraw().frame();
+    ScaledFrame frame;
     render::clear({0, 0, 0});
-    if(mShowBackground) {
-      m4x3.rect({
-        {0, 0, 0.9},
-        {1, 1},
-        mBackground.id
-      }).draw();
+    auto &list = drawList();
+    // a background that's still uploading has no ID yet & stays black
+    bool shown = drawBackground(list, mBackground, cBackgroundZ, mBackgroundFade);
+    if(mBackgroundFade < 1) {
+      // fade the old background out if there's nothing to fade over it
+      drawBackground(list, mPrevBackground, cPrevBackgroundZ,
+        shown ? 1 : 1 - mBackgroundFade);
     }
+    mSprites.draw(list, m4x3);
 
-    if(mCurrentActor != nullptr && !mCurrentText.empty()) {
-      renderTextBox();
+    if(mCurrentActor != nullptr && !mCurrentText.text().empty()) {
+      renderTextBox(list);
     }
+    list.flush();
   }
 
 private:
@@ -69,35 +94,73 @@ class StorySceneSubState final: public SubState {
   render::AspectRatio m1x1{1, 1};
   render::AspectRatio m4x3{4, 3};
 
-  bool mShowBackground = false;
-  render::Texture mBackground;
+  Prefetcher &mPrefetcher = mData.chain.prefetcher();
+  SharedImage mBackground;
+  // cross-fades show the new background over the previous one
+  SharedImage mPrevBackground;
+  f32 mBackgroundFade = 1.0f;
+  Tweens mFades;
+  static constexpr f32 cBackgroundZ = 0.89f;
+  static constexpr f32 cPrevBackgroundZ = 0.9f;
 
-  void removeBackground() {
-    mShowBackground = false;
+  // Returns whether the background was drawn.
+  bool drawBackground(DrawList &list, const SharedImage &image, f32 z, f32 alpha) const {
+    u32 id = image.present() ? image.use().id() : 0;
+    if(id == 0 || alpha <= 0) {
+      return id != 0;
+    }
+    // premultiplied images are faded by scaling their colors too
+    bool premultiplied = image->premultiplied();
+    list.color(premultiplied ? glm::vec4{alpha, alpha, alpha, alpha} : glm::vec4{1, 1, 1, alpha});
+    list.image(m4x3.rect({{0, 0, z}, {1, 1}, id}), premultiplied);
+    list.color();
+    return true;
   }
 
-  void showBackground(const StringView &name) {
-    mShowBackground = true;
-    mData.game.bundle.nqTexture(name, mBackground);
+  void fade(f32 delta) {
+    if(mFades.empty()) {
+      return;
+    }
+    mFades.update(delta, {&mBackgroundFade, 1});
+    if(mFades.empty()) {
+      mPrevBackground = {};
+    }
   }
 
   void backgroundCmd(const BackgroundCommand &cmd) {
-    if(cmd.background.empty()) {
-      removeBackground();
-    } else {
-      showBackground(cmd.background);
+    if(cmd.background != cNoSymbol) {
+      mFades.clear();
+      mBackgroundFade = 1.0f;
+      mPrevBackground = {};
+      if(cmd.time > 0 && mBackground.present()) {
+        mPrevBackground = std::move(mBackground);
+        mBackgroundFade = 0.0f;
+        mFades.add(0, 0.0f, 1.0f, cmd.time, EaseLinear);
+      }
+      if(mStory.backgrounds.name(cmd.background).empty()) {
+        mBackground = {};
+      } else {
+        mBackground = mPrefetcher.background(cmd.background);
+      }
     }
-    if(cmd.music.empty()) {
-      console::warn("Music not yet implemented. (stopMusic)");
-    } else {
-      console::warn("Music not yet implemented. (setMusic)");
+    if(cmd.music != cNoSymbol) {
+      if(mStory.musics.name(cmd.music).empty()) {
+        console::warn("Music not yet implemented. (stopMusic)");
+      } else {
+        mPrefetcher.music(cmd.music);
+        console::warn("Music not yet implemented. (setMusic)");
+      }
     }
   }
 
+  /*
+  Sheets are owned by the prefetcher and looked up when an actor speaks. For
+  sheets in the atlas that's the page, and the sprites are its sub-rectangles,
+  trimmed down to their visible pixels.
+  */
   struct ActorInfo {
     String<> name;
-    render::Texture sheet;
-    Array<render::TexCoord> sprites;
+    Array<AtlasCell> sprites;
   };
   Array<ActorInfo> mActors;
 
@@ -108,11 +171,18 @@ class StorySceneSubState final: public SubState {
 
       info.name = actor.name;
 
-      mData.game.bundle.nqTexture(actor.sheet, info.sheet);
+      // the cells of atlased sheets were laid out when the game was built
+      const auto *sheet = mData.game.atlas.find(actor.sheet, actor.sheetSize);
+      if(sheet != nullptr) {
+        info.sprites = {sheet->cells.size()};
+        std::copy(sheet->cells.begin(), sheet->cells.end(), info.sprites.begin());
+        continue;
+      }
+
       usize spriteCount = usize(actor.sheetSize.x) *  usize(actor.sheetSize.y);
       info.sprites = {spriteCount};
       for(usize j = 0; j < spriteCount; ++j) {
-        info.sprites[j] = {
+        info.sprites[j].texCoord = {
           {
             f32(j % actor.sheetSize.x) / f32(actor.sheetSize.x),
             f32(s32(j / actor.sheetSize.x)) / f32(actor.sheetSize.y)
@@ -126,33 +196,57 @@ class StorySceneSubState final: public SubState {
     }
   }
 
-  const ActorInfo *mCurrentActor = nullptr; // only matters if !mCurrentText.empty()
+  SpriteLayer mSprites;
+
+  void spriteCmd(const SpriteCommand &cmd) {
+    if(cmd.actor == cNoSymbol) {
+      mSprites.apply(cmd, {}, {});
+      return;
+    }
+    const auto &sprites = mActors[cmd.actor].sprites;
+    mSprites.apply(cmd, {sprites.data(), sprites.size()},
+      mPrefetcher.sheet(cmd.actor));
+  }
+
+  /*
+  The name & line are laid out once when the line is spoken, & each page of the
+  line is drawn once when it's shown. Revealing the page only uncovers more of
+  what was drawn.
+  */
+  const ActorInfo *mCurrentActor = nullptr; // only matters if there's text
+  SharedTexture mCurrentSheet;
   usize mActorPortrait = 0;
-  StringView mCurrentText;
-  usize mTextChars = 0;
-  f32 mTextTimer = 0.0f;
+  TextRun mCurrentName;
+  TextRun mCurrentText;
+  TextReveal mReveal;
+  usize mPageGlyph = 0; // -> first glyph of the page shown
+  usize mPageLine = 0;
+  u64 mPageKey = 0; // -> changes whenever the page shown does
+  // the name tag, text box & portrait, redrawn from render()
+  mutable CachedElement mTextBox;
+  mutable TextPage mTextPage;
 
   void speakCmd(const SpeakCommand &cmd) {
     mCurrentActor = nullptr;
-    if(!cmd.actor.empty()) {
-      for(const auto &actor: mActors) {
-        if(actor.name == cmd.actor) {
-          mCurrentActor = &actor;
-          break;
-        }
-      }
+    if(cmd.actor != cNoSymbol) {
+      // actor IDs index both the scene's actors and ours
+      mCurrentActor = &mActors[cmd.actor];
+      mCurrentSheet = mPrefetcher.sheet(cmd.actor);
+      mCurrentName = {*mData.font, mCurrentActor->name.view(), cActorNameTextHeight};
     }
     if(cmd.portrait >= 0) {
       mActorPortrait = cmd.portrait;
     }
-    mCurrentText = cmd.text;
-    mTextChars = 0;
-    mTextTimer = 0.0f;
+    mCurrentText = {*mData.font, cmd.text, cTextHeight};
+    mReveal.start(cmd.speed);
+    mPageGlyph = 0;
+    mPageLine = 0;
+    ++mPageKey;
+    wrapText();
+    mReveal.limit(pageEnd());
     mWaitForInput = true;
   }
 
-  static constexpr f32 cTextCharTime = 0.05f;
-
   static constexpr glm::vec4 cBgColor{0, 0, 0, 0.5f};
   static constexpr f32 cTextMargin = 0.01f;
   static constexpr f32 cBaseY = 0.7f;
@@ -169,20 +263,120 @@ class StorySceneSubState final: public SubState {
     0.05f, cActorNameBgPos.y + cActorNameBgHeight, 0.51f
   };
   static constexpr f32 cTextHeight = 0.05f;
+  static constexpr usize cTextLines = 3;
+  static constexpr f32 cTextLineHeight = cTextHeight + cTextMargin;
   static constexpr glm::vec2 cTextBgSize{
     1.0f,
-    4*cTextMargin + 3*cTextHeight
+    (cTextLines+1)*cTextMargin + cTextLines*cTextHeight
   };
   static constexpr glm::vec3 cTextPos{
     cTextBgPos.x+cTextMargin, cTextBgPos.y+cTextMargin, 0.5f
   };
   static constexpr f32 cActorPortraitEndX = 0.95f;
 
-  void renderTextBox() const {
-    auto name = mCurrentActor->name.view();
-    auto measure = mData.font.measure(name, cActorNameTextHeight);
+  /*
+  Lines are wrapped to the text box when spoken, & again whenever the box's
+  width in font units changes, i.e. when the window's aspect ratio does. A
+  rewrapped line stays on the page holding the first glyph shown before.
+  */
+  void wrapText() {
+    f32 width = m1x1.size({cTextBgSize.x - 2*cTextMargin, 0}).x;
+    if(!mCurrentText.wrap(*mData.font, width) || mCurrentText.lineCount() == 0) {
+      return;
+    }
+    mPageLine = 0;
+    while(mPageLine + cTextLines < mCurrentText.lineCount()
+      && mCurrentText.line(mPageLine + cTextLines).firstGlyph <= mPageGlyph)
+    {
+      mPageLine += cTextLines;
+    }
+    mPageGlyph = mCurrentText.line(mPageLine).firstGlyph;
+    ++mPageKey;
+  }
+
+  // Glyph after the last one of the page shown.
+  [[nodiscard]]
+  usize pageEnd() const {
+    usize lineEnd = std::min(mPageLine + cTextLines, mCurrentText.lineCount());
+    if(lineEnd == 0) {
+      return 0;
+    }
+    const auto &line = mCurrentText.line(lineEnd - 1);
+    return line.firstGlyph + line.glyphCount;
+  }
+
+  /*
+  Everything in the text box but the page being revealed only changes along
+  with the speaker, so it's cached. The cached rect reaches from the name tag
+  to the right edge of the screen & the bottom of the text box, which covers
+  the portrait, which is drawn into it once the sheet has loaded.
+  */
+  void renderTextBox(DrawList &list) const {
+    glm::vec3 boxPos = m4x3.pos(cActorNameBgPos);
+    glm::vec3 textBgPos = m4x3.pos(cTextBgPos);
+    glm::vec2 textBgSize = m1x1.size(cTextBgSize);
+    glm::vec2 boxSize{1 - boxPos.x, textBgPos.y + textBgSize.y - boxPos.y};
+    u64 key = CachedElement::key(mCurrentName.text());
+    key = CachedElement::key(reinterpret_cast<uintptr_t>(mCurrentActor), key);
+    key = CachedElement::key(u64(mActorPortrait), key);
+    bool sheetLoaded = mCurrentSheet.resident();
+    if(mCurrentSheet.present() && !sheetLoaded) {
+      // brings an evicted sheet back, the cached box doesn't touch it
+      mCurrentSheet.use();
+    }
+    key = CachedElement::key(u64(sheetLoaded), key);
+    if(mTextBox.begin(key, {boxPos.x, boxPos.y, textBgPos.z}, boxSize)) {
+      renderTextBoxChrome();
+      mTextBox.end();
+    }
+    mTextBox.draw(list);
+    renderPage(list);
+  }
+
+  /*
+  The page reaches from the first line to the bottom right of the text box, &
+  each line down to the next one, so no part of a glyph is left out.
+  */
+  void renderPage(DrawList &list) const {
+    glm::vec3 pagePos = m4x3.pos(cTextPos);
+    glm::vec3 textBgPos = m4x3.pos(cTextBgPos);
+    glm::vec2 textBgSize = m1x1.size(cTextBgSize);
+    glm::vec2 pageCorner{textBgPos.x + textBgSize.x, textBgPos.y + textBgSize.y};
+    usize lineEnd = std::min(mPageLine + cTextLines, mCurrentText.lineCount());
+    if(mTextPage.begin(mPageKey, pagePos, pageCorner - glm::vec2{pagePos.x, pagePos.y})) {
+      render::color();
+      for(usize i = mPageLine; i < lineEnd; ++i) {
+        const auto &line = mCurrentText.line(i);
+        glm::vec3 pos = cTextPos;
+        pos.y += f32(i - mPageLine) * cTextLineHeight;
+        renderText(mCurrentText.reveal(i, line.glyphCount), pos, cTextHeight);
+      }
+      mTextPage.end();
+    }
+
+    for(usize i = mPageLine; i < lineEnd; ++i) {
+      const auto &line = mCurrentText.line(i);
+      if(mReveal.revealed() <= line.firstGlyph) {
+        break;
+      }
+      usize revealed = mReveal.revealed() - line.firstGlyph;
+      f32 top = m4x3.pos({0, cTextPos.y + f32(i - mPageLine) * cTextLineHeight, 0}).y;
+      f32 bottom = i + 1 == lineEnd
+        ? pageCorner.y
+        : m4x3.pos({0, cTextPos.y + f32(i + 1 - mPageLine) * cTextLineHeight, 0}).y;
+      // a line shown in full keeps whatever its last glyph overhangs
+      f32 right = revealed >= line.glyphCount
+        ? pageCorner.x
+        : pagePos.x + mCurrentText.revealWidth(i, revealed);
+      mTextPage.reveal(i - mPageLine, top, bottom, right);
+    }
+    mTextPage.draw(list);
+  }
+
+  void renderTextBoxChrome() const {
+    auto name = mCurrentName.text();
     glm::vec2 nameBgSize{
-      measure.x + 2*cTextMargin, cActorNameBgHeight
+      mCurrentName.size().x + 2*cTextMargin, cActorNameBgHeight
     };
     render::color(cBgColor);
     render::rect(
@@ -200,15 +394,23 @@ class StorySceneSubState final: public SubState {
       1
     );
     renderText(name, cActorNameTextPos, cActorNameTextHeight);
-    renderText(mCurrentText.sub(0, mTextChars), cTextPos, cTextHeight);
 
+    // a portrait kept from an actor with a bigger sheet shows nothing
+    if(mActorPortrait >= mCurrentActor->sprites.size()) {
+      return;
+    }
+    const auto &portrait = mCurrentActor->sprites[mActorPortrait];
+    if(!mCurrentSheet.resident() || !portrait.visible()) {
+      return;
+    }
+    // trimmed portraits only cover part of the portrait's rect
     glm::vec3 actorPortraitPos = textBgPos + glm::vec3(textBgSize.x, 0, 0);
     glm::vec2 actorPortraitSize = m1x1.size({cTextBgSize.y, cTextBgSize.y});
     render::rect(
-      actorPortraitPos,
-      actorPortraitSize,
-      mCurrentActor->sheet,
-      mCurrentActor->sprites[mActorPortrait]
+      portrait.pos(actorPortraitPos, actorPortraitSize),
+      portrait.size(actorPortraitSize),
+      mCurrentSheet.use(),
+      portrait.texCoord
     );
   }
 
@@ -217,32 +419,58 @@ class StorySceneSubState final: public SubState {
   }
 
   constexpr inline void renderText(const StringView &text, glm::vec3 pos, f32 size) const {
-    mData.font.draw(text, m4x3.pos(pos), size);
+    mData.font->draw(text, m4x3.pos(pos), size);
   }
 
   usize mCommandOff = 0;
   bool mWaitForInput = false;
 
+  void advance(f32 delta) {
+    if(!mCurrentText.text().empty()) {
+      wrapText();
+      mReveal.limit(pageEnd());
+      if(!mReveal.finished()) {
+        mReveal.advance(delta);
+        redraw().invalidate();
+        return;
+      }
+    }
+    if(!mWaitForInput) {
+      nextCommand();
+    }
+  }
+
   void nextCommand() {
+    // every command changes what's on screen
+    redraw().invalidate();
     if(mCommandOff >= mStory.commands.size()) {
+      if(statsEnabled()) {
+        const auto &stats = mPrefetcher.stats();
+        console::print("Prefetch: {} hits, {} misses, {} requests",
+          stats.hits, stats.misses, stats.requests);
+        resources().printStats();
+        redraw().printStats();
+        drawList().printStats();
+      }
       popSubState();
       return;
     }
 
     mWaitForInput = false;
-    const auto &command = mStory.commands[mCommandOff++];
+    auto command = mStory.commands[mCommandOff++];
+    mPrefetcher.advance(mCommandOff);
     switch(command.code) {
     case CommandSprite:
-      console::warn("Sprite command not implemented.");
+      spriteCmd(mStory.sprite(command));
       break;
     case CommandSpeak:
-      speakCmd(*command.speak);
+      speakCmd(mStory.speak(command));
       break;
     case CommandWait:
       console::warn("Wait command not implemented.");
       break;
     case CommandBackground:
-      backgroundCmd(*command.background);
+      backgroundCmd(mStory.background(command));
       break;
     default:
       console::error("Unknown command.");
@@ -251,10 +479,23 @@ class StorySceneSubState final: public SubState {
   }
 
   KeyBind mBindNext{"story.next"_sv, Key::Space, [this]{
-    if(mWaitForInput && mTextChars >= mCurrentText.size()) {
-      mCurrentText = {};
-      nextCommand();
+    if(!mWaitForInput) {
+      return;
+    }
+    // the first press shows the rest of the page at once
+    if(!mReveal.finished()) {
+      mReveal.complete();
+      return;
+    }
+    if(mReveal.revealed() < mCurrentText.glyphCount()) {
+      mPageLine += cTextLines;
+      mPageGlyph = mCurrentText.line(mPageLine).firstGlyph;
+      ++mPageKey;
+      mReveal.limit(pageEnd());
+      return;
     }
+    mCurrentText = {};
+    nextCommand();
   }};
 };
 
@@ -0,0 +1,95 @@
+#include "SymbolTable.hpp"
+
+using namespace nwge;
+
+namespace sigmoid {
+
+static constexpr usize cMinBuckets = 16;
+
+static u32 hashName(const StringView &name) {
+  // FNV-1a
+  u32 hash = 2166136261U;
+  for(char chr: name) {
+    hash ^= u8(chr);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+SymbolID SymbolTable::intern(Arena &arena, const StringView &name) {
+  u32 hash = hashName(name);
+  SymbolID existing = find(name, hash);
+  if(existing != cNoSymbol) {
+    return existing;
+  }
+
+  // keep the load factor at or below 1/2
+  if(2 * (mNames.size() + 1) > mBuckets.size()) {
+    grow();
+  }
+  auto id = SymbolID(mNames.size());
+  mNames.push(arena.copy(name));
+  mHashes.push(hash);
+  usize mask = mBuckets.size() - 1;
+  usize idx = hash & mask;
+  while(mBuckets[idx] != cNoSymbol) {
+    idx = (idx + 1) & mask;
+  }
+  mBuckets[idx] = id;
+  return id;
+}
+
+SymbolID SymbolTable::find(const StringView &name) const {
+  return find(name, hashName(name));
+}
+
+SymbolID SymbolTable::find(const StringView &name, u32 hash) const {
+  if(mBuckets.empty()) {
+    return cNoSymbol;
+  }
+  usize mask = mBuckets.size() - 1;
+  for(usize idx = hash & mask;; idx = (idx + 1) & mask) {
+    SymbolID id = mBuckets[idx];
+    if(id == cNoSymbol) {
+      return cNoSymbol;
+    }
+    if(mHashes[id] == hash && mNames[id].equals(name)) {
+      return id;
+    }
+  }
+}
+
+StringView SymbolTable::name(SymbolID id) const {
+  if(id < 0 || usize(id) >= mNames.size()) {
+    return {};
+  }
+  return mNames[id];
+}
+
+usize SymbolTable::size() const {
+  return mNames.size();
+}
+
+void SymbolTable::clear() {
+  mNames.clear();
+  mHashes.clear();
+  mBuckets = {};
+}
+
+void SymbolTable::grow() {
+  usize count = mBuckets.empty() ? cMinBuckets : 2 * mBuckets.size();
+  mBuckets = {count};
+  for(auto &bucket: mBuckets) {
+    bucket = cNoSymbol;
+  }
+  usize mask = count - 1;
+  for(usize i = 0; i < mHashes.size(); ++i) {
+    usize idx = mHashes[i] & mask;
+    while(mBuckets[idx] != cNoSymbol) {
+      idx = (idx + 1) & mask;
+    }
+    mBuckets[idx] = SymbolID(i);
+  }
+}
+
+} // namespace sigmoid
@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+SymbolTable.hpp
+---------------
+Name interning
+*/
+
+#include "Arena.hpp"
+#include <nwge/common/array.hpp>
+#include <nwge/common/slice.hpp>
+#include <nwge/common/string.hpp>
+
+namespace sigmoid {
+
+using SymbolID = s32;
+static constexpr SymbolID cNoSymbol = -1;
+
+/**
+ * @brief Assigns dense integer IDs to names.
+ *
+ * IDs are handed out in order of first appearance, starting at 0, and stay
+ * stable until the table is cleared. Both directions are O(1): names are
+ * found through an open addressing hash table, and IDs index straight into
+ * the list of names. The names themselves are copied into an arena.
+ */
+class SymbolTable {
+public:
+  // Returns the ID of the name, adding it to the table if it's not there yet.
+  SymbolID intern(Arena &arena, const nwge::StringView &name);
+  // Returns the ID of the name, or `cNoSymbol` if it is not in the table.
+  [[nodiscard]]
+  SymbolID find(const nwge::StringView &name) const;
+  // Returns the name for an ID, or an empty string for `cNoSymbol`.
+  [[nodiscard]]
+  nwge::StringView name(SymbolID id) const;
+  [[nodiscard]]
+  usize size() const;
+  void clear();
+
+private:
+  nwge::Slice<nwge::StringView> mNames{4};
+  nwge::Slice<u32> mHashes{4};
+  nwge::Array<SymbolID> mBuckets;
+
+  [[nodiscard]]
+  SymbolID find(const nwge::StringView &name, u32 hash) const;
+  void grow();
+};
+
+} // namespace sigmoid
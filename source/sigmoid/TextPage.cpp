@@ -0,0 +1,77 @@
+#include "TextPage.hpp"
+#include "GL.hpp"
+
+using namespace nwge;
+
+namespace sigmoid {
+
+bool TextPage::begin(u64 key, glm::vec3 pos, glm::vec2 size) {
+  if(!mLayout.begin(key, pos, size)) {
+    return false;
+  }
+  mRevealedTo.clear();
+  return true;
+}
+
+void TextPage::end() {
+  mLayout.end();
+  clear();
+}
+
+void TextPage::clear() {
+  const auto &layout = mLayout.target();
+  if(!layout.valid() || !mRevealed.resize(layout.size())) {
+    mRevealed.destroy();
+    return;
+  }
+  GLint prevDraw = 0;
+  GLfloat prevClearColor[4]{};
+  gl().getIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+  gl().getFloatv(GL_COLOR_CLEAR_VALUE, prevClearColor);
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, mRevealed.framebuffer());
+  gl().clearColor(0, 0, 0, 0);
+  gl().clear(GL_COLOR_BUFFER_BIT);
+  gl().clearColor(prevClearColor[0], prevClearColor[1],
+    prevClearColor[2], prevClearColor[3]);
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(prevDraw));
+}
+
+/*
+Both textures have the page's top row first, so the revealed columns are
+copied over as they are.
+*/
+void TextPage::reveal(usize line, f32 top, f32 bottom, f32 right) {
+  const auto &layout = mLayout.target();
+  if(!layout.valid() || !mRevealed.valid()) {
+    return;
+  }
+  while(mRevealedTo.size() <= line) {
+    mRevealedTo.push(0);
+  }
+  s32 fromY = mLayout.pixel({0, top}).y;
+  glm::ivec2 to = mLayout.pixel({right, bottom});
+  s32 &revealedTo = mRevealedTo[line];
+  if(to.x <= revealedTo || to.y <= fromY) {
+    return;
+  }
+
+  GLint prevDraw = 0;
+  GLint prevRead = 0;
+  gl().getIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+  gl().getIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevRead);
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, layout.framebuffer());
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, mRevealed.framebuffer());
+  gl().blitFramebuffer(
+    revealedTo, fromY, to.x, to.y,
+    revealedTo, fromY, to.x, to.y,
+    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  gl().bindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(prevRead));
+  gl().bindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(prevDraw));
+  revealedTo = to.x;
+}
+
+void TextPage::draw(DrawList &list) const {
+  mLayout.draw(list, mRevealed);
+}
+
+} // namespace sigmoid
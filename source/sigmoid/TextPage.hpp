@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+TextPage.hpp
+------------
+A page of text drawn once & revealed without being drawn again
+*/
+
+#include "CachedElement.hpp"
+#include <nwge/common/slice.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief A page of text revealed a bit at a time.
+ *
+ * The whole page is drawn once, like a `CachedElement`, but kept out of sight.
+ * Revealing part of a line copies just the pixels newly revealed into a second
+ * texture, which is what's drawn, so each frame costs the same however much
+ * of the page is showing.
+ *
+ * ```cpp
+ * if(mPage.begin(key, pos, size)) {
+ *   // draw every line of the page
+ *   mPage.end();
+ * }
+ * mPage.reveal(line, top, bottom, right);
+ * mPage.draw(drawList());
+ * ```
+ */
+class TextPage {
+public:
+  /**
+   * @brief Starts drawing the page again, if it has to be.
+   *
+   * As `CachedElement::begin()`. A page drawn again starts out hidden.
+   */
+  bool begin(u64 key, glm::vec3 pos, glm::vec2 size);
+  void end();
+
+  /**
+   * @brief Reveals a line of the page.
+   *
+   * The line reaches from `top` to `bottom`, & is revealed from the left of
+   * the page up to `right`, all in frame coordinates. Parts already revealed
+   * stay so.
+   */
+  void reveal(usize line, f32 top, f32 bottom, f32 right);
+  // Draws what's revealed of the page at the depth of its rect.
+  void draw(DrawList &list) const;
+
+private:
+  CachedElement mLayout;
+  RenderTarget mRevealed;
+  nwge::Slice<s32> mRevealedTo{4}; // -> pixel each line is revealed up to
+
+  void clear();
+};
+
+} // namespace sigmoid
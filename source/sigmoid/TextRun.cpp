@@ -0,0 +1,187 @@
+#include "TextRun.hpp"
+#include <algorithm>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+// A glyph ends where the text does or where the next UTF-8 sequence starts.
+static inline bool glyphEnd(const StringView &text, usize offset) {
+  return offset == text.size() || (u8(text[offset]) & 0xC0) != 0x80;
+}
+
+TextRun::TextRun(const render::Font &font, const StringView &text, f32 height)
+  : mText(text),
+    mHeight(height),
+    mSize(font.measure(text, height))
+{
+  usize count = 0;
+  for(usize i = 1; i <= text.size(); ++i) {
+    count += glyphEnd(text, i) ? 1 : 0;
+  }
+  mGlyphEnds = {count};
+  usize glyph = 0;
+  for(usize i = 1; i <= text.size(); ++i) {
+    if(glyphEnd(text, i)) {
+      mGlyphEnds[glyph++] = u32(i);
+    }
+  }
+}
+
+/*
+Lines are filled word by word, a word being the glyphs up to & including the
+next space or line feed, and measured without the spaces they end in. Each
+measurement covers the line so far, so kerning between words is accounted for.
+*/
+bool TextRun::wrap(const render::Font &font, f32 width) {
+  if(width == mWrapWidth) {
+    return false;
+  }
+  mWrapWidth = width;
+  mLines.clear();
+
+  usize count = mGlyphEnds.size();
+  usize start = 0;
+  while(start < count) {
+    usize end = start;
+    while(end < count) {
+      usize wordEnd = end;
+      while(wordEnd < count && !breaksAfter(wordEnd)) {
+        ++wordEnd;
+      }
+      wordEnd = std::min(wordEnd + 1, count);
+
+      if(fits(font, start, wordEnd, width)) {
+        end = wordEnd;
+        if(text()[glyphStart(end - 1)] == '\n') {
+          break;
+        }
+        continue;
+      }
+      if(end == start) {
+        // the word doesn't fit on a line of its own
+        end = start + 1;
+        while(end < wordEnd && fits(font, start, end + 1, width)) {
+          ++end;
+        }
+      }
+      break;
+    }
+    mLines.push({start, end - start});
+    start = end;
+  }
+
+  // measured from the line's start, for the same kerning as when it's drawn
+  mGlyphRights = {count};
+  for(const auto &line: mLines) {
+    usize lineEnd = line.firstGlyph + line.glyphCount;
+    for(usize glyph = line.firstGlyph; glyph < lineEnd; ++glyph) {
+      mGlyphRights[glyph] = font.measure(glyphs(line.firstGlyph, glyph + 1), mHeight).x;
+    }
+  }
+  return true;
+}
+
+usize TextRun::glyphCount() const {
+  return mGlyphEnds.size();
+}
+
+glm::vec2 TextRun::size() const {
+  return mSize;
+}
+
+StringView TextRun::text() const {
+  return mText;
+}
+
+usize TextRun::lineCount() const {
+  return mLines.size();
+}
+
+const TextRun::Line &TextRun::line(usize line) const {
+  return mLines[line];
+}
+
+StringView TextRun::reveal(usize line, usize glyphs) const {
+  const auto &info = mLines[line];
+  usize end = info.firstGlyph + std::min(glyphs, info.glyphCount);
+  while(end > info.firstGlyph && breaksAfter(end - 1)) {
+    --end;
+  }
+  return this->glyphs(info.firstGlyph, end);
+}
+
+f32 TextRun::revealWidth(usize line, usize glyphs) const {
+  const auto &info = mLines[line];
+  usize count = std::min(glyphs, info.glyphCount);
+  if(count == 0) {
+    return 0.0f;
+  }
+  return mGlyphRights[info.firstGlyph + count - 1];
+}
+
+usize TextRun::glyphStart(usize glyph) const {
+  return glyph == 0 ? 0 : mGlyphEnds[glyph - 1];
+}
+
+bool TextRun::breaksAfter(usize glyph) const {
+  char chr = mText[glyphStart(glyph)];
+  return chr == ' ' || chr == '\n';
+}
+
+StringView TextRun::glyphs(usize first, usize end) const {
+  usize offset = glyphStart(first);
+  return StringView{mText.data() + offset, glyphStart(end) - offset};
+}
+
+bool TextRun::fits(const render::Font &font, usize first, usize end, f32 width) const {
+  while(end > first && breaksAfter(end - 1)) {
+    --end;
+  }
+  return font.measure(glyphs(first, end), mHeight).x <= width;
+}
+
+void TextReveal::start(f32 speed) {
+  mGlyphTime = 1.0f / (speed > 0 ? speed : cDefaultSpeed);
+  mTimer = 0.0f;
+  mRevealed = 0;
+  mLimit = 0;
+}
+
+void TextReveal::limit(usize glyphs) {
+  mLimit = glyphs;
+}
+
+/*
+Whatever time is left over after the last glyph due carries over to the next
+frame, except once the limit is reached, so the next page starts revealing
+from scratch.
+*/
+void TextReveal::advance(f32 delta) {
+  if(finished()) {
+    mTimer = 0.0f;
+    return;
+  }
+  mTimer += delta;
+  auto due = usize(mTimer / mGlyphTime);
+  mTimer -= f32(due) * mGlyphTime;
+  mRevealed = std::min(mRevealed + due, mLimit);
+  if(finished()) {
+    mTimer = 0.0f;
+  }
+}
+
+void TextReveal::complete() {
+  mRevealed = std::max(mRevealed, mLimit);
+  mTimer = 0.0f;
+}
+
+usize TextReveal::revealed() const {
+  return mRevealed;
+}
+
+bool TextReveal::finished() const {
+  return mRevealed >= mLimit;
+}
+
+} // namespace sigmoid
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+TextRun.hpp
+-----------
+Text laid out once & revealed glyph by glyph
+*/
+
+#include <nwge/common/array.hpp>
+#include <nwge/common/slice.hpp>
+#include <nwge/common/string.hpp>
+#include <nwge/render/Font.hpp>
+
+namespace sigmoid {
+
+/**
+ * @brief Text prepared for drawing.
+ *
+ * Everything about the text which doesn't change while it's on screen is
+ * worked out when the run is created: its size & where each glyph ends.
+ * Revealing part of the text is then a lookup instead of a walk over it, and
+ * is always cut at a glyph boundary, never within a UTF-8 sequence.
+ *
+ * Runs are broken into lines by `wrap()`, which keeps its line breaks until
+ * it's asked for a different width, & measures where each glyph ends on its
+ * line, so a partly revealed line can be cut off without being laid out.
+ */
+class TextRun {
+public:
+  // Glyphs of a line, including the spaces or line feed it was broken at.
+  struct Line {
+    usize firstGlyph = 0;
+    usize glyphCount = 0;
+  };
+
+  TextRun() = default;
+  TextRun(const nwge::render::Font &font, const nwge::StringView &text, f32 height);
+
+  /**
+   * @brief Breaks the text into lines no wider than `width`.
+   *
+   * Lines are broken at spaces, or within a word if it doesn't fit on a line
+   * by itself, and always at line feeds. Returns false if the run was already
+   * wrapped to `width`.
+   */
+  bool wrap(const nwge::render::Font &font, f32 width);
+
+  [[nodiscard]]
+  usize glyphCount() const;
+  [[nodiscard]]
+  glm::vec2 size() const;
+  [[nodiscard]]
+  nwge::StringView text() const;
+  [[nodiscard]]
+  usize lineCount() const;
+  [[nodiscard]]
+  const Line &line(usize line) const;
+  // Returns the text of the first `glyphs` glyphs of a line, without the
+  // spaces or line feed at its end.
+  [[nodiscard]]
+  nwge::StringView reveal(usize line, usize glyphs) const;
+  // Returns how wide the first `glyphs` glyphs of a line are drawn.
+  [[nodiscard]]
+  f32 revealWidth(usize line, usize glyphs) const;
+
+private:
+  nwge::StringView mText;
+  f32 mHeight = 0.0f;
+  glm::vec2 mSize{0, 0};
+  nwge::Array<u32> mGlyphEnds; // -> byte offset after each glyph
+  nwge::Array<f32> mGlyphRights; // -> where each glyph ends on its line
+  nwge::Slice<Line> mLines{4};
+  f32 mWrapWidth = -1.0f;
+
+  [[nodiscard]]
+  usize glyphStart(usize glyph) const;
+  [[nodiscard]]
+  bool breaksAfter(usize glyph) const;
+  [[nodiscard]]
+  nwge::StringView glyphs(usize first, usize end) const;
+  [[nodiscard]]
+  bool fits(const nwge::render::Font &font, usize first, usize end, f32 width) const;
+};
+
+/**
+ * @brief Reveals the glyphs of a run over time.
+ *
+ * Time is accumulated rather than counted in ticks, so a long frame reveals
+ * every glyph that was due during it & the speed doesn't depend on the frame
+ * rate. Revealing stops at a limit, such as the end of the page shown, until
+ * the limit is raised.
+ */
+class TextReveal {
+public:
+  static constexpr f32 cDefaultSpeed = 20.0f; // -> glyphs per second
+
+  // Starts over from the first glyph. A `speed` of 0 uses the default.
+  void start(f32 speed);
+  // Sets the number of glyphs revealing stops at.
+  void limit(usize glyphs);
+  // Advances by `delta` seconds.
+  void advance(f32 delta);
+  // Reveals everything up to the limit at once.
+  void complete();
+
+  [[nodiscard]]
+  usize revealed() const;
+  // Whether everything up to the limit is revealed, so there's nothing to do
+  // until it's raised.
+  [[nodiscard]]
+  bool finished() const;
+
+private:
+  f32 mGlyphTime = 1.0f / cDefaultSpeed;
+  f32 mTimer = 0.0f;
+  usize mRevealed = 0;
+  usize mLimit = 0;
+};
+
+} // namespace sigmoid
@@ -0,0 +1,153 @@
+#include "Tween.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+
+using namespace nwge;
+
+namespace sigmoid {
+
+static const std::array<StringView, EaseMax> cEasingNames{
+  "linear"_sv,
+  "in"_sv,
+  "out"_sv,
+  "in_out"_sv,
+};
+
+/*
+Every easing is `t + t(1-t)(a + b(2t-1))`: linear is t, in is t², out is
+1-(1-t)² & in-out is the smoothstep t²(3-2t).
+*/
+static constexpr std::array<std::array<f32, 2>, EaseMax> cEasingCoefficients{{
+  {0, 0},
+  {-1, 0},
+  {1, 0},
+  {0, 1},
+}};
+
+static constexpr usize cInitialCapacity = 16;
+
+bool easingFromName(const StringView &name, Easing &out) {
+  for(usize i = 0; i < cEasingNames.size(); ++i) {
+    if(name.equals(cEasingNames[i])) {
+      out = Easing(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+StringView easingName(Easing ease) {
+  return ease < EaseMax ? cEasingNames[ease] : cEasingNames[EaseLinear];
+}
+
+void Tweens::add(u32 target, f32 from, f32 to, f32 duration, Easing ease) {
+  cancel(target);
+  if(mCount == mTarget.size()) {
+    grow();
+  }
+  usize tween = mCount++;
+  mTarget[tween] = target;
+  mStart[tween] = from;
+  mEnd[tween] = to;
+  mElapsed[tween] = 0;
+  mDuration[tween] = std::max(duration, std::numeric_limits<f32>::min());
+  mEase[tween] = ease < EaseMax ? ease : EaseLinear;
+  mValue[tween] = from;
+}
+
+void Tweens::cancel(u32 target) {
+  for(usize i = 0; i < mCount; ++i) {
+    if(mTarget[i] == target) {
+      remove(i);
+      return;
+    }
+  }
+}
+
+void Tweens::clear() {
+  mCount = 0;
+}
+
+/*
+The first pass only reads & writes the tween arrays, so it vectorizes. The
+second writes the values out & compacts the arrays over the finished tweens,
+whose last value is exactly their end.
+*/
+void Tweens::update(f32 delta, const ArrayView<f32> &values) {
+  usize count = mCount;
+  f32 *elapsed = mElapsed.data();
+  const f32 *duration = mDuration.data();
+  const f32 *start = mStart.data();
+  const f32 *end = mEnd.data();
+  const u8 *ease = mEase.data();
+  f32 *value = mValue.data();
+  for(usize i = 0; i < count; ++i) {
+    elapsed[i] += delta;
+    f32 t = std::min(elapsed[i] / duration[i], 1.0f);
+    const auto &coefficients = cEasingCoefficients[ease[i]];
+    f32 eased = t + t*(1 - t)*(coefficients[0] + coefficients[1]*(2*t - 1));
+    value[i] = t >= 1 ? end[i] : start[i] + (end[i] - start[i])*eased;
+  }
+
+  usize kept = 0;
+  for(usize i = 0; i < count; ++i) {
+    if(mTarget[i] < values.size()) {
+      values[mTarget[i]] = value[i];
+    }
+    if(elapsed[i] >= duration[i]) {
+      continue;
+    }
+    if(kept != i) {
+      mTarget[kept] = mTarget[i];
+      mStart[kept] = mStart[i];
+      mEnd[kept] = mEnd[i];
+      mElapsed[kept] = mElapsed[i];
+      mDuration[kept] = mDuration[i];
+      mEase[kept] = mEase[i];
+      mValue[kept] = mValue[i];
+    }
+    ++kept;
+  }
+  mCount = kept;
+}
+
+usize Tweens::size() const {
+  return mCount;
+}
+
+bool Tweens::empty() const {
+  return mCount == 0;
+}
+
+template<typename T>
+static void growArray(Array<T> &array, usize capacity, usize count) {
+  Array<T> grown{capacity};
+  std::copy(array.begin(), array.begin() + count, grown.begin());
+  array = std::move(grown);
+}
+
+void Tweens::grow() {
+  usize capacity = std::max(cInitialCapacity, mTarget.size() * 2);
+  growArray(mTarget, capacity, mCount);
+  growArray(mStart, capacity, mCount);
+  growArray(mEnd, capacity, mCount);
+  growArray(mElapsed, capacity, mCount);
+  growArray(mDuration, capacity, mCount);
+  growArray(mEase, capacity, mCount);
+  growArray(mValue, capacity, mCount);
+}
+
+// The last tween takes the removed one's place.
+void Tweens::remove(usize tween) {
+  usize last = --mCount;
+  mTarget[tween] = mTarget[last];
+  mStart[tween] = mStart[last];
+  mEnd[tween] = mEnd[last];
+  mElapsed[tween] = mElapsed[last];
+  mDuration[tween] = mDuration[last];
+  mEase[tween] = mEase[last];
+  mValue[tween] = mValue[last];
+}
+
+} // namespace sigmoid
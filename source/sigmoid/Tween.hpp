@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+Tween.hpp
+---------
+Values moving over time
+*/
+
+#include <nwge/common/array.hpp>
+#include <nwge/common/string.hpp>
+
+namespace sigmoid {
+
+enum Easing: u8 {
+  EaseLinear,
+  EaseIn,    // -> starts slow
+  EaseOut,   // -> ends slow
+  EaseInOut, // -> starts & ends slow
+  EaseMax,
+};
+
+// Returns false if `name` isn't an easing.
+bool easingFromName(const nwge::StringView &name, Easing &out);
+nwge::StringView easingName(Easing ease);
+
+/**
+ * @brief A set of values moving from one number to another.
+ *
+ * Each tween moves one value, its target, which is an index into the values
+ * passed to `update()`. Tweens are kept in flat arrays, one per property, &
+ * every easing is the same formula with different coefficients, so updating
+ * them is one pass over the arrays without branching on the tween. Finished
+ * tweens are dropped together at the end of the update.
+ */
+class Tweens {
+public:
+  /**
+   * @brief Starts moving a value from `from` to `to` over `duration` seconds.
+   *
+   * Replaces any tween of the same target. The value is only written once the
+   * tweens are next updated.
+   */
+  void add(u32 target, f32 from, f32 to, f32 duration, Easing ease);
+  // Stops moving a value, leaving it where it is.
+  void cancel(u32 target);
+  void clear();
+  // Advances all tweens by `delta` seconds, writing their values.
+  void update(f32 delta, const nwge::ArrayView<f32> &values);
+
+  [[nodiscard]]
+  usize size() const;
+  [[nodiscard]]
+  bool empty() const;
+
+private:
+  usize mCount = 0;
+  nwge::Array<u32> mTarget;
+  nwge::Array<f32> mStart;
+  nwge::Array<f32> mEnd;
+  nwge::Array<f32> mElapsed;
+  nwge::Array<f32> mDuration;
+  nwge::Array<u8> mEase;
+  nwge::Array<f32> mValue; // -> written by the update pass, then scattered
+
+  void grow();
+  void remove(usize tween);
+};
+
+} // namespace sigmoid
@@ -21,6 +21,13 @@ s32 main(s32 argc, CStr *argv) {
   );
   ImGui::SetCurrentContext(reinterpret_cast<ImGuiContext*>(guiContext()));
 
+  if(cli::flag("bench")) {
+    startPtr(benchmark(), {
+      .appName = "Sigmoid Engine Benchmark"_sv,
+    });
+    return 0;
+  }
+
   if(cli::posC() < 1) {
     dialog::error("Failure"_sv, "No game was specified."_sv);
     return 1;
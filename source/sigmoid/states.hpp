@@ -8,7 +8,9 @@ State functions
 
 #include "AssetManager.hpp"
 #include "Game.hpp"
+#include "ResourceCache.hpp"
 #include "Scene.hpp"
+#include "SceneChain.hpp"
 #include "SceneManager.hpp"
 #include <nwge/state.hpp>
 
@@ -26,10 +28,14 @@ nwge::State *gameMenu(Game &&game);
 //  * One for story scenes
 nwge::State *scene(Game &&game, const nwge::StringView &sceneName);
 
+// Runs the engine benchmarks & quits.
+nwge::State *benchmark();
+
 struct SceneStateData {
   Game &game;
   Scene &scene;
-  nwge::render::Font &font;
+  const SharedFont &font;
+  SceneChain &chain;
 };
 
 #if 0 // TODO